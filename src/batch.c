@@ -7,6 +7,7 @@
 //
 
 #include <time.h>
+#include <math.h>
 #include "prob.h"
 #include "cell.h"
 #include "soln.h"
@@ -15,21 +16,62 @@
 #include "utility.h"
 #include "log.h"
 #include "sdglobal.h"
+#include "batch.h"
+#include "cuts.h"
+#ifdef SD_unix
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 
-one_problem * new_batch_problem(one_problem * master, int max_cuts)
+/*
+ ** Writes the names of the columns (the eta column last) and rows of the
+ ** block of replication _batch_id_ into _cstore_ and _rstore_: those of
+ ** the master with the suffix _B and the id, in full.  The stores need
+ ** room for the master's names plus BATCH_SUFFIX characters a name, and
+ ** NAME_SIZE more for eta.
+ */
+void batch_block_names(one_problem *master, int batch_id, char *cstore,
+		string *cname, char *rstore, string *rname)
+{
+	char suffix[NAME_SIZE];
+	int i;
+
+	sprintf(suffix, "_B%d", batch_id);
+	for (i = 0; i < master->mac; i++)
+	{
+		cname[i] = cstore;
+		cstore += sprintf(cstore, "%s%s", master->cname[i], suffix) + 1;
+	}
+	cname[master->mac] = cstore;
+	sprintf(cstore, "eta%s", suffix);
+	for (i = 0; i < master->mar; i++)
+	{
+		rname[i] = rstore;
+		rstore += sprintf(rstore, "%s%s", master->rname[i], suffix) + 1;
+	}
+}
+
+/*
+ ** Creates the batch (compromise) problem with the block of replication
+ ** 0: a copy of the master followed by its eta column.  Each further
+ ** replication is appended as a block of its own by add_batch_rep(), so
+ ** replication i owns columns i*(mac+1) to i*(mac+1)+mac, its eta last,
+ ** and its master rows start at reps.batch_row[i], followed by its cuts.
+ ** Objective weights are 1 until finish_batch_problem() averages them.
+ */
+one_problem * new_batch_problem(one_problem * master)
 {
 	one_problem *copy;
-	int r, i, j, idx, cnt;
-	sd_long col_offset, row_offset, batch_col_offset, batch_row_offset; //modified by Yifan to avoid memory leaks July 26 2011
-	char batch_name[NAME_SIZE] =
-	{ "   " };
-	char *q;
+	int r, j, idx, cnt;
 
 #ifdef TRACE
 	printf("Inside new_batch_problem\n");
 #endif
 
-	if (!(copy = (one_problem *) mem_malloc (sizeof(one_problem))))
+	if (!(copy = (one_problem *) mem_malloc_in (MEM_SOLVER, sizeof(one_problem))))
 		err_msg("Allocation", "new_batch_problem", "copy");
 
 	/* Initialize unused fields in a master copy's CPLEX data. */
@@ -50,420 +92,327 @@ one_problem * new_batch_problem(one_problem * master, int max_cuts)
 	copy->rngname = NULL;
 	copy->bndname = NULL;
 
-	/* Initialize dimensions of copy based on master. */
-	copy->matsz = BATCH_SIZE * master->matsz
-			+ BATCH_SIZE * (max_cuts) * (master->mac + 1);
-	copy->marsz = BATCH_SIZE * master->mar + BATCH_SIZE * max_cuts;
-	copy->mar = BATCH_SIZE * master->mar;
-	copy->macsz = BATCH_SIZE * (master->mac + 1);
-	copy->mac = BATCH_SIZE * (master->mac + 1);
-	copy->cstorsz = BATCH_SIZE
-			* (master->cstorsz + BATCH_SUFFIX * master->mac + NAME_SIZE);
-	copy->rstorsz = BATCH_SIZE * (master->rstorsz + BATCH_SUFFIX * master->mar)
-			+ NAME_SIZE * (BATCH_SIZE * max_cuts);
+	/* Initialize dimensions of copy based on master: no room for cuts,
+	 which are added as rows of their own. */
+	copy->matsz = master->matsz;
+	copy->marsz = master->mar;
+	copy->mar = master->mar;
+	copy->macsz = master->mac + 1;
+	copy->mac = master->mac + 1;
+	copy->cstorsz = master->cstorsz + BATCH_SUFFIX * master->mac + NAME_SIZE;
+	copy->rstorsz = master->rstorsz + BATCH_SUFFIX * master->mar;
 	copy->objsen = master->objsen;
 
 	/* Make all allocations of known sizes, as calculated above */
-	if (!(copy->name = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->name = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "new_master", "copy->name");
-	if (!(copy->objname = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->objname = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "new_master", "copy->objname");
-	if (!(copy->objx = arr_alloc(copy->macsz, double)))
+	if (!(copy->objx = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->objx");
-	if (!(copy->bdl = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdl = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->bdl");
-	if (!(copy->bdu = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdu = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->bdu");
-	if (!(copy->rhsx = arr_alloc(copy->marsz, double)))
+	if (!(copy->rhsx = arr_alloc_in(MEM_SOLVER, copy->marsz, double)))
 		err_msg("Allocation", "new_master", "copy->rhsx");
-	if (!(copy->senx = arr_alloc(copy->marsz, char)))
+	if (!(copy->senx = arr_alloc_in(MEM_SOLVER, copy->marsz, char)))
 		err_msg("Allocation", "new_master", "copy->senx");
-	if (!(copy->matbeg = arr_alloc(copy->macsz, int)))
+	if (!(copy->matbeg = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "new_master", "copy->matbeg");
-	if (!(copy->matcnt = arr_alloc(copy->macsz, int)))
+	if (!(copy->matcnt = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "new_master", "copy->matcnt");
-	if (!(copy->cname = arr_alloc(copy->macsz, string)))
+	if (!(copy->cname = arr_alloc_in(MEM_SOLVER, copy->macsz, string)))
 		err_msg("Allocation", "new_master", "copy->cname");
-	if (!(copy->cstore = arr_alloc(copy->cstorsz, char)))
+	if (!(copy->cstore = arr_alloc_in(MEM_SOLVER, copy->cstorsz, char)))
 		err_msg("Allocation", "new_master", "copy->cstore");
-	if (!(copy->rname = arr_alloc(copy->marsz, string)))
+	if (!(copy->rname = arr_alloc_in(MEM_SOLVER, copy->marsz, string)))
 		err_msg("Allocation", "new_master", "copy->rname");
-	if (!(copy->rstore = arr_alloc(copy->rstorsz, char)))
+	if (!(copy->rstore = arr_alloc_in(MEM_SOLVER, copy->rstorsz, char)))
 		err_msg("Allocation", "new_master", "copy->rstore");
-	if (!(copy->matval = arr_alloc(copy->matsz, double)))
+	if (!(copy->matval = arr_alloc_in(MEM_SOLVER, copy->matsz, double)))
 		err_msg("Allocation", "new_master", "copy->matval");
-	if (!(copy->matind = arr_alloc(copy->matsz, int)))
+	if (!(copy->matind = arr_alloc_in(MEM_SOLVER, copy->matsz, int)))
 		err_msg("Allocation", "new_master", "copy->matind");
 
-	/*
-	 ** First copy information directly from the original master problem.
-	 */
-
-	/* Copy the master problem's column and row names */
-	/* Assume uninitialized elements are zero, or '\0', from calloc */
-	i = 0;
-	j = 0;
-
-	for (idx = 0; idx < BATCH_SIZE; idx++)
-	{
-		batch_name[0] = 'B';
-		batch_name[1] = '0' + idx / 10 % 10;
-		batch_name[2] = '0' + idx / 1 % 10;
-
-		for (q = master->cname[0]; q < master->cname[0] + master->cstorsz; q++)
-		{
-			if (*q == '\0')
-			{
-				copy->cstore[i++] = batch_name[0];
-				copy->cstore[i++] = batch_name[1];
-				copy->cstore[i++] = batch_name[2];
-			}
-			copy->cstore[i++] = *q;
-		}
-
-		for (q = master->rname[0]; q < master->rname[0] + master->rstorsz; q++)
-		{
-			if (*q == '\0')
-			{
-				copy->rstore[j++] = batch_name[0];
-				copy->rstore[j++] = batch_name[1];
-				copy->rstore[j++] = batch_name[2];
-			}
-			copy->rstore[j++] = *q;
-		}
-
-	}
-
+	batch_block_names(master, 0, copy->cstore, copy->cname, copy->rstore,
+			copy->rname);
 	strcpy(copy->name, "batch_mean");
 	strcpy(copy->objname, master->objname);
 
-	/* Calculate difference in pointers for master/copy row and column names */
-	col_offset = copy->cstore - master->cname[0];
-	row_offset = copy->rstore - master->rname[0];
-	batch_col_offset = master->cstorsz + BATCH_SUFFIX * master->mac;
-	batch_row_offset = master->rstorsz + BATCH_SUFFIX * master->mar;
-
 	/* Copy the all column information from the original master problem */
 	cnt = 0;
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (j = 0; j < master->mac; j++)
 	{
-		for (j = 0; j < master->mac; j++)
+		copy->objx[j] = master->objx[j];
+		copy->bdu[j] = master->bdu[j];
+		copy->bdl[j] = master->bdl[j];
+		copy->matbeg[j] = cnt;
+		copy->matcnt[j] = master->matcnt[j];
+		for (idx = master->matbeg[j];
+				idx < master->matbeg[j] + master->matcnt[j]; idx++)
 		{
-			copy->objx[i * master->mac + j] = (1.0 / BATCH_SIZE)
-					* master->objx[j];
-			copy->bdu[i * master->mac + j] = master->bdu[j];
-			copy->bdl[i * master->mac + j] = master->bdl[j];
-			copy->cname[i * master->mac + j] = master->cname[j]
-					+ BATCH_SUFFIX * j + col_offset + i * batch_col_offset;
-			copy->matbeg[i * master->mac + j] = cnt;
-			copy->matcnt[i * master->mac + j] = master->matcnt[j];
-			for (idx = master->matbeg[j];
-					idx < master->matbeg[j] + master->matcnt[j]; idx++)
-			{
-				copy->matval[cnt] = master->matval[idx];
-				copy->matind[cnt] = master->matind[idx] + i * master->mar;
-				cnt++;
-			}
-			/* This line of code is causing a issue in printing the Batch-Mean */
-			//cnt += BATCH_SIZE * max_cuts;
+			copy->matval[cnt] = master->matval[idx];
+			copy->matind[cnt] = master->matind[idx];
+			cnt++;
 		}
 	}
 
 	/* Copy all information concerning rows of master */
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (r = 0; r < master->mar; r++)
 	{
-		for (r = 0; r < master->mar; r++)
-		{
-			copy->rhsx[i * master->mar + r] = master->rhsx[r];
-			copy->senx[i * master->mar + r] = master->senx[r];
-			copy->rname[i * master->mar + r] = master->rname[r]
-					+ BATCH_SUFFIX * r + row_offset + i * batch_row_offset;
-		}
+		copy->rhsx[r] = master->rhsx[r];
+		copy->senx[r] = master->senx[r];
 	}
 
-	/*
-	 ** Initialize information for the extra columns in the new batch mean problem.
-	 */
-
-	for (i = 0; i < BATCH_SIZE; i++)
-	{
-		batch_name[0] = 'e';
-		batch_name[1] = 't';
-		batch_name[2] = 'a';
-		batch_name[3] = 'B';
-		batch_name[4] = '0' + i / 10 % 10;
-		batch_name[5] = '0' + i / 1 % 10;
-
-		/* Be careful! '7' means the size of batch_name here is 7. Yifan 2012-09-09*/
-		strcpy(copy->cstore + BATCH_SIZE * batch_col_offset + i * 7,
-				batch_name);
-		copy->cname[BATCH_SIZE * master->mac + i] = copy->cstore
-				+ BATCH_SIZE * batch_col_offset + i * 7;
-		copy->objx[BATCH_SIZE * master->mac + i] = (1.0 / BATCH_SIZE);
-		copy->bdu[BATCH_SIZE * master->mac + i] = INFBOUND;
-		copy->bdl[BATCH_SIZE * master->mac + i] = -INFBOUND;
-		copy->matbeg[BATCH_SIZE * master->mac + i] = cnt;
-		copy->matcnt[BATCH_SIZE * master->mac + i] = 0;
-		/* Be  careful! 0 means no cuts are added until now. Yifan 2012-09-09*/
-
-	}
+	/* The eta column, with no cuts added until now */
+	copy->objx[master->mac] = 1.0;
+	copy->bdu[master->mac] = INFBOUND;
+	copy->bdl[master->mac] = -INFBOUND;
+	copy->matbeg[master->mac] = cnt;
+	copy->matcnt[master->mac] = 0;
 
 	/* Load the copy into CPLEX now */
 	if (!(setup_problem(copy)))
 		err_msg("Problem Setup", "new_master", "copy");
 
-	/*write_prob(copy, "batch.lp");*//* added by Yifan to test batch.lp structure */
-
-	/*
-	 ** We're done, and we have room for max_cuts more constraints.
-	 */
-
 	return copy;
 }
 
-void add_cut_to_batch(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
-		cell_type *c, soln_type *s, int batch_id, int cut_position)
+/*
+ ** Appends the block of replication _batch_id_ to the batch problem: the
+ ** master rows, then the master columns and an eta column on them.  The
+ ** blocks must be added in replication order.  Returns the first row of
+ ** the block.
+ */
+int add_batch_block(sdglobal_type* sd_global, one_problem *master,
+		int batch_id)
 {
-	int beg_col; /* column where beta coefficients begin */
-	int end_col; /* column where beta coefficients finish */
-	int *coef_col; /* column number of each beta coefficient */
-	double *coef; /* used to store beta coefficient */
-	int cnt, i;
-	double rhs; /* rhs value in regularized QP method. */
-
-#ifdef TRACE
-	printf("Inside add_cut_to_batch\n");
-#endif
-
-	cut_position = p->num->mast_rows + cut_position;
-	/*
-	 ** Initialize an array to specify columns of each coefficient in
-	 ** beta.  The one-norm of beta is temporarily used as the coefficeint on
-	 ** eta (it is assumed to be replaced in the next step in solve_master()).
-	 */
-	beg_col = 0;
-	end_col = p->num->mast_cols;
-
-	/*
-	 ** Assign the column values for each element in the beta vector.
-	 ** The zeroth position will be set to the eta column, which will
-	 ** temporarily receive a coefficient equal to the 1-norm of beta.
-	 ** (or whatever is stored in beta[0])
-	 **
-	 ** This ought to be reworked... shouldn't have to alloc every time...
-	 */
-	if (!(coef_col = arr_alloc(p->num->mast_cols+1, int)))
-		err_msg("Allocation", "add_cut_to_batch", "coef_col");
-	if (!(coef = arr_alloc(p->num->mast_cols+1, double)))
-		err_msg("Allocation", "add_cut_to_batch", "coef");
-
-	for (cnt = 0; cnt < p->num->mast_cols; cnt++)
-		coef_col[cnt] = cnt + p->num->mast_cols * batch_id;
-	coef_col[p->num->mast_cols] = p->num->mast_cols * BATCH_SIZE + batch_id;
-
-#ifdef DEBUG
-	printf("Adding the row:\n");
-	print_vect(cut->beta, end_col - beg_col, "c->beta");
-#endif
-
-	/* 1. Get the coefficient beta */
-	for (i = 0; i <= p->num->mast_cols; i++)
+	one_problem *bp = sd_global->batch_problem;
+	int *cmatbeg, *cmatind;
+	double *obj, *lb, *ub, *cmatval;
+	char *cstore, *rstore;
+	string *cname, *rname;
+	int row, j, idx, cnt;
+
+	if (get_numcols(bp) != batch_id * (master->mac + 1))
+		err_msg("Order", "add_batch_block", "batch_id");
+	row = get_numrows(bp);
+
+	if (!(cmatbeg = arr_alloc(master->mac+2, int)))
+		err_msg("Allocation", "add_batch_block", "cmatbeg");
+	if (!(cmatind = arr_alloc(master->matsz+1, int)))
+		err_msg("Allocation", "add_batch_block", "cmatind");
+	if (!(cmatval = arr_alloc(master->matsz+1, double)))
+		err_msg("Allocation", "add_batch_block", "cmatval");
+	if (!(obj = arr_alloc(master->mac+1, double)))
+		err_msg("Allocation", "add_batch_block", "obj");
+	if (!(lb = arr_alloc(master->mac+1, double)))
+		err_msg("Allocation", "add_batch_block", "lb");
+	if (!(ub = arr_alloc(master->mac+1, double)))
+		err_msg("Allocation", "add_batch_block", "ub");
+	if (!(cname = arr_alloc(master->mac+1, string)))
+		err_msg("Allocation", "add_batch_block", "cname");
+	if (!(rname = arr_alloc(master->mar+1, string)))
+		err_msg("Allocation", "add_batch_block", "rname");
+	if (!(cstore = arr_alloc(master->cstorsz + BATCH_SUFFIX * master->mac
+			+ NAME_SIZE, char)))
+		err_msg("Allocation", "add_batch_block", "cstore");
+	if (!(rstore = arr_alloc(master->rstorsz + BATCH_SUFFIX * master->mar + 1,
+			char)))
+		err_msg("Allocation", "add_batch_block", "rstore");
+
+	batch_block_names(master, batch_id, cstore, cname, rstore, rname);
+
+	/* The master matrix, on this block's rows */
+	cnt = 0;
+	for (j = 0; j < master->mac; j++)
 	{
-		get_coef(c->master, cut_position, i, &coef[i]);
-		/* modified by Yifan 2013.02.15 */
-		//cut->beta[i+1] = coef[i];
+		cmatbeg[j] = cnt;
+		for (idx = master->matbeg[j];
+				idx < master->matbeg[j] + master->matcnt[j]; idx++)
+		{
+			cmatval[cnt] = master->matval[idx];
+			cmatind[cnt] = master->matind[idx] + row;
+			cnt++;
+		}
+		obj[j] = master->objx[j];
+		lb[j] = master->bdl[j];
+		ub[j] = master->bdu[j];
 	}
-
-	/* 2. Get the coefficient in front of eta i=p->num->mast_cols */
-
-	/* 3. Get the RHS of the cut */
-	get_rhs(c->master, &rhs, cut_position, cut_position);
-	/* modified by Yifan 2013.02.15 */
-	//cut->alpha_incumb = rhs;
-	if (!add_row_to_batch(sd_global->batch_problem, beg_col,
-			end_col - beg_col + 1, coef_col, coef, GE, rhs, batch_id))
-		err_msg("LP solver", "add_cut_to_bach", "ans");
-	/* THIS IS A SERIOUS PROBLEM, ROW_NUM IS NOT CORRECT, ONLY ONE CUT IN MASTER!!!*/
-	/* Yifan 03/11/2012 Be careful of this row number*/
-
-	mem_free(coef_col);
-	mem_free(coef);
-
-	/* Print all the cuts after adding a cut, for the purpose of cut index
-	 checking. zl
-	 
-	 print_cut_info(c, p->num, "After adding a cut");
-	 */
-#ifdef TRACE
-	printf("Exiting add_cut_to_batch\n");
-#endif
-
+	cmatbeg[master->mac] = cnt;
+	obj[master->mac] = 1.0;
+	lb[master->mac] = -INFBOUND;
+	ub[master->mac] = INFBOUND;
+
+	if (!add_block_to_batch(bp, master->mar, master->rhsx, master->senx,
+			rname, master->mac + 1, cnt, obj, cmatbeg, cmatind, cmatval, lb,
+			ub, cname))
+		err_msg("LP solver", "add_batch_block", "ans");
+
+	mem_free(cmatbeg);
+	mem_free(cmatind);
+	mem_free(cmatval);
+	mem_free(obj);
+	mem_free(lb);
+	mem_free(ub);
+	mem_free(cname);
+	mem_free(rname);
+	mem_free(cstore);
+	mem_free(rstore);
+
+	return row;
 }
 
-void add_fcut_to_batch(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
-		cell_type *c, soln_type *s, int batch_id, int iteration_num)
+/*
+ ** Returns the problem that holds the block of replication _batch_id_,
+ ** with the block's first row and column in _row_ and _col_: the batch
+ ** problem, or with BATCH_DECOMP the block's own problem.
+ */
+one_problem *batch_block(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		int *row, int *col)
 {
-	int beg_col; /* column where beta coefficients begin */
-	int end_col; /* column where beta coefficients finish */
-	int *coef_col; /* column number of each beta coefficient */
-	double *coef; /* used to store beta coefficient */
-	int cnt, i;
-	double rhs; /* rhs value in regularized QP method. */
-
-#ifdef TRACE
-	printf("Inside add_cut_to_batch\n");
-#endif
-
-	/*
-	 ** Initialize an array to specify columns of each coefficient in
-	 ** beta.  The one-norm of beta is temporarily used as the coefficeint on
-	 ** eta (it is assumed to be replaced in the next step in solve_master()).
-	 */
-	beg_col = 0;
-	end_col = p->num->mast_cols;
-
-	/*
-	 ** Assign the column values for each element in the beta vector.
-	 ** The zeroth position will be set to the eta column, which will
-	 ** temporarily receive a coefficient equal to the 1-norm of beta.
-	 ** (or whatever is stored in beta[0])
-	 **
-	 ** This ought to be reworked... shouldn't have to alloc every time...
-	 */
-	if (!(coef_col = arr_alloc(p->num->mast_cols+1, int)))
-		err_msg("Allocation", "add_cut_to_batch", "coef_col");
-	if (!(coef = arr_alloc(p->num->mast_cols+1, double)))
-		err_msg("Allocation", "add_cut_to_batch", "coef");
+	if (sd_global->config.BATCH_DECOMP)
+	{
+		*row = *col = 0;
+		return sd_global->reps.block[batch_id];
+	}
+	*row = sd_global->reps.batch_row[batch_id];
+	*col = batch_id * (p->num->mast_cols + 1);
+	return sd_global->batch_problem;
+}
 
-	for (cnt = 0; cnt < p->num->mast_cols; cnt++)
-		coef_col[cnt] = cnt + p->num->mast_cols * batch_id;
-	coef_col[p->num->mast_cols] = p->num->mast_cols * BATCH_SIZE + batch_id;
+/*
+ ** Fills _coef_ (mast_cols+1 entries, the last one on eta) with the
+ ** batch row of a cut and returns its rhs.
+ **
+ ** The row is rebuilt from the cut itself rather than read back from
+ ** the master, whose eta column holds zeta = k * (eta - shift) and
+ ** whose cut rows are no longer contiguous.  In terms of eta an
+ ** optimality cut reads
+ **
+ **   Beta x X + (k/cut_obs) eta >= alpha_incumb + (k/cut_obs - 1) shift
+ **
+ ** while a feasibility cut keeps its beta[0] coefficient on eta.
+ */
+double batch_cut_row(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
+		cell_type *c, soln_type *s, BOOL fea_cut, double *coef)
+{
+	int cnt;
+	double rhs;
 
 #ifdef DEBUG
 	printf("Adding the row:\n");
-	print_vect(cut->beta, end_col - beg_col, "c->beta");
+	print_vect(cut->beta, p->num->mast_cols, "c->beta");
 #endif
 
-	/* 1. Get the coefficient beta */
-	for (i = 0; i < p->num->mast_cols; i++)
+	for (cnt = 0; cnt < p->num->mast_cols; cnt++)
+		coef[cnt] = cut->beta[cnt + 1];
+
+	if (fea_cut)
+	{
+		coef[p->num->mast_cols] = cut->beta[0];
+		if (sd_global->config.MASTER_TYPE == SDLP)
+			rhs = cut->alpha;
+		else
+			rhs = cut->alpha - CxX(cut->beta, s->incumb_x, p->num->mast_cols)
+					+ sd_global->config.FEA_TOLER;
+	}
+	else
 	{
-		coef[i] = cut->beta[i + 1];
+		coef[p->num->mast_cols] = (double) c->k / (double) cut->cut_obs;
+		rhs = cut->alpha_incumb
+				+ (coef[p->num->mast_cols] - 1.0) * c->eta_shift;
 	}
 
-	/* 2. Get the coefficient in front of eta i=p->num->mast_cols This value is 0 for fcut */
+	return rhs;
+}
 
-	/* 3. Get the RHS of the cut */
-	rhs = cut->alpha
-			- CxX(cut->beta, sd_global->batch_incumb->incumb_x[batch_id],
-					p->num->mast_cols);
-	rhs += sd_global->config.FEA_TOLER;
+/*
+ ** Adds the _nzcnt_ nonzeros of a row built by batch_cut_row() to the
+ ** batch problem, on the block of replication _batch_id_.  _ind_ holds
+ ** their master columns, mast_cols standing for eta.
+ */
+void add_batch_row(sdglobal_type* sd_global, prob_type *p, int nzcnt,
+		int *ind, double *val, double rhs, int batch_id)
+{
+	one_problem *bp;
+	int *coef_col; /* column number of each beta coefficient */
+	int cnt, row, col;
 
-	/* modified by Yifan 2013.02.15 */
+	if (!(coef_col = arr_alloc(nzcnt+1, int)))
+		err_msg("Allocation", "add_batch_row", "coef_col");
+
+	bp = batch_block(sd_global, p, batch_id, &row, &col);
+	for (cnt = 0; cnt < nzcnt; cnt++)
+		coef_col[cnt] = ind[cnt] + col;
 
-	if (!add_row_to_batch(sd_global->batch_problem, beg_col,
-			end_col - beg_col + 1, coef_col, coef, GE, rhs, batch_id))
+	if (!add_row_to_batch(bp, 0, nzcnt, coef_col, val, GE, rhs, batch_id))
 		err_msg("LP solver", "add_cut_to_bach", "ans");
-	/* THIS IS A SERIOUS PROBLEM, ROW_NUM IS NOT CORRECT, ONLY ONE CUT IN MASTER!!!*/
-	/* Yifan 03/11/2012 Be careful of this row number*/
 
 	mem_free(coef_col);
-	mem_free(coef);
-
-	/* Print all the cuts after adding a cut, for the purpose of cut index
-	 checking. zl
-	 
-	 print_cut_info(c, p->num, "After adding a cut");
-	 */
-#ifdef TRACE
-	printf("Exiting add_cut_to_batch\n");
-#endif
-
 }
 
-void update_batch_rhs(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int batch_id)
+/* Copies the master rhs _rhs_ of replication _batch_id_ into the batch problem. */
+void set_batch_rhs(sdglobal_type* sd_global, prob_type *p, double *rhs,
+		int batch_id)
 {
-
-	int cnt;
-	double *rhs;
+	one_problem *bp;
+	int cnt, row, col;
 	int *indices;
 
-#ifdef TRACE
-	printf("Inside update_batch_rhs\n");
-#endif
-
-	if (!(rhs = arr_alloc(p->num->mast_rows, double)))
-		err_msg("Allocation", "change_rhs", "rhs");
 	if (!(indices = arr_alloc(p->num->mast_rows, int)))
 		err_msg("Allocation", "change_rhs", "indices");
 
+	bp = batch_block(sd_global, p, batch_id, &row, &col);
 	for (cnt = 0; cnt < p->num->mast_rows; cnt++)
-	{
-		get_rhs(c->master, &rhs[cnt], cnt, cnt);
-		indices[cnt] = p->num->mast_rows * batch_id + cnt;
-	}
+		indices[cnt] = row + cnt;
 
 	/* Now we change the rhs of the master problem. */
-	change_rhside(sd_global->batch_problem, p->num->mast_rows, indices, rhs);
-	mem_free(rhs);
+	change_rhside(bp, p->num->mast_rows, indices, rhs);
 	mem_free(indices);
-
-#ifdef TRACE
-	printf("Exiting update_batch_rhs\n");
-#endif
-
 }
 
-void update_batch_bounds(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int batch_id)
+/* Copies the master bounds of replication _batch_id_ into the batch problem. */
+void set_batch_bounds(sdglobal_type* sd_global, prob_type *p, double *lbounds,
+		double *ubounds, int batch_id)
 {
+	one_problem *bp;
 	int status = 0;
-	int cnt;
-	double *lbounds;
-	double *ubounds;
+	int cnt, row, col;
 	int *lindices;
 	int *uindices;
 	char *llu;
 	char *ulu;
-#ifdef TRACE
-	printf("Inside update_batch_bounds\n");
-#endif
-	if (!(lbounds = arr_alloc(p->num->mast_cols+1, double)))
-		err_msg("Allocation", "change_bounds", "lbounds");
+
 	if (!(lindices = arr_alloc(p->num->mast_cols+1, int)))
 		err_msg("Allocation", "change_bounds", "lindices");
 	if (!(llu = arr_alloc(p->num->mast_cols+1, char)))
 		err_msg("Allocation", "change_bounds", "llu");
-
-	if (!(ubounds = arr_alloc(p->num->mast_cols+1, double)))
-		err_msg("Allocation", "change_bounds", "ubounds");
 	if (!(uindices = arr_alloc(p->num->mast_cols+1, int)))
 		err_msg("Allocation", "change_bounds", "uindices");
 	if (!(ulu = arr_alloc(p->num->mast_cols+1, char)))
 		err_msg("Allocation", "change_bounds", "ulu");
 
-	get_lbound(c->master, lbounds, 0, p->num->mast_cols);
-	get_ubound(c->master, ubounds, 0, p->num->mast_cols);
+	bp = batch_block(sd_global, p, batch_id, &row, &col);
 
 	/* Change the Upper Bound */
 	for (cnt = 0; cnt < p->num->mast_cols; cnt++)
 	{
-		uindices[cnt] = cnt + batch_id * p->num->mast_cols;
+		uindices[cnt] = cnt + col;
 		ulu[cnt] = 'U';
 	}
 
-	status = change_bound(sd_global->batch_problem, p->num->mast_cols, uindices,
-			ulu, ubounds);
+	status = change_bound(bp, p->num->mast_cols, uindices, ulu, ubounds);
 
 	/* Change the Lower Bound */
 	for (cnt = 0; cnt < p->num->mast_cols; cnt++)
 	{
-		lindices[cnt] = cnt + batch_id * p->num->mast_cols;
+		lindices[cnt] = cnt + col;
 		llu[cnt] = 'L';
 	}
 
-	status = change_bound(sd_global->batch_problem, p->num->mast_cols, lindices,
-			llu, lbounds);
+	status = change_bound(bp, p->num->mast_cols, lindices, llu, lbounds);
 
 	if (status)
 	{
@@ -471,16 +420,10 @@ void update_batch_bounds(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		exit(1);
 	}
 
-	mem_free(lbounds);
 	mem_free(lindices);
 	mem_free(llu);
-	mem_free(ubounds);
 	mem_free(uindices);
 	mem_free(ulu);
-
-#ifdef TRACE
-	printf("Exiting update_batch_bounds\n");
-#endif
 }
 
 batch_incumb_type * new_batch_incumb(sdglobal_type* sd_global, prob_type *p,
@@ -494,10 +437,10 @@ batch_incumb_type * new_batch_incumb(sdglobal_type* sd_global, prob_type *p,
 		err_msg("Allocation", "new_batch_incumb", "batch_incumb");
 
 	if (!(sd_global->batch_incumb->incumb_x =
-			(vector *) mem_calloc (BATCH_SIZE, sizeof(vector))))
+			(vector *) mem_calloc (sd_global->reps.max, sizeof(vector))))
 		err_msg("Allocation", "incumb_x", "batch_incumb");
 
-	for (idx = 0; idx < BATCH_SIZE; idx++)
+	for (idx = 0; idx < sd_global->reps.max; idx++)
 	{
 		sd_global->batch_incumb->incumb_x[idx] = duplic_arr(x_k,
 				p->num->mast_cols);
@@ -505,17 +448,17 @@ batch_incumb_type * new_batch_incumb(sdglobal_type* sd_global, prob_type *p,
 
 	/* modified by Yifan 2012.10.05 */
 	if (!(sd_global->batch_incumb->R_Master_pi =
-			(vector *) mem_calloc (BATCH_SIZE, sizeof(vector))))
+			(vector *) mem_calloc (sd_global->reps.max, sizeof(vector))))
 		err_msg("Allocation", "new_soln", "Batch_pi");
-	for (idx = 0; idx < BATCH_SIZE; idx++)
+	for (idx = 0; idx < sd_global->reps.max; idx++)
 	{
 		sd_global->batch_incumb->R_Master_pi[idx] =
 				arr_alloc(p->num->mast_rows+p->num->max_cuts+1,double);
 	}
 	if (!(sd_global->batch_incumb->R_Master_dj =
-			(vector *) mem_calloc (BATCH_SIZE, sizeof(vector))))
+			(vector *) mem_calloc (sd_global->reps.max, sizeof(vector))))
 		err_msg("Allocation", "new_soln", "Batch_pi");
-	for (idx = 0; idx < BATCH_SIZE; idx++)
+	for (idx = 0; idx < sd_global->reps.max; idx++)
 	{
 		sd_global->batch_incumb->R_Master_dj[idx] =
 				arr_alloc(p->num->mast_cols+2,double);
@@ -524,14 +467,15 @@ batch_incumb_type * new_batch_incumb(sdglobal_type* sd_global, prob_type *p,
 	return sd_global->batch_incumb;
 }
 
-void save_batch_incumb(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int batch_id)
+/* Records _x_ as the incumbent of replication _batch_id_ and appends it to incumb.out. */
+void store_batch_incumb(sdglobal_type* sd_global, prob_type *p, vector x,
+		int batch_id)
 {
 	FILE *bat;
 	int idx;
 	for (idx = 0; idx <= p->num->mast_cols; idx++)
 	{
-		sd_global->batch_incumb->incumb_x[batch_id][idx] = s->incumb_x[idx];
+		sd_global->batch_incumb->incumb_x[batch_id][idx] = x[idx];
 	}
 	bat = fopen("incumb.out", "a");
 
@@ -578,12 +522,12 @@ void add_batch_equality(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	if (!(coef = arr_alloc(2, double)))
 		err_msg("Allocation", "add_cut_to_batch", "coef");
 
-	for (i = 0; i < BATCH_SIZE - 1; i++)
+	for (i = 0; i < sd_global->reps.num - 1; i++)
 	{
 		for (j = 0; j < p->num->mast_cols; j++)
 		{
-			coef_col[0] = i * p->num->mast_cols + j;
-			coef_col[1] = i * p->num->mast_cols + j + p->num->mast_cols;
+			coef_col[0] = i * (p->num->mast_cols + 1) + j;
+			coef_col[1] = (i + 1) * (p->num->mast_cols + 1) + j;
 			coef[0] = 1.0;
 			coef[1] = -1.0;
 			rhs = sd_global->batch_incumb->incumb_x[i + 1][j + 1]
@@ -607,30 +551,30 @@ void add_batch_equality(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 }
 
 BOOL get_beta_x(sdglobal_type* sd_global, soln_type *s, vector Beta,
-		one_problem *p, num_type *num, int length)
+		prob_type *prob, num_type *num, int length)
 {
 #ifdef TRACE
 	printf("Inside get_beta\n");
 #endif
 
 	int i, j, k;
-	int row, col, mast_rows;
+	int row, col, cuts, row0, col0;
 	double alpha, dual;
+	one_problem *p;
 
-	mast_rows = BATCH_SIZE * num->mast_rows;
-
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (i = 0; i < sd_global->reps.num; i++)
 	{
-
-		for (j = 0; j < num->max_cuts; j++)
+		p = batch_block(sd_global, prob, i, &row0, &col0);
+		cuts = min(sd_global->reps.batch_cuts[i], num->max_cuts);
+		for (j = 0; j < cuts; j++)
 		{
-			dual = s->Batch_pi[i][num->mast_rows + j + 1] * BATCH_SIZE;
+			dual = s->Batch_pi[i][num->mast_rows + j + 1] * sd_global->reps.num;
 			if (dual > sd_global->config.TOLERANCE)
 			{
-				row = mast_rows + i * num->max_cuts + j;
+				row = row0 + num->mast_rows + j;
 				for (k = 0; k < num->mast_cols; k++)
 				{
-					col = i * num->mast_cols + k;
+					col = col0 + k;
 					get_coef(p, row, col, &Beta[k + 1]);
 				}
 				get_rhs(p, &alpha, row, row);
@@ -650,3 +594,738 @@ BOOL get_beta_x(sdglobal_type* sd_global, soln_type *s, vector Beta,
 	return TRUE;
 }
 
+/*
+ ** Sets up the replication bookkeeping: at most MAX_REPS replications
+ ** (one without MULTIPLE_REP), and the workers from REP_WORKERS.
+ ** Replication 2, where OVERRIDE may stop the run, always stays in this
+ ** process.  _dir_ is the output folder that holds the workers' repNN
+ ** folders.
+ */
+void init_rep_pool(sdglobal_type* sd_global, char *dir)
+{
+	sd_global->reps.max = 1;
+	sd_global->reps.workers = 1;
+	if (sd_global->config.MULTIPLE_REP == 1)
+	{
+		sd_global->reps.max = max(1, sd_global->config.MAX_REPS);
+		sd_global->reps.workers = sd_global->config.REP_WORKERS;
+	}
+#ifndef SD_unix
+	sd_global->reps.workers = 1;
+#endif
+
+	sd_global->reps.running = 0;
+	sd_global->reps.child = FALSE;
+	sd_global->reps.dir = dir;
+	if (!(sd_global->reps.pid = arr_alloc(sd_global->reps.max, pid_t)))
+		err_msg("Allocation", "init_rep_pool", "pid");
+	if (!(sd_global->reps.batch_row = arr_alloc(sd_global->reps.max, int)))
+		err_msg("Allocation", "init_rep_pool", "batch_row");
+	if (!(sd_global->reps.batch_cuts = arr_alloc(sd_global->reps.max, int)))
+		err_msg("Allocation", "init_rep_pool", "batch_cuts");
+	if (!(sd_global->reps.block = arr_alloc(sd_global->reps.max, one_problem *)))
+		err_msg("Allocation", "init_rep_pool", "block");
+}
+
+void free_rep_pool(sdglobal_type* sd_global)
+{
+	int i;
+
+	for (i = 0; i < sd_global->reps.max; i++)
+		if (sd_global->reps.block[i] != NULL)
+			free_one_prob(sd_global->reps.block[i]);
+	mem_free(sd_global->reps.block);
+	mem_free(sd_global->reps.batch_row);
+	mem_free(sd_global->reps.batch_cuts);
+	mem_free(sd_global->reps.pid);
+}
+
+/* TRUE if replication _batch_id_ is to be solved by this process. */
+BOOL rep_in_process(sdglobal_type* sd_global, int batch_id)
+{
+	return sd_global->reps.workers <= 1 || sd_global->reps.child
+			|| batch_id == 2;
+}
+
+/*
+ ** Allocates what the replications of a problem record for the batch
+ ** problem, sized for the most replications the run may take.  The batch
+ ** problem itself grows by a block as each replication is recorded.
+ */
+void init_batch_data(sdglobal_type* sd_global, prob_type *p, vector x_k)
+{
+	int idx;
+
+	sd_global->reps.started = 0;
+	sd_global->reps.next = 0;
+	sd_global->reps.num = 0;
+	sd_global->reps.stop = FALSE;
+	for (idx = 0; idx < sd_global->reps.max; idx++)
+		sd_global->reps.pid[idx] = -1;
+
+	sd_global->batch_problem = NULL;
+	new_batch_incumb(sd_global, p, x_k);
+
+	/* The cuts of every replication outlive its cell, in the records below */
+	sd_global->cut_slab = new_cut_slab(p->num->mast_cols, p->num->max_cuts);
+
+	/* modified by Yifan 2013.02.15 */
+	sd_global->bcuts = new_bcuts(p, sd_global->reps.max, sd_global->bcuts);
+	/* modified by Yifan 2013.05.05 */
+	sd_global->bfcuts = new_bcuts(p, sd_global->reps.max, sd_global->bfcuts);
+	sd_global->bfcuts_pool = new_bcuts(p, sd_global->reps.max,
+			sd_global->bfcuts_pool);
+
+	sd_global->quad_v = arr_alloc(sd_global->reps.max, double);
+	/* modified by Yifan 2012.10.05 */
+	sd_global->Obj_lb = arr_alloc(sd_global->reps.max, double);
+	sd_global->ck = arr_alloc(sd_global->reps.max, double);
+}
+
+/* Returns cut _i_ of cell _c_, the feasibility cuts following the others. */
+one_cut *batch_share_cut(cell_type *c, int i, BOOL *fea_cut)
+{
+	*fea_cut = i >= c->cuts->cnt;
+	if (*fea_cut)
+		return c->feasible_cuts_added->val[i - c->cuts->cnt];
+	return c->cuts->val[i];
+}
+
+/*
+ ** Takes what a finished replication adds to the batch problem from its
+ ** cell: the rhs and bounds of its master and the batch row of every
+ ** optimality and feasibility cut, keeping only the nonzeros of each.
+ */
+batch_share_type *new_batch_share(sdglobal_type* sd_global, prob_type *p,
+		cell_type *c, soln_type *s)
+{
+	batch_share_type *share;
+	one_cut *cut;
+	double *coef;
+	BOOL fea_cut;
+	int i, cnt, nz;
+
+	if (!(share = (batch_share_type *) mem_malloc (sizeof(batch_share_type))))
+		err_msg("Allocation", "new_batch_share", "share");
+	share->rows = c->cuts->cnt + c->feasible_cuts_added->cnt;
+	share->rhs = arr_alloc(p->num->mast_rows+1, double);
+	share->lb = arr_alloc(p->num->mast_cols+1, double);
+	share->ub = arr_alloc(p->num->mast_cols+1, double);
+	share->beg = arr_alloc(share->rows+1, int);
+	share->coef_rhs = arr_alloc(share->rows+1, double);
+	coef = arr_alloc(p->num->mast_cols+1, double);
+	if (!share->rhs || !share->lb || !share->ub || !share->beg
+			|| !share->coef_rhs || !coef)
+		err_msg("Allocation", "new_batch_share", "share");
+
+	for (i = 0; i < p->num->mast_rows; i++)
+		get_rhs(c->master, &share->rhs[i], i, i);
+	get_lbound(c->master, share->lb, 0, p->num->mast_cols);
+	get_ubound(c->master, share->ub, 0, p->num->mast_cols);
+
+	/* Count the nonzeros first, so the rows take no more than they need */
+	nz = 0;
+	for (i = 0; i < share->rows; i++)
+	{
+		cut = batch_share_cut(c, i, &fea_cut);
+		share->coef_rhs[i] = batch_cut_row(sd_global, cut, p, c, s, fea_cut,
+				coef);
+		for (cnt = 0; cnt <= p->num->mast_cols; cnt++)
+			if (coef[cnt] != 0.0)
+				nz++;
+	}
+	share->ind = arr_alloc(nz+1, int);
+	share->val = arr_alloc(nz+1, double);
+	if (!share->ind || !share->val)
+		err_msg("Allocation", "new_batch_share", "share");
+
+	nz = 0;
+	for (i = 0; i < share->rows; i++)
+	{
+		share->beg[i] = nz;
+		cut = batch_share_cut(c, i, &fea_cut);
+		batch_cut_row(sd_global, cut, p, c, s, fea_cut, coef);
+		for (cnt = 0; cnt <= p->num->mast_cols; cnt++)
+			if (coef[cnt] != 0.0)
+			{
+				share->ind[nz] = cnt;
+				share->val[nz++] = coef[cnt];
+			}
+	}
+	share->beg[share->rows] = nz;
+
+	mem_free(coef);
+	return share;
+}
+
+void free_batch_share(batch_share_type *share)
+{
+	mem_free(share->beg);
+	mem_free(share->ind);
+	mem_free(share->val);
+	mem_free(share->coef_rhs);
+	mem_free(share->rhs);
+	mem_free(share->lb);
+	mem_free(share->ub);
+	mem_free(share);
+}
+
+/*
+ ** Adds the block of replication _batch_id_ to the batch problem, with
+ ** the rhs, bounds and cut rows of its _share_.  The first replication
+ ** creates the problem.  With BATCH_DECOMP the block is set up as a
+ ** problem of its own instead.
+ */
+void add_batch_rep(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		batch_share_type *share)
+{
+	int i;
+
+	if (sd_global->config.BATCH_DECOMP)
+	{
+		if (!(sd_global->reps.block[batch_id] = new_batch_problem(p->master)))
+			err_msg("Copy", "add_batch_rep", "block");
+		sd_global->reps.batch_row[batch_id] = 0;
+	}
+	else if (batch_id == 0)
+	{
+		if (!(sd_global->batch_problem = new_batch_problem(p->master)))
+			err_msg("Copy", "add_batch_rep", "batch_problem");
+		sd_global->reps.batch_row[0] = 0;
+	}
+	else
+		sd_global->reps.batch_row[batch_id] = add_batch_block(sd_global,
+				p->master, batch_id);
+
+	set_batch_rhs(sd_global, p, share->rhs, batch_id);
+	set_batch_bounds(sd_global, p, share->lb, share->ub, batch_id);
+	for (i = 0; i < share->rows; i++)
+		add_batch_row(sd_global, p, share->beg[i + 1] - share->beg[i],
+				share->ind + share->beg[i], share->val + share->beg[i],
+				share->coef_rhs[i], batch_id);
+	sd_global->reps.batch_cuts[batch_id] = share->rows;
+}
+
+/*
+ ** Records the outcome of replication _batch_id_, in replication order:
+ ** its iteration count _k_, objective estimate, quadratic scalar, master
+ ** duals and value, incumbent _x_, and its share of the batch problem,
+ ** which is added to it and released.
+ */
+void record_rep_result(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		int k, double incumb_est, double quad_scalar, double opt_value,
+		vector pi, vector dj, vector x, batch_share_type *share)
+{
+	sd_global->ck[batch_id] = k;
+	/* Record SD Lower Bound estimate modified by Yifan 2012.10.05 */
+	sd_global->Obj_lb[batch_id] = incumb_est;
+	store_master_dual_and_obj(sd_global, p, batch_id, pi, dj, opt_value);
+	store_batch_incumb(sd_global, p, x, batch_id);
+	/*record the quadratic sclar used in this replication*/
+	sd_global->quad_v[batch_id] = quad_scalar;
+	add_batch_rep(sd_global, p, batch_id, share);
+	free_batch_share(share);
+	sd_global->reps.next = batch_id + 1;
+}
+
+/*
+ ** TRUE once ADAPT_REPS may stop adding replications after the first _n_:
+ ** the 95% confidence interval on the mean of their objective estimates
+ ** is within REP_TOL of that mean, relative.  Sets _stop_ when it is.
+ ** The OVERRIDE test at replication 2 needs the first three.
+ **
+ ** The estimates are the replications' incumbent estimates (Obj_lb),
+ ** which stand in for the estimate of the compromise solution: that one
+ ** needs the compromise problem of all the replications solved, and it
+ ** is only set up once they stop.
+ */
+BOOL reps_converged(sdglobal_type* sd_global, int n)
+{
+	double mean, stdev, half;
+
+	if (!sd_global->config.ADAPT_REPS
+			|| n < max(3, sd_global->config.MIN_REPS))
+		return FALSE;
+
+	calc_var(sd_global, sd_global->Obj_lb, &mean, &stdev, n);
+	half = t_quantile_95(n - 1) * stdev;
+	if (half > sd_global->config.REP_TOL * DBL_ABS(mean))
+		return FALSE;
+
+	printf("\nStopping after %d replications: estimate %f +/- %f.\n", n, mean,
+			half);
+	sd_global->reps.stop = TRUE;
+	return TRUE;
+}
+
+/*
+ ** Completes the batch problem of the first reps.num replications,
+ ** averaging their objectives: each block was added with weight 1.
+ */
+void finish_batch_problem(sdglobal_type* sd_global, prob_type *p)
+{
+	int *indices;
+	double *values;
+	int cols, i, j;
+
+	cols = sd_global->reps.num * (p->num->mast_cols + 1);
+	if (!(indices = arr_alloc(cols, int)))
+		err_msg("Allocation", "finish_batch_problem", "indices");
+	if (!(values = arr_alloc(cols, double)))
+		err_msg("Allocation", "finish_batch_problem", "values");
+
+	for (i = 0; i < sd_global->reps.num; i++)
+	{
+		for (j = 0; j < p->num->mast_cols; j++)
+			values[i * (p->num->mast_cols + 1) + j] = p->master->objx[j]
+					/ sd_global->reps.num;
+		values[i * (p->num->mast_cols + 1) + j] = 1.0 / sd_global->reps.num;
+	}
+	for (i = 0; i < cols; i++)
+		indices[i] = i;
+
+	if (change_objective(sd_global->batch_problem, cols, indices, values))
+		err_msg("LP solver", "finish_batch_problem", "objective");
+
+	mem_free(indices);
+	mem_free(values);
+}
+
+/*
+ ** Solves the blocks _first_, _first_ + _step_, ... of a round of
+ ** solve_batch_ph(): the objective of each is that of the compromise
+ ** problem plus the multiplier and penalty terms of its replication.
+ */
+void *ph_worker(void *arg)
+{
+	ph_work_type *work = (ph_work_type *) arg;
+	sdglobal_type *sd_global = work->sd_global;
+	one_problem *bp;
+	vector inc;
+	int n, N, i, j;
+
+	n = work->p->num->mast_cols;
+	N = sd_global->reps.num;
+	for (i = work->first; i < N; i += work->step)
+	{
+		bp = sd_global->reps.block[i];
+		inc = sd_global->batch_incumb->incumb_x[i];
+		for (j = 0; j < n; j++)
+			work->obj[j] = work->p->master->objx[j] / N + work->mult[i][j + 1]
+					+ work->rho * (inc[j + 1] - work->z[j + 1]);
+		work->obj[n] = 1.0 / N;
+		if (change_objective(bp, n + 1, work->ind, work->obj)
+				|| !solve_clone(bp) || get_x(bp, work->d[i], 0, n))
+		{
+			work->failed = TRUE;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ ** Solves the compromise problem by progressive hedging on its consensus
+ ** constraint, rather than in one piece.  The block of replication i (its
+ ** final master, in d_i = x_i - incumb_x[i]) is solved on its own, with
+ ** the objective it has in the compromise problem plus
+ **
+ **   w_i x d_i + (rho/2) || incumb_x[i] + d_i - z ||^2
+ **
+ ** Then z becomes the mean of the x_i and w_i grows by rho (x_i - z),
+ ** until both the spread of the x_i about z and the move of z are within
+ ** PH_TOL of 1 + ||z||.  The first round starts from the mean of the
+ ** incumbents; the blocks keep their basis from one round to the next
+ ** and are spread over NUM_THREADS threads.  rho is PH_RHO times the
+ ** weight of the regularizer in construct_batch_QP().
+ **
+ ** Leaves z - incumb_x[0] in _s->incumb_d_ and each block at its last
+ ** solution, and returns the objective of the compromise problem there.
+ */
+double solve_batch_ph(sdglobal_type* sd_global, prob_type *p, soln_type *s)
+{
+	ph_work_type *work;
+	pthread_t *thread;
+	vector z, z_old, *mult, *d, inc;
+	double *qsep;
+	double q, rho, spread, move, scale, diff, obj;
+	int n, N, n_work, i, j, iter;
+
+#ifdef TRACE
+	printf("Inside solve_batch_ph\n");
+#endif
+
+	n = p->num->mast_cols;
+	N = sd_global->reps.num;
+
+	q = 0.0;
+	for (i = 0; i < N; i++)
+		q += sd_global->quad_v[i];
+	q = 0.5 * q / N / N;
+	rho = sd_global->config.PH_RHO * (q > 0.0 ? q : 1.0 / N);
+
+	z = arr_alloc(n+1, double);
+	z_old = arr_alloc(n+1, double);
+	qsep = arr_alloc(n+1, double);
+	mult = (vector *) mem_calloc (N, sizeof(vector));
+	d = (vector *) mem_calloc (N, sizeof(vector));
+	if (!z || !z_old || !qsep || !mult || !d)
+		err_msg("Allocation", "solve_batch_ph", "z");
+	for (i = 0; i < N; i++)
+		if (!(mult[i] = arr_alloc(n+1, double)) || !(d[i] = arr_alloc(n+1, double)))
+			err_msg("Allocation", "solve_batch_ph", "mult");
+
+	/* The penalty is a diagonal term on top of the regularizer */
+	for (j = 0; j < n; j++)
+		qsep[j] = q + rho;
+	qsep[n] = 0.0;
+	for (i = 0; i < N; i++)
+		if (copy_qp_separable(sd_global->reps.block[i], qsep))
+			err_msg("LP solver", "solve_batch_ph", "qsep");
+
+	for (j = 1; j <= n; j++)
+	{
+		for (i = 0; i < N; i++)
+			z[j] += sd_global->batch_incumb->incumb_x[i][j];
+		z[j] /= N;
+	}
+
+	n_work = max(1, min(sd_global->config.NUM_THREADS, N));
+	if (!(work = arr_alloc(n_work, ph_work_type)))
+		err_msg("Allocation", "solve_batch_ph", "work");
+	if (!(thread = arr_alloc(n_work, pthread_t)))
+		err_msg("Allocation", "solve_batch_ph", "thread");
+	for (i = 0; i < n_work; i++)
+	{
+		work[i].sd_global = sd_global;
+		work[i].p = p;
+		work[i].first = i;
+		work[i].step = n_work;
+		work[i].rho = rho;
+		work[i].z = z;
+		work[i].mult = mult;
+		work[i].d = d;
+		work[i].failed = FALSE;
+		if (!(work[i].obj = arr_alloc(n+1, double)))
+			err_msg("Allocation", "solve_batch_ph", "obj");
+		if (!(work[i].ind = arr_alloc(n+1, int)))
+			err_msg("Allocation", "solve_batch_ph", "ind");
+		for (j = 0; j <= n; j++)
+			work[i].ind[j] = j;
+	}
+
+	spread = move = 0.0;
+	set_clone_params(TRUE);
+	for (iter = 1; iter <= sd_global->config.PH_MAX_ITER; iter++)
+	{
+		for (i = 1; i < n_work; i++)
+			if (pthread_create(&thread[i], NULL, ph_worker, &work[i]))
+				err_msg("Thread", "solve_batch_ph", "pthread_create");
+		ph_worker(&work[0]);
+		for (i = 1; i < n_work; i++)
+			pthread_join(thread[i], NULL);
+		for (i = 0; i < n_work; i++)
+			if (work[i].failed)
+				err_msg("LP solver", "solve_batch_ph", "block");
+
+		/* The new consensus, then the multipliers and residuals at it */
+		spread = move = scale = 0.0;
+		for (j = 1; j <= n; j++)
+		{
+			z_old[j] = z[j];
+			z[j] = 0.0;
+			for (i = 0; i < N; i++)
+				z[j] += sd_global->batch_incumb->incumb_x[i][j] + d[i][j - 1];
+			z[j] /= N;
+			for (i = 0; i < N; i++)
+			{
+				diff = sd_global->batch_incumb->incumb_x[i][j] + d[i][j - 1]
+						- z[j];
+				mult[i][j] += rho * diff;
+				spread += diff * diff;
+			}
+			move += (z[j] - z_old[j]) * (z[j] - z_old[j]);
+			scale += z[j] * z[j];
+		}
+		spread = sqrt(spread / N);
+		move = sqrt(move);
+		scale = sd_global->config.PH_TOL * (1.0 + sqrt(scale));
+		if (spread <= scale && move <= scale)
+			break;
+	}
+	set_clone_params(FALSE);
+	printf("Progressive hedging: %d rounds, spread %g, move %g%s\n",
+			min(iter, sd_global->config.PH_MAX_ITER), spread, move,
+			iter > sd_global->config.PH_MAX_ITER ? " (round limit)" : "");
+
+	obj = 0.0;
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < n; j++)
+			obj += p->master->objx[j] / N * d[i][j] + 0.5 * q * d[i][j] * d[i][j];
+		obj += d[i][n] / N;
+	}
+	inc = sd_global->batch_incumb->incumb_x[0];
+	for (j = 1; j <= n; j++)
+		s->incumb_d[j] = z[j] - inc[j];
+	s->incumb_d[0] = one_norm(&s->incumb_d[1], n);
+
+	for (i = 0; i < n_work; i++)
+	{
+		mem_free(work[i].obj);
+		mem_free(work[i].ind);
+	}
+	mem_free(work);
+	mem_free(thread);
+	for (i = 0; i < N; i++)
+	{
+		mem_free(mult[i]);
+		mem_free(d[i]);
+	}
+	mem_free(mult);
+	mem_free(d);
+	mem_free(qsep);
+	mem_free(z);
+	mem_free(z_old);
+
+#ifdef TRACE
+	printf("Exiting solve_batch_ph\n");
+#endif
+	return obj;
+}
+
+#ifdef SD_unix
+/*
+ ** Solves replication _batch_id_ in a forked worker.  The worker runs in
+ ** its own folder repNN with its own solver environment and leaves its
+ ** outcome there for collect_rep_batches().  Blocks while all
+ ** REP_WORKERS are busy.
+ */
+void launch_rep(sdglobal_type* sd_global, one_problem *original, vector x_k,
+		int num_rv, int num_cipher, int row, int col, char *fname, int batch_id)
+{
+	char dir[BUFFER_SIZE];
+	pid_t pid;
+
+	wait_rep_workers(sd_global, sd_global->reps.workers - 1);
+
+	sprintf(dir, "%s/rep%02d", sd_global->reps.dir, batch_id);
+	if (mkdir(dir, 0755) && errno != EEXIST)
+		err_msg("File", "launch_rep", dir);
+
+	fflush(NULL);
+	if ((pid = fork()) < 0)
+		err_msg("Process", "launch_rep", "fork");
+
+	if (pid == 0)
+	{
+#ifdef OMEGA_FILE
+		/* Do not share the file offset of the parent's stream */
+		sd_global->fptrOMEGA = fopen(sd_global->omegas.file_name, "r");
+#endif
+		if (chdir(dir))
+			err_msg("File", "launch_rep", dir);
+		if (!freopen("screen.log", "w", stdout))
+			err_msg("File", "launch_rep", "screen.log");
+
+		sd_global->reps.child = TRUE;
+		open_Solver();
+		solve_SD(sd_global, original, x_k, num_rv, num_cipher, row, col,
+				fname, batch_id);
+		close_Solver();
+		exit(0);
+	}
+
+	sd_global->reps.pid[batch_id] = pid;
+	sd_global->reps.running++;
+}
+
+/* Marks the worker of _batch_id_ as finished, giving up if it failed. */
+void end_rep_worker(sdglobal_type* sd_global, int batch_id, int status)
+{
+	if (!WIFEXITED(status) || WEXITSTATUS(status))
+	{
+		printf("\n\n||| Replication %d failed in its worker process.\n",
+				batch_id);
+		exit(1);
+	}
+	sd_global->reps.pid[batch_id] = 0;
+	sd_global->reps.running--;
+}
+
+/* Waits until no more than _max_running_ workers are still running. */
+void wait_rep_workers(sdglobal_type* sd_global, int max_running)
+{
+	int status, idx;
+	pid_t pid;
+
+	while (sd_global->reps.running > max_running)
+	{
+		if ((pid = wait(&status)) < 0)
+			err_msg("Process", "wait_rep_workers", "wait");
+		for (idx = 0; idx < sd_global->reps.max; idx++)
+			if (sd_global->reps.pid[idx] == pid)
+			{
+				end_rep_worker(sd_global, idx, status);
+				break;
+			}
+	}
+}
+
+/* Stops the workers still running, whose replications are not needed. */
+void stop_rep_workers(sdglobal_type* sd_global)
+{
+	int status, idx;
+
+	for (idx = 0; idx < sd_global->reps.max; idx++)
+		if (sd_global->reps.pid[idx] > 0)
+		{
+			kill(sd_global->reps.pid[idx], SIGTERM);
+			waitpid(sd_global->reps.pid[idx], &status, 0);
+			sd_global->reps.pid[idx] = 0;
+			sd_global->reps.running--;
+		}
+}
+
+/*
+ ** Writes the outcome of the replication just solved by this worker to
+ ** rep_batch.bin, in the order apply_rep_batch() reads it back.
+ */
+void write_rep_batch(sdglobal_type* sd_global, prob_type *p, cell_type *c,
+		soln_type *s)
+{
+	batch_share_type *share;
+	FILE *fp;
+	int head[2];
+	double val[3];
+
+	if (!(fp = fopen("rep_batch.bin", "wb")))
+		err_msg("File", "write_rep_batch", "rep_batch.bin");
+
+	head[0] = p->current_batch_id;
+	head[1] = c->k;
+	val[0] = s->incumb_est;
+	val[1] = c->quad_scalar;
+	val[2] = s->opt_value;
+	fwrite(head, sizeof(int), 2, fp);
+	fwrite(val, sizeof(double), 3, fp);
+	fwrite(s->Master_pi, sizeof(double),
+			p->num->mast_rows + p->num->max_cuts + 1, fp);
+	fwrite(s->Master_dj, sizeof(double), p->num->mast_cols + 1, fp);
+	fwrite(s->incumb_x, sizeof(double), p->num->mast_cols + 1, fp);
+
+	share = new_batch_share(sd_global, p, c, s);
+	fwrite(share->rhs, sizeof(double), p->num->mast_rows, fp);
+	fwrite(share->lb, sizeof(double), p->num->mast_cols + 1, fp);
+	fwrite(share->ub, sizeof(double), p->num->mast_cols + 1, fp);
+	fwrite(&share->rows, sizeof(int), 1, fp);
+	fwrite(share->beg, sizeof(int), share->rows + 1, fp);
+	fwrite(share->ind, sizeof(int), share->beg[share->rows], fp);
+	fwrite(share->val, sizeof(double), share->beg[share->rows], fp);
+	fwrite(share->coef_rhs, sizeof(double), share->rows, fp);
+	free_batch_share(share);
+
+	if (fclose(fp))
+		err_msg("File", "write_rep_batch", "rep_batch.bin");
+}
+
+/* Reads _n_ values of _size_ bytes from a worker's rep_batch.bin. */
+void read_rep_vals(FILE *fp, void *val, size_t size, int n)
+{
+	if (fread(val, size, n, fp) != (size_t) n)
+		err_msg("File", "read_rep_vals", "rep_batch.bin");
+}
+
+/* Reads a worker's rep_batch.bin from _fp_ and records its outcome. */
+void apply_rep_batch(sdglobal_type* sd_global, prob_type *p, FILE *fp)
+{
+	batch_share_type *share;
+	int head[2];
+	double val[3];
+	vector pi, dj, x;
+
+	if (!(share = (batch_share_type *) mem_malloc (sizeof(batch_share_type))))
+		err_msg("Allocation", "apply_rep_batch", "share");
+	pi = arr_alloc(p->num->mast_rows+p->num->max_cuts+1, double);
+	dj = arr_alloc(p->num->mast_cols+2, double);
+	x = arr_alloc(p->num->mast_cols+1, double);
+	share->rhs = arr_alloc(p->num->mast_rows+1, double);
+	share->lb = arr_alloc(p->num->mast_cols+1, double);
+	share->ub = arr_alloc(p->num->mast_cols+1, double);
+	if (!pi || !dj || !x || !share->rhs || !share->lb || !share->ub)
+		err_msg("Allocation", "apply_rep_batch", "buffers");
+
+	read_rep_vals(fp, head, sizeof(int), 2);
+	read_rep_vals(fp, val, sizeof(double), 3);
+	read_rep_vals(fp, pi, sizeof(double),
+			p->num->mast_rows + p->num->max_cuts + 1);
+	read_rep_vals(fp, dj, sizeof(double), p->num->mast_cols + 1);
+	read_rep_vals(fp, x, sizeof(double), p->num->mast_cols + 1);
+	read_rep_vals(fp, share->rhs, sizeof(double), p->num->mast_rows);
+	read_rep_vals(fp, share->lb, sizeof(double), p->num->mast_cols + 1);
+	read_rep_vals(fp, share->ub, sizeof(double), p->num->mast_cols + 1);
+	read_rep_vals(fp, &share->rows, sizeof(int), 1);
+
+	if (!(share->beg = arr_alloc(share->rows+1, int)))
+		err_msg("Allocation", "apply_rep_batch", "share");
+	read_rep_vals(fp, share->beg, sizeof(int), share->rows + 1);
+	share->ind = arr_alloc(share->beg[share->rows]+1, int);
+	share->val = arr_alloc(share->beg[share->rows]+1, double);
+	share->coef_rhs = arr_alloc(share->rows+1, double);
+	if (!share->ind || !share->val || !share->coef_rhs)
+		err_msg("Allocation", "apply_rep_batch", "share");
+	read_rep_vals(fp, share->ind, sizeof(int), share->beg[share->rows]);
+	read_rep_vals(fp, share->val, sizeof(double), share->beg[share->rows]);
+	read_rep_vals(fp, share->coef_rhs, sizeof(double), share->rows);
+
+	record_rep_result(sd_global, p, head[0], head[1], val[0], val[1], val[2],
+			pi, dj, x, share);
+
+	mem_free(pi);
+	mem_free(dj);
+	mem_free(x);
+}
+
+/*
+ ** Records, in replication order, the outcome the workers left for the
+ ** replications before _batch_id_, skipping any replication of this
+ ** process that did not finish.  With _block_ it waits for the workers
+ ** still running; otherwise it stops at the first of them.  It also
+ ** stops once reps_converged() is satisfied.
+ */
+void collect_rep_batches(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		BOOL block)
+{
+	char fname[BUFFER_SIZE];
+	FILE *fp;
+	int status, id;
+	pid_t pid;
+
+	while (sd_global->reps.next < batch_id && !sd_global->reps.stop)
+	{
+		id = sd_global->reps.next;
+		if (sd_global->reps.pid[id] < 0)
+		{
+			sd_global->reps.next++; /* solved in this process */
+			continue;
+		}
+		if (sd_global->reps.pid[id] > 0)
+		{
+			pid = waitpid(sd_global->reps.pid[id], &status, block ? 0 : WNOHANG);
+			if (pid < 0)
+				err_msg("Process", "collect_rep_batches", "waitpid");
+			if (pid == 0)
+				return;
+			end_rep_worker(sd_global, id, status);
+		}
+
+		sprintf(fname, "%s/rep%02d/rep_batch.bin", sd_global->reps.dir, id);
+		if (!(fp = fopen(fname, "rb")))
+			err_msg("File", "collect_rep_batches", fname);
+		apply_rep_batch(sd_global, p, fp);
+		fclose(fp);
+		reps_converged(sd_global, sd_global->reps.next);
+	}
+}
+#endif
@@ -10,20 +10,79 @@
 
 #include "sdglobal.h"
 
+/*
+ ** One worker of solve_batch_ph(), solving the blocks _first_,
+ ** _first_ + _step_, ... of each round.  _z_ and _mult_ (1-indexed) are
+ ** the consensus and the replications' multipliers, read only; _d_
+ ** (0-indexed, eta last) takes the blocks' solutions.  _obj_ and _ind_
+ ** are the worker's own room for a block's objective.
+ */
+typedef struct
+{
+	sdglobal_type *sd_global;
+	prob_type *p;
+	int first;
+	int step;
+	double rho;
+	vector z;
+	vector *mult;
+	vector *d;
+	double *obj;
+	int *ind;
+	BOOL failed;
+} ph_work_type;
+
 batch_incumb_type * new_batch_incumb(sdglobal_type* sd_global, prob_type *p, vector x_k);
 BOOL get_beta_x(sdglobal_type* sd_global, soln_type *s, vector Beta,
-		one_problem *p, num_type *num, int length);
-one_problem * new_batch_problem(one_problem * master, int max_cuts);
+		prob_type *prob, num_type *num, int length);
+void batch_block_names(one_problem *master, int batch_id, char *cstore,
+		string *cname, char *rstore, string *rname);
+one_problem * new_batch_problem(one_problem * master);
+int add_batch_block(sdglobal_type* sd_global, one_problem *master,
+		int batch_id);
+one_problem *batch_block(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		int *row, int *col);
 void add_batch_equality(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s);
-void add_cut_to_batch(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
-		cell_type *c, soln_type *s, int batch_id, int cut_position);
-void add_fcut_to_batch(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
-		cell_type *c, soln_type *s, int batch_id, int iteration_num);
-void save_batch_incumb(sdglobal_type* sd_global, prob_type *p, cell_type *c, soln_type *s, int batch_id);
-void update_batch_bounds(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int batch_id);
-void update_batch_rhs(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int batch_id);
+double batch_cut_row(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
+		cell_type *c, soln_type *s, BOOL fea_cut, double *coef);
+void add_batch_row(sdglobal_type* sd_global, prob_type *p, int nzcnt,
+		int *ind, double *val, double rhs, int batch_id);
+void set_batch_rhs(sdglobal_type* sd_global, prob_type *p, double *rhs,
+		int batch_id);
+void set_batch_bounds(sdglobal_type* sd_global, prob_type *p, double *lbounds,
+		double *ubounds, int batch_id);
+void store_batch_incumb(sdglobal_type* sd_global, prob_type *p, vector x,
+		int batch_id);
+void init_rep_pool(sdglobal_type* sd_global, char *dir);
+void free_rep_pool(sdglobal_type* sd_global);
+BOOL rep_in_process(sdglobal_type* sd_global, int batch_id);
+void init_batch_data(sdglobal_type* sd_global, prob_type *p, vector x_k);
+one_cut *batch_share_cut(cell_type *c, int i, BOOL *fea_cut);
+batch_share_type *new_batch_share(sdglobal_type* sd_global, prob_type *p,
+		cell_type *c, soln_type *s);
+void free_batch_share(batch_share_type *share);
+void add_batch_rep(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		batch_share_type *share);
+void record_rep_result(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		int k, double incumb_est, double quad_scalar, double opt_value,
+		vector pi, vector dj, vector x, batch_share_type *share);
+BOOL reps_converged(sdglobal_type* sd_global, int n);
+void finish_batch_problem(sdglobal_type* sd_global, prob_type *p);
+void *ph_worker(void *arg);
+double solve_batch_ph(sdglobal_type* sd_global, prob_type *p, soln_type *s);
+#ifdef SD_unix
+void launch_rep(sdglobal_type* sd_global, one_problem *original, vector x_k,
+		int num_rv, int num_cipher, int row, int col, char *fname, int batch_id);
+void end_rep_worker(sdglobal_type* sd_global, int batch_id, int status);
+void wait_rep_workers(sdglobal_type* sd_global, int max_running);
+void stop_rep_workers(sdglobal_type* sd_global);
+void write_rep_batch(sdglobal_type* sd_global, prob_type *p, cell_type *c,
+		soln_type *s);
+void read_rep_vals(FILE *fp, void *val, size_t size, int n);
+void apply_rep_batch(sdglobal_type* sd_global, prob_type *p, FILE *fp);
+void collect_rep_batches(sdglobal_type* sd_global, prob_type *p, int batch_id,
+		BOOL block);
+#endif
 
 #endif /* BATCH_H_ */
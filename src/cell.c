@@ -30,6 +30,7 @@
 #include "memory.h"
 #include "omega.h"
 #include "lambda.h"
+#include "delta.h"
 #include "log.h"
 #include "master.h"
 #include "cuts.h"
@@ -51,19 +52,13 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 {
 	soln_type *soln;
 	int omeg_idx;
-	int i, j, cnt;
-	double obj;
+	int i, j;
 	BOOL new_omega;
 	double phi[4]; /*  SS messing around  */
 	double conf_int[2]; /* JH 3/13/98 */
 	int num_subproblems = 0; /* JH 3/12/98 */
 	FILE *f2_out; /* JH 3/12/98 */
     FILE *time_sample; /*Yifan 2013.06.30*/
-	FILE *master_dual = NULL; /*Yiifan 2012-09-11*/
-	FILE *batch_dual = NULL; /*Yifan 2012-09-11*/
-	FILE *master_obj = NULL; /*Yifan 2012-09-23*/
-	FILE *batch_obj = NULL; /*Yifan 2012-09-23*/
-	FILE *batch_d = NULL; /* modified by Yifan 2012.09.23 */
 	/*  FILE          *junk; */
 #ifdef DEBUG
 	struct tms total_init_time, total_term_time; /* zl 08/18/04 */
@@ -71,8 +66,6 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 	clock_t total_start_time, total_end_time; /* zl 06/29/04 */
 	clock_t iter_start_time, iter_end_time; /* zl 06/29/04 */
 	clock_t argmax_start, argmax_end; /* zl 06/30/04 */
-    clock_t batch_start, batch_end; /* modified by Yifan 2013.10.31 */
-    double batch_time;
 	FILE *time_file, *obj_file; /* zl 06/29/04 */
 	char time_fname[NAME_SIZE * 2], obj_fname[NAME_SIZE * 2]; /* modified by Yifan to store longer names */
 	/* zl 06/30/04 */
@@ -112,26 +105,8 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 	if (!(cell->master = new_master(prob->master, cell->cuts,
 			prob->num->max_cuts, x_k)))
 		err_msg("Copy", "solve_cell", "cell->master");
-
-	/* Initialize data structure for Batch-Mean problem at the begining of the first iteration Yifan 2012-09-10 */
-	if (prob->current_batch_id == 0)
-	{
-		if (!(sd_global->batch_problem = new_batch_problem(prob->master,
-				prob->num->max_cuts)))
-			err_msg("Copy", "solve_cell", "cell->subprob");
-		new_batch_incumb(sd_global, prob, x_k);
-
-		/* modified by Yifan 2013.02.15 */
-		sd_global->bcuts = new_bcuts(prob, BATCH_SIZE, sd_global->bcuts);
-		/* modified by Yifan 2013.05.05 */
-		sd_global->bfcuts = new_bcuts(prob, BATCH_SIZE, sd_global->bfcuts);
-		sd_global->bfcuts_pool = new_bcuts(prob, BATCH_SIZE,
-				sd_global->bfcuts_pool);
-
-		sd_global->quad_v = arr_alloc(BATCH_SIZE, double);
-		/* modified by Yifan 2012.10.05 */
-		sd_global->Obj_lb = arr_alloc(BATCH_SIZE,double);
-	}
+	init_cut_rows(cell, prob->num);
+	init_eta_col(sd_global, cell, prob->num);
 
 	if (!(cell->subprob = new_subprob(prob->subprob)))
 		err_msg("Copy", "solve_cell", "cell->subprob");
@@ -209,6 +184,9 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		 zl, 06/30/04. */
 		soln->run_time->soln_subprob_iter = 0.0;
 		soln->run_time->argmax_iter = 0.0;
+
+		/* Take back the last iteration's temporary vectors at once */
+		mem_arena_reset(cell->scratch);
 		/* Reset _smpl_test_flag_ to FALSE at the start of each iteration.
 		 zl, 08/17/04. */
 		soln->smpl_test_flag = FALSE;
@@ -230,23 +208,15 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		if ((soln->optimality_flag && *soln->dual_statble_flag)
 				|| cell->k >= prob->num->iter)
 		{
-			sd_global->ck[prob->current_batch_id] = cell->k;
-			/* Record SD Lower Bound estimate modified by Yifan 2012.10.05 */
-			sd_global->Obj_lb[prob->current_batch_id] = soln->incumb_est;
-
-			record_master_dual_and_obj(sd_global, prob, soln, master_dual,
-					master_obj);
-
-			/* change_rhs_back(prob, cell, soln);*//*Keep the decisions as d instead of chaning them to x*/
-			/* write_prob(cell->master, "final.lp"); */
-			/* write_prob(sd_global->batch_problem, "final-1cut-a.lp");*/
-			update_batch_rhs(sd_global, prob, cell, soln,
-					prob->current_batch_id);
-			update_batch_bounds(sd_global, prob, cell, soln,
-					prob->current_batch_id);
-			save_batch_incumb(sd_global, prob, cell, soln,
-					prob->current_batch_id);
-
+#ifdef SD_unix
+			/* A worker only hands its share of the batch problem back */
+			if (sd_global->reps.child)
+			{
+				write_rep_batch(sd_global, prob, cell, soln);
+				break;
+			}
+			collect_rep_batches(sd_global, prob, prob->current_batch_id, TRUE);
+#endif
 			/*Group cuts structure under bcuts structure  Yifan 2013/01/17*/
 
 			/* modified by Yifan 2013.02.15 */
@@ -256,59 +226,14 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 			sd_global->bfcuts_pool->batch[prob->current_batch_id] =
 					cell->feasible_cuts_pool;
 
-			for (i = 0; i < prob->num->max_cuts; i++)
-			{
-				add_cut_to_batch(sd_global, cell->cuts->val[i], prob, cell,
-						soln, prob->current_batch_id, i);
-			}
-
-			if (prob->current_batch_id == BATCH_SIZE - 1)
-			{
-
-				/* Setup the whole problem as a quadratic problem */
-				construct_batch_QP(sd_global, prob, cell, 1.0 / BATCH_SIZE);
-
-				/* modified by Yifan 2013.05.05 */
-				if (0)
-				{
-					for (cnt = 0; cnt < BATCH_SIZE; cnt++)
-					{
-						for (i = 0; i < sd_global->bfcuts->batch[cnt]->cnt; i++)
-						{
-							for (j = 0; j < BATCH_SIZE; j++)
-							{
-								add_fcut_to_batch(sd_global,
-										sd_global->bfcuts->batch[cnt]->val[i],
-										prob, cell, soln, j, sd_global->ck[j]);
-							}
-						}
-					}
-				}
-				/*
-				 else
-				 {
-				 j=0;
-				 for (cnt = 0; cnt < BATCH_SIZE; cnt++) {
-				 for (i = 0; i < sd_global->bfcuts->batch[cnt]->cnt; i++) {
-				 add_fcut_to_batch(sd_global->bfcuts->batch[cnt]->val[i], prob, cell, soln, cnt, ck[j]);
-				 }
-				 }
-				 }*/
-
-				add_batch_equality(sd_global, prob, cell, soln);
-
-				/*Get batch dual and obj and corresponding statistics*/
-                write_prob(sd_global->batch_problem, "final-batch-prob.lp");
-                batch_start = clock();
-                solve_problem(sd_global, sd_global->batch_problem);
-                batch_end = clock();
-                batch_time = ((double) (batch_end - batch_start))/ CLOCKS_PER_SEC;
-				process_batch_prob(sd_global, prob, soln, &obj, batch_dual,
-						batch_d, batch_obj);
-			}
-
-			/*record the quadratic sclar used in this replication*/
-			sd_global->quad_v[prob->current_batch_id] = cell->quad_scalar;
+			/* This replication's block joins the batch problem; none are
+			 needed past the point ADAPT_REPS stopped at */
+			if (!sd_global->reps.stop)
+				record_rep_result(sd_global, prob, prob->current_batch_id,
+						cell->k, soln->incumb_est, cell->quad_scalar,
+						soln->opt_value, soln->Master_pi, soln->Master_dj,
+						soln->incumb_x, new_batch_share(sd_global, prob, cell,
+								soln));
 
 			break;
 		}
@@ -481,6 +406,10 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		write_statistics(sd_global, prob, cell, soln);
 
 		/*thin_data(prob, cell, soln);*/
+		thin_to_budget(sd_global, prob, cell, soln);
+		if (!(cell->k % DELTA_PLACE))
+			place_delta(soln->delta, cell->lambda, cell->sigma, cell->cuts,
+					cell->k, cell->scratch);
 
 		/* Yifan 03/12/2012 Test for incumbent changes*/
 		if (0)
@@ -657,38 +586,6 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
   }
   
 
-	/* modified by Yifan 2012.09.23 */
-	/* Evaluate batch x and average x of replicatiing x 2012.09.23 */
-
-	if (prob->current_batch_id == BATCH_SIZE - 1)
-	{
-
-		/* modified by Yifan 2013.02.15 */
-		/* calc_lowerbound(prob, soln); */
-
-		batch_d = fopen("Batch_x.out", "a");
-		soln->incumb_d[0] = one_norm(&soln->incumb_d[1], prob->num->mast_cols);
-		sd_global->config.EVAL_SEED1 = prob->eval_seed;
-		evaluate_inc(sd_global, cell, prob, soln, soln->incumb_d, fname,
-				conf_int, 1);
-		fprintf(batch_d, "Batch_x - Inc. Value 0.95 CI: [%lf , %lf] \n",
-				conf_int[0], conf_int[1]);
-		sd_global->config.EVAL_SEED1 = prob->eval_seed;
-		evaluate_inc(sd_global, cell, prob, soln, soln->incumb_avg, fname,
-				conf_int, 2);
-		fprintf(batch_d, "Incumb_avg - Inc. Value 0.95 CI: [%lf , %lf] \n",
-				conf_int[0], conf_int[1]);
-		fclose(batch_d);
-        
-        /* modified by Yifan 2013.06.30 */
-        time_sample = fopen("time_sample.out", "a");
-        fprintf(time_sample, "Total Time for Compromise Solve: %lf\n",batch_time);
-        fclose(time_sample);
-        
-		print_detailed_soln(sd_global, soln, prob, fname, 1);
-		print_detailed_soln(sd_global, soln, prob, fname, 2);
-	}
-
 	if (sd_global->config.DETAILED_SOLN == 1)
 	{
 		print_detailed_soln(sd_global, soln, prob, fname, 0);
@@ -708,7 +605,91 @@ void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 
 	free_subprob(cell->subprob);
 	free_master(cell->master);
-	free_soln(prob, cell, soln);
+	free_soln(prob, soln);
+}
+
+/*************************************************************************\
+** This function solves the compromise (batch-mean) problem over the
+ ** replications recorded in _sd_global->reps_, once they have stopped,
+ ** and evaluates its solution and the average of the replications'
+ ** incumbents.  The cell passed to it only provides the subproblem for
+ ** the evaluations.
+ \************************************************************************/
+void solve_batch(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
+		vector x_k, char *fname)
+{
+	soln_type *soln;
+	double obj;
+	double conf_int[2];
+	FILE *batch_dual = NULL; /*Yifan 2012-09-11*/
+	FILE *batch_obj = NULL; /*Yifan 2012-09-23*/
+	FILE *batch_d = NULL; /* modified by Yifan 2012.09.23 */
+	FILE *time_sample; /*Yifan 2013.06.30*/
+	clock_t batch_start, batch_end; /* modified by Yifan 2013.10.31 */
+	double batch_time;
+
+#ifdef TRACE
+	printf("Inside solve_batch\n");
+#endif
+
+	soln = new_soln(sd_global, prob, x_k);
+	if (!(cell->subprob = new_subprob(prob->subprob)))
+		err_msg("Copy", "solve_batch", "cell->subprob");
+
+	printf("\n\n-------------------- Compromise of %d replications --------------------\n",
+			sd_global->reps.num);
+
+	if (sd_global->config.BATCH_DECOMP)
+	{
+		batch_start = clock();
+		obj = solve_batch_ph(sd_global, prob, soln);
+		batch_end = clock();
+	}
+	else
+	{
+		/* Setup the whole problem as a quadratic problem */
+		finish_batch_problem(sd_global, prob);
+		construct_batch_QP(sd_global, prob, cell, 1.0 / sd_global->reps.num);
+		add_batch_equality(sd_global, prob, cell, soln);
+
+		/*Get batch dual and obj and corresponding statistics*/
+		write_prob(sd_global->batch_problem, "final-batch-prob.lp");
+		batch_start = clock();
+		solve_problem(sd_global, sd_global->batch_problem);
+		batch_end = clock();
+	}
+	batch_time = ((double) (batch_end - batch_start)) / CLOCKS_PER_SEC;
+	process_batch_prob(sd_global, prob, soln, &obj, batch_dual, batch_d,
+			batch_obj);
+
+	/* Evaluate batch x and average x of replicatiing x 2012.09.23 */
+	batch_d = fopen("Batch_x.out", "a");
+	soln->incumb_d[0] = one_norm(&soln->incumb_d[1], prob->num->mast_cols);
+	sd_global->config.EVAL_SEED1 = prob->eval_seed;
+	evaluate_inc(sd_global, cell, prob, soln, soln->incumb_d, fname, conf_int,
+			1);
+	fprintf(batch_d, "Batch_x - Inc. Value 0.95 CI: [%lf , %lf] \n",
+			conf_int[0], conf_int[1]);
+	sd_global->config.EVAL_SEED1 = prob->eval_seed;
+	evaluate_inc(sd_global, cell, prob, soln, soln->incumb_avg, fname,
+			conf_int, 2);
+	fprintf(batch_d, "Incumb_avg - Inc. Value 0.95 CI: [%lf , %lf] \n",
+			conf_int[0], conf_int[1]);
+	fclose(batch_d);
+
+	/* modified by Yifan 2013.06.30 */
+	time_sample = fopen("time_sample.out", "a");
+	fprintf(time_sample, "Total Time for Compromise Solve: %lf\n", batch_time);
+	fclose(time_sample);
+
+	print_detailed_soln(sd_global, soln, prob, fname, 1);
+	print_detailed_soln(sd_global, soln, prob, fname, 2);
+
+	free_subprob(cell->subprob);
+	free_cuts(cell->cuts);
+	free_cuts(cell->feasible_cuts_pool);
+	free_cuts(cell->feasible_cuts_added);
+	free_soln(prob, soln);
 }
 
 /************************************************************************\
@@ -749,19 +730,33 @@ cell_type *new_cell(sdglobal_type* sd_global, prob_type *p, int id_num)
 	c->incumb_infea = FALSE;
 	c->fea_count = 0;
 
+	/* Room for every optimality cut plus as many feasibility cuts */
+	c->row_max = 2 * p->num->max_cuts;
+	if (!(c->cut_row = arr_alloc(c->row_max, one_cut *)))
+		err_msg("Allocation", "new_cell", "cut_row");
+	c->row_cnt = 0;
+	c->free_row = -1;
+	if (!(c->cut_beta = arr_alloc(c->row_max * p->num->mast_cols, double)))
+		err_msg("Allocation", "new_cell", "cut_beta");
+	if (!(c->cut_bx = arr_alloc(c->row_max, double)))
+		err_msg("Allocation", "new_cell", "cut_bx");
+	if (!(c->bx_x = arr_alloc(p->num->mast_cols+1, double)))
+		err_msg("Allocation", "new_cell", "bx_x");
+	c->scratch = new_mem_arena(SCRATCH_SIZE);
+
 	/* modified by Yifan 2013.02.15 */
 	length = p->num->iter + p->num->iter / p->tau + 1;
 
 	/* Yifan 06/18/2012 batch mean */
-	c->cuts = new_cuts(p->num->iter, p->num->mast_cols, 0);
-	c->lambda = new_lambda(length, 0, p->num->rv_rows, p->coord);
+	c->cuts = new_cuts(sd_global->cut_slab, p->num->iter, 0);
+	c->lambda = new_lambda(length, 0, p->num, p->coord);
 	c->sigma = new_sigma(length, p->num->nz_cols, 0, p->coord);
 	c->theta = new_theta(0);
 
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
-	c->feasible_cuts_pool = new_cuts(p->num->iter, p->num->mast_cols, 0);
-	c->feasible_cuts_added = new_cuts(p->num->iter, p->num->mast_cols, 0);
-	c->feasible_lambda = new_lambda(length, 0, p->num->rv_rows, p->coord);
+	c->feasible_cuts_pool = new_cuts(sd_global->cut_slab, p->num->iter, 0);
+	c->feasible_cuts_added = new_cuts(sd_global->cut_slab, p->num->iter, 0);
+	c->feasible_lambda = new_lambda(length, 0, p->num, p->coord);
 	c->feasible_sigma = new_sigma(length, p->num->nz_cols, 0, p->coord);
 	c->feasible_theta = new_theta(0);
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
@@ -808,6 +803,11 @@ void free_cell(cell_type *c, num_type *num)
 	free_theta(c->feasible_theta);
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
 
+	mem_free(c->cut_row);
+	mem_free(c->cut_beta);
+	mem_free(c->cut_bx);
+	mem_free(c->bx_x);
+	free_mem_arena(c->scratch);
 	mem_free(c->members);
 	mem_free(c);
 }
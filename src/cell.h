@@ -22,7 +22,9 @@
 **   To save time and space, Pi x R and Pi x T are calculated as soon
  ** as possible and stored in structures like sigma and delta.  Toward
  ** this end, pi_R_T_type represents a single calculation of pi X R 
- ** (which is a scalar) and pi X T (which is a vector).
+ ** (which is a scalar) and pi X T (which is a vector).  They are stored as
+ ** coef_type, which is float when SD_FLOAT is defined; all arithmetic
+ ** on them is still carried out in double.
  \**************************************************************************/
 #ifndef CELL_H_
 #define CELL_H_
@@ -31,8 +33,8 @@
 
 typedef struct
 {
-	double R;
-	double *T;
+	coef_type R;
+	coef_type *T;
 } pi_R_T_type;
 
 /**************************************************************************\
@@ -40,15 +42,30 @@ typedef struct
  ** distinct dual vector obtained during the program.  Each vector contains 
  ** only those dual variables whose corresponding rows in the subproblem
  ** constraint matrix contain random elements.  _val_ is an array of 
- ** these dual vectors (thus it is 2-D).  _row_ gives the corresponding 
- ** row number for a given dual variable in _val_.  _cnt_ represents 
- ** the number of dual vectors currently stored in lambda.
+ ** these dual vectors, each kept sparse: only its nonzero duals are
+ ** stored, with their positions in _row_, which gives the corresponding
+ ** row number for a given dual variable.  _hash_ holds a hash of the
+ ** positions of each vector, to find duplicates quickly, and _dense_ is
+ ** room to gather a new dual vector in.  _cnt_ represents the number of
+ ** dual vectors currently stored in lambda.
+ **
+ **   The random elements of R and T (see init_R_T_omega()) are grouped by
+ ** the position of their row in _row_: those of position p are entries
+ ** _rt_beg_[p] to _rt_beg_[p+1]-1 of _rt_idx_, which index omega->RT, and
+ ** of _rt_col_, which gives the position in delta->col of the column of a
+ ** T element, or 0 for an element of R.  So a dual vector is multiplied
+ ** by an observation in time proportional to its nonzeros.
  \**************************************************************************/
 typedef struct
 {
 	int cnt;
 	int *row;
-	double **val;
+	sparse_vect *val;
+	unsigned int *hash;
+	double *dense;
+	int *rt_beg;
+	int *rt_idx;
+	int *rt_col;
 } lambda_type;
 
 /**************************************************************************\
@@ -61,6 +78,9 @@ typedef struct
  ** stored.  The _lamb_ array is the same size as the _val_ array, and for 
  ** each element in _val_ the corresponding element in _lamb_ references 
  ** the dual vector in lambda that was used to calculate that entry in sigma. 
+ ** _last_ is the iteration in which each entry was last an istar of a cut
+ ** (or was found), which decides which go first when memory runs short.
+ ** The Pi x Tbar vectors come from _pool_.
  \**************************************************************************/
 typedef struct
 {
@@ -69,6 +89,8 @@ typedef struct
 	pi_R_T_type *val;
 	int *lamb;
 	int *ck; //record the iteration # of the sigma
+	int *last;
+	mem_pool_type *pool;
 } sigma_type;
 
 
@@ -149,6 +171,17 @@ typedef struct
 	BOOL opt_mode; /* Yifan 03/23/2012 used in deciding the mode for solve_QP master */
 	BOOL incumb_infea; /* Yifan 03/23/2012 if incumbent infeasibility is encountered in form_fea_cut */
 	int fea_count; /* Yifan 03/23/2012 count how many iterations the SD goes into the feasibility mode*/
+	one_cut **cut_row; /* cut_row[r] is the cut held in master row mast_rows+r */
+	int row_cnt; /* number of cut rows (optimality and feasibility) in master */
+	int row_max; /* allocated length of cut_row */
+	int free_row; /* row released by release_cut() for add_cut(), or -1 */
+	double *cut_beta; /* beta of cut_row[r] in row r, mast_cols wide */
+	double *cut_bx; /* cut_bx[r] is beta x bx_x for cut_row[r] */
+	vector bx_x; /* point at which cut_bx was last evaluated */
+	double eta_shift; /* master column is zeta = k*(eta - eta_shift) */
+	double eta_obj; /* cost of zeta currently set in the master */
+	double eta_lb; /* lower bound of zeta currently set in the master */
+	mem_arena_type *scratch; /* temporary vectors, reset every iteration */
 } cell_type;
 
 /***********************************************************************\
@@ -171,6 +204,8 @@ typedef struct
 
 void solve_cell(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		vector x_k, char *fname);
+void solve_batch(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
+		vector x_k, char *fname);
 cell_type *new_cell(sdglobal_type* sd_global, prob_type *p, int id_num);
 void free_cell(cell_type *c, num_type *num);
 void write_cell(prob_type *p, cell_type *c, char *fname);
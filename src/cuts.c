@@ -23,11 +23,24 @@
  ** stochastic_updates()
  ** SD_cut()
  ** compute_istar()
+ ** istar_arg()
  ** new_cut()
  ** free_cut()
  ** print_cut()
  ** new_cuts()
  ** free_cuts()
+ ** new_cut_slab()   // where cuts are carved from and given back to
+ ** free_cut_slab()
+ ** cut_buf_get()
+ ** cut_buf_put()
+ ** istar_width()     // narrow storage of a cut's istars
+ ** set_istar()
+ ** copy_istar()
+ ** init_cut_rows()   // master row table for cuts
+ ** append_cut_row()
+ ** remove_cut_row()
+ ** drop_cut()
+ ** release_cut()
  ** print_cut_info() // printing cuts for cut index checking. zl 
  **
  **
@@ -59,6 +72,7 @@
 
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 /*
@@ -95,14 +109,16 @@ void form_new_cut(sdglobal_type* sd_global, prob_type *p, cell_type *cell,
 	printf("Inside form_new_cut; %d cuts now\n", cell->cuts->cnt);
 #endif
 
-	cut = new_cut(p->num->mast_cols, s->omega->most, cell->k);
+	/* Wide enough for the dual stochastic_updates() may add to sigma */
+	cut = new_cut(cell->cuts->slab, s->omega->most, cell->k,
+			istar_width(cell->sigma->cnt));
 
 	stochastic_updates(sd_global, cell, cell->lambda, cell->sigma, s->delta, s->omega,
 			p->num, p->Rbar, p->Tbar, cell->subprob, s->Pi, omeg_idx, new_omega);
 
 	SD_cut(sd_global, cell->sigma, s->delta, s->omega, p->num, cut, s->candid_x,
 			s->pi_ratio, s->max_ratio, s->min_ratio, cell->k,
-			s->dual_statble_flag);
+			s->dual_statble_flag, cell->scratch);
     
     add_cut(sd_global, cut, p, cell, s);
 
@@ -200,7 +216,7 @@ void form_fea_cut(sdglobal_type* sd_global, prob_type *p, cell_type *cell,
 		for (idx = start; idx < end; idx++)
 		{
 			add_cut_to_master(sd_global, cell->feasible_cuts_added->val[idx], p, cell,
-					s, idx);
+					s);
 		}
 		update_dual_size(cell, s, p);
 	}
@@ -291,11 +307,9 @@ BOOL form_incumb_cut(sdglobal_type* sd_global, prob_type *p, cell_type *cell,
 
 			/*modified by Yifan to avoid dropping feasibility cuts 02/09/2012*/
 			/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
+			/* The new incumbent cut takes over the row of the old one below */
 			if (cell->cuts->cnt >= p->num->max_cuts)
-			{
-				drop_cut(s->incumb_cut, p, cell, s);
-				decrease_feacut_rownum(cell);
-			}
+				release_cut(s->incumb_cut, p, cell, s);
 
 		}
 
@@ -311,14 +325,15 @@ BOOL form_incumb_cut(sdglobal_type* sd_global, prob_type *p, cell_type *cell,
 		else
 		{
 			start = clock(); /* zl, 06/30/04. */
-			cut = new_cut(p->num->mast_cols, s->omega->most, cell->k);
+			cut = new_cut(cell->cuts->slab, s->omega->most, cell->k,
+					istar_width(cell->sigma->cnt));
 			cut->is_incumbent = TRUE; /*added by Yifan 02/02/2012 indentify a new incumbent cut*/
 			stochastic_updates(sd_global, cell, cell->lambda, cell->sigma, s->delta,
 					s->omega, p->num, p->Rbar, p->Tbar, cell->subprob, s->Pi,
 					omeg_idx, FALSE);
 			SD_cut(sd_global, cell->sigma, s->delta, s->omega, p->num, cut,
 					s->incumb_x, s->pi_ratio, s->max_ratio, s->min_ratio, cell->k,
-					s->dual_statble_flag);
+					s->dual_statble_flag, cell->scratch);
 			s->incumb_cut = add_cut(sd_global, cut, p, cell, s);
 			s->last_update = cell->k;
 			/* zl, 06/30/04. */
@@ -348,13 +363,6 @@ BOOL form_incumb_cut(sdglobal_type* sd_global, prob_type *p, cell_type *cell,
 	return incumb_change;
 }
 
-void decrease_feacut_rownum(cell_type *cell)
-{
-	int idx;
-	for (idx = 0; idx < cell->feasible_cuts_added->cnt; idx++)
-		--cell->feasible_cuts_added->val[idx]->row_num;
-}
-
 /***********************************************************************\
 ** This function updates all the structures necessary for forming
  ** a stochastic cut.  The latest observation of omega and the latest
@@ -386,7 +394,8 @@ BOOL stochastic_updates(sdglobal_type* sd_global, cell_type *c,
 
 	/* Only need to calculate column if new observation of omega found */
 	if (new_omega)
-		calc_delta_col(sd_global, delta, lambda, omega, num, omeg_idx);
+		calc_delta_col(sd_global, delta, lambda, omega, num, omeg_idx,
+				c->scratch);
 
 	/* Retrieve the dual solution from the latest subproblem */
 	get_dual(Pi, subprob, num, num->sub_rows);
@@ -423,7 +432,8 @@ BOOL stochastic_updates(sdglobal_type* sd_global, cell_type *c,
 	/*Commented by Yifan: even though the lambda is the same, the current Pi might be a 
 	 distinct one due to the variations in sigma*/
 	if (new_lamb)
-		calc_delta_row(sd_global, delta, lambda, omega, num, lamb_idx);
+		calc_delta_row(sd_global, delta, lambda, omega, num, lamb_idx,
+				c->scratch);
 
 #ifdef DEBUG
 	for(idx=0;idx<lambda->cnt;idx++)
@@ -463,11 +473,12 @@ BOOL stochastic_updates(sdglobal_type* sd_global, cell_type *c,
  **
  ** Need to store Pi x Tbar x X for all Pi in a separate array ahead
  ** of time.  This way it isn't re-calculated for each omega...
+ ** It (and the other temporaries) lives in the cell's _scratch_ arena.
  \***********************************************************************/
 void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 		omega_type *omega, num_type *num, one_cut *cut, vector Xvect,
 		double *pi_ratio, double max_ratio, double min_ratio, int num_samples,
-		BOOL *dual_statble_flag)
+		BOOL *dual_statble_flag, mem_arena_type *scratch)
 {
 	int c, cnt;
 	int obs; /* Observation of omega being used */
@@ -492,22 +503,19 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 	printf("Inside SD_cut\n");
 #endif
 
-	if (!(argmax_all = arr_alloc(1, double)))
-		err_msg("Allocation", "SD_cut", "argmax_all");
-	if (!(argmax_new = arr_alloc(1, double)))
-		err_msg("Allocation", "SD_cut", "argmax_new");
-	if (!(argmax_old = arr_alloc(1, double)))
-		err_msg("Allocation", "SD_cut", "argmax_old");
+	argmax_all = scratch_alloc(scratch, 1, double);
+	argmax_new = scratch_alloc(scratch, 1, double);
+	argmax_old = scratch_alloc(scratch, 1, double);
 
 	/* by Yifan 02/02/12 */
 	if (cut->is_incumbent)
 	{
-		if (!(beta = arr_alloc(num->mast_cols+1, double))) /* Yifan 03/04/2012 Modified*/
-			err_msg("Allocation", "SD_cut", "beta");
-		if (!(cut->subobj_omega = arr_alloc(omega->most+1, double)))
-			err_msg("Allocation", "SD_cut", "subobj_omega");
-		if (!(cut->subobj_freq = arr_alloc(omega->most+1, int)))
-			err_msg("Allocation", "SD_cut", "subobj_freq");
+		beta = scratch_alloc(scratch, num->mast_cols+1, double); /* Yifan 03/04/2012 Modified*/
+		/* Sized as free_cut() gives them back; omega->most is omega_cnt here */
+		cut->subobj_omega = (double *) cut_buf_get(sd_global->cut_slab,
+				cut->omega_cnt + 1, sizeof(double));
+		cut->subobj_freq = (int *) cut_buf_get(sd_global->cut_slab,
+				cut->omega_cnt + 1, sizeof(int));
 
 	}
 
@@ -518,8 +526,7 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 		pi_eval_flag = TRUE; //modified by Yifan for testing
 
 	/* Need to store  Pi x Tbar x X independently of observation loop */
-	if (!(pi_Tbar_x = arr_alloc(sigma->cnt, double)))
-		err_msg("Allocation", "SD_cut", "pi_Tbar_x");
+	pi_Tbar_x = scratch_alloc(scratch, sigma->cnt, double);
     
     
 	/* Calculate (Pi x Tbar) x X by mult. each VxT by X, one at a time */
@@ -534,6 +541,11 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 
 	/* Yifan 03/20/2012 Test for omega issues*/
 	for (obs = 0; obs < omega->most; obs++)
+	{
+		/* Read a chunk ahead when delta is kept on disk */
+		if (!(obs % DELTA_CHUNK))
+			prefetch_delta(delta, sigma, omega, obs + DELTA_CHUNK);
+
 		if (valid_omega_idx(omega, obs))
 		{
 			/* For each observation, find the Pi which maximizes height at X. */
@@ -577,7 +589,8 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 				istar = compute_istar(obs, cut, sigma, delta, Xvect, num,
 						pi_Tbar_x, argmax_all, pi_eval_flag, num_samples);
 
-			cut->istar[obs] = istar.sigma;
+			set_istar(sd_global->cut_slab, cut, obs, istar.sigma);
+			sigma->last[istar.sigma] = num_samples;
 
 			/* by Yifan 02/02/12 */
 			if (cut->is_incumbent)
@@ -615,6 +628,7 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 						* omega->weight[obs];
 
 		}
+	}
 
 	if (pi_eval_flag == TRUE)
 	{
@@ -659,14 +673,6 @@ void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 	for (c = 1; c <= num->mast_cols; c++)
 		cut->beta[c] /= num_samples;
 
-	mem_free(pi_Tbar_x);
-	mem_free(argmax_all);
-	mem_free(argmax_new);
-	mem_free(argmax_old);
-	if (cut->is_incumbent)
-	{
-		mem_free(beta);
-	}
 #ifdef TRACE
 	printf("Exiting SD_cut\n");
 #endif
@@ -690,8 +696,7 @@ int FEA_cut(sdglobal_type* sd_global, cell_type *cell, soln_type *soln,
 	last_omega = omega->most - 1; /* The most recent omega generated */
 	cut_cnt = cell->feasible_cuts_pool->cnt;
 
-	if (!(beta = arr_alloc(num->mast_cols+1, double)))
-		err_msg("Allocation", "SD_cut", "beta");
+	beta = scratch_alloc(cell->scratch, num->mast_cols+1, double);
 
 	/* Adds feasibility cuts using old Pi's */
 	if (new_omega)
@@ -750,7 +755,7 @@ int FEA_cut(sdglobal_type* sd_global, cell_type *cell, soln_type *soln,
 			beta[delta->col[c]] += delta->val[del_pi][last_omega].T[c];
 		cut_cnt = add_to_cutpool(sd_global, &alpha, beta, cell, soln,
 				num->mast_cols);
-	}mem_free(beta);
+	}
 #ifdef TRACE
 	printf("Exiting FEA_cut\n");
 #endif
@@ -783,20 +788,8 @@ int add_to_cutpool(sdglobal_type* sd_global, double *alpha, double *beta,
 			}
 		}
 	}
-	cut = (one_cut *) mem_malloc (sizeof(one_cut));
-	cut->cut_obs = cell->k;
-	cut->omega_cnt = s->omega->most;
-	cut->slack_cnt = 0;
-	cut->is_incumbent = FALSE;
-
-	if (!(cut->istar = arr_alloc(s->omega->most, int)))
-		err_msg("Allocation", "add_to_cutpool", "istar");
-
-	if (!(cut->beta = arr_alloc(mast_cols+1, double)))
-		err_msg("Allocation", "add_to_cutpool", "beta");
-
-	cut->subfeaflag = FALSE;
-
+	cut = new_fea_cut(cell->feasible_cuts_pool->slab, s->omega->most, cell->k,
+			istar_width(cell->feasible_sigma->cnt - 1));
 	cut->alpha = *alpha;
 
 	for (cnt = 0; cnt <= mast_cols; cnt++)
@@ -929,7 +922,7 @@ i_type compute_istar(int obs, one_cut *cut, sigma_type *sigma,
 	double arg;
 //  double	argmax;             //modified by Yifan to return argmax value 09/22/2011
 	int sig_pi, del_pi;
-	int c, new_pisz;
+	int new_pisz;
 	i_type ans;
 
 #ifdef LOOP
@@ -956,15 +949,8 @@ i_type compute_istar(int obs, one_cut *cut, sigma_type *sigma,
 		{
 			/* Find the row in delta corresponding to this row in sigma */
 			del_pi = sigma->lamb[sig_pi];
-
-			/* Start with (Pi x Rbar) + (Pi x Romega) + (Pi x Tbar) x X */
-			arg = sigma->val[sig_pi].R + delta->val[del_pi][obs].R
-					- Pi_Tbar_X[sig_pi];
-
-			/* Subtract (Pi x Tomega) x X. Multiply only non-zero VxT values */
-
-			for (c = 1; c <= num->rv_cols; c++)
-				arg -= delta->val[del_pi][obs].T[c] * Xvect[delta->col[c]];
+			arg = istar_arg(sigma, delta, num, Xvect, Pi_Tbar_X, sig_pi, obs,
+					*argmax);
 
 #ifdef LOOP
 			print_sigma(sigma, num, sig_pi);
@@ -1002,7 +988,7 @@ i_type compute_new_istar(int obs, one_cut *cut, sigma_type *sigma,
 {
 	double arg;
 	int sig_pi, del_pi;
-	int c, new_pisz;
+	int new_pisz;
 	i_type ans;
 	ans.sigma = 0;
 	ans.delta = 0;
@@ -1021,14 +1007,8 @@ i_type compute_new_istar(int obs, one_cut *cut, sigma_type *sigma,
 		{
 			/* Find the row in delta corresponding to this row in sigma */
 			del_pi = sigma->lamb[sig_pi];
-
-			/* Start with (Pi x Rbar) + (Pi x Romega) + (Pi x Tbar) x X */
-			arg = sigma->val[sig_pi].R + delta->val[del_pi][obs].R
-					- Pi_Tbar_X[sig_pi];
-
-			/* Subtract (Pi x Tomega) x X. Multiply only non-zero VxT values */
-			for (c = 1; c <= num->rv_cols; c++)
-				arg -= delta->val[del_pi][obs].T[c] * Xvect[delta->col[c]];
+			arg = istar_arg(sigma, delta, num, Xvect, Pi_Tbar_X, sig_pi, obs,
+					*argmax);
 
 #ifdef LOOP
 			print_sigma(sigma, num, sig_pi);
@@ -1054,9 +1034,58 @@ i_type compute_new_istar(int obs, one_cut *cut, sigma_type *sigma,
 	return ans;
 }
 
+/***********************************************************************\
+** This function returns the height at X of the Pi in row _sig_pi_ of
+ ** sigma for observation _obs_:  (Pi x Rbar) + (Pi x Romega) less
+ ** (Pi x Tbar) x X and (Pi x Tomega) x X.  With SD_FLOAT, the height is
+ ** first summed in single precision, along with a bound on its rounding
+ ** error.  Only a Pi which may come within that bound of _argmax_ is
+ ** summed again in double, so compute_istar() picks the same Pi the
+ ** double sum would, and the heights it returns are double sums.
+ \***********************************************************************/
+double istar_arg(sigma_type *sigma, delta_type *delta, num_type *num,
+		vector Xvect, vector Pi_Tbar_X, int sig_pi, int obs, double argmax)
+{
+	pi_R_T_type *d;
+	double arg;
+	int c;
+#ifdef SD_FLOAT
+	float fast, term, mag;
+#endif
+
+	d = &delta->val[sigma->lamb[sig_pi]][obs];
+
+#ifdef SD_FLOAT
+	fast = sigma->val[sig_pi].R + d->R - (float) Pi_Tbar_X[sig_pi];
+	mag = fabsf(sigma->val[sig_pi].R) + fabsf(d->R)
+			+ fabsf((float) Pi_Tbar_X[sig_pi]);
+	for (c = 1; c <= num->rv_cols; c++)
+	{
+		term = d->T[c] * (float) Xvect[delta->col[c]];
+		fast -= term;
+		mag += fabsf(term);
+	}
+
+	/* Each of the n+3 roundings is within FLT_EPSILON/2 of mag */
+	if (fast + (num->rv_cols + 3) * FLT_EPSILON * mag < argmax)
+		return fast;
+#endif
+
+	/* Start with (Pi x Rbar) + (Pi x Romega) + (Pi x Tbar) x X */
+	arg = sigma->val[sig_pi].R + d->R - Pi_Tbar_X[sig_pi];
+
+	/* Subtract (Pi x Tomega) x X. Multiply only non-zero VxT values */
+	for (c = 1; c <= num->rv_cols; c++)
+		arg -= d->T[c] * Xvect[delta->col[c]];
+
+	return arg;
+}
+
 /***********************************************************************\
 ** This function will remove the oldest cut whose corresponding dual
  ** variable is zero (thus, a cut which was slack in last solution).
+ ** It is only called from add_cut(), so the master row of the removed
+ ** cut is released for the new cut rather than deleted.
  \***********************************************************************/
 void reduce_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *cell, soln_type *s)
 {
@@ -1069,9 +1098,9 @@ void reduce_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *cell, soln_t
 	printf("Inside reduce_cuts\n");
 #endif
 
-	/* Original rows and all the added cuts.  The eta row isn't needed */
-	dual = arr_alloc(p->num->mast_rows+cell->cuts->cnt+1, double);
-	get_dual(dual, cell->master, p->num, p->num->mast_rows + cell->cuts->cnt);
+	/* Original rows and all the cut rows, optimality and feasibility */
+	dual = arr_alloc(p->num->mast_rows+cell->row_cnt+1, double);
+	get_dual(dual, cell->master, p->num, p->num->mast_rows + cell->row_cnt);
 
 	min_cut_obs = cell->k;
 	oldest_cut = cell->cuts->cnt;
@@ -1120,10 +1149,7 @@ void reduce_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *cell, soln_t
 #endif
 
 	if (cell->cuts->val[oldest_cut]->subfeaflag == TRUE)
-	{
-		drop_cut(oldest_cut, p, cell, s);
-		decrease_feacut_rownum(cell);
-	}
+		release_cut(oldest_cut, p, cell, s);
 
 	mem_free(dual);
 }
@@ -1145,13 +1171,17 @@ void thin_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *cell, soln_typ
 #endif
 
 	/* 
-	 ** Get the dual solution to master, particularly for cut constraints 
+	 ** Get the dual solution to master, particularly for cut constraints.
+	 ** Dropping a cut renumbers the rows after it, so the dual of every
+	 ** cut is picked out (through its row_num) before any cut is dropped.
 	 */
-	if (!(dual = arr_alloc(p->num->mast_rows+cell->cuts->cnt+1, double)))
+	if (!(dual = arr_alloc(p->num->mast_rows+cell->row_cnt+1, double)))
 		err_msg("Allocation", "thin_cuts", "dual");
-	get_dual(dual, cell->master, p->num,
-			p->num->mast_rows + cell->cuts->cnt + cell->feasible_cuts_added->cnt);
-	pi = dual + p->num->mast_rows;
+	if (!(pi = arr_alloc(cell->cuts->cnt+1, double)))
+		err_msg("Allocation", "thin_cuts", "pi");
+	get_dual(dual, cell->master, p->num, p->num->mast_rows + cell->row_cnt);
+	for (cnt = 0; cnt < cell->cuts->cnt; cnt++)
+		pi[cnt] = dual[cell->cuts->val[cnt]->row_num + 1];
 
 	/* 
 	 ** For every cut, check its dual.  If it is zero, increment slack_cnt
@@ -1177,72 +1207,221 @@ void thin_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *cell, soln_typ
 	/* It better not be... re-form it at least! */
 	/* Here, you reset the slack_cnt of the incumbent to zero every time */
 
+	mem_free(pi);
 	mem_free(dual);
 }
 
+/***********************************************************************\
+** The rows of the master after the original mast_rows constraints hold
+ ** the cuts, optimality and feasibility alike, in the order they were
+ ** placed there.  cell->cut_row maps each of these rows to its cut
+ ** (cut_row[r] is the cut in row mast_rows + r), while each cut records
+ ** its own row in row_num.  A cut keeps its row for as long as it stays
+ ** in the master: new cuts are appended, or take over a row released by
+ ** release_cut(), and no other cut is ever removed and re-added.
+ **
+ ** This function builds the table for a freshly copied master, whose
+ ** cuts occupy the rows right after the original constraints.
+ \***********************************************************************/
+void init_cut_rows(cell_type *cell, num_type *num)
+{
+	int idx;
+
+	cell->row_cnt = 0;
+	cell->free_row = -1;
+	for (idx = 0; idx < cell->cuts->cnt; idx++)
+		append_cut_row(cell, num, cell->cuts->val[idx]);
+}
+
+/***********************************************************************\
+** This function records that _cut_ has just been added as the last row
+ ** of the master, growing the row table if necessary.
+ \***********************************************************************/
+void append_cut_row(cell_type *cell, num_type *num, one_cut *cut)
+{
+	if (cell->row_cnt >= cell->row_max)
+	{
+		cell->row_max = 2 * cell->row_max + 1;
+		if (!(cell->cut_row = (one_cut **) mem_realloc(cell->cut_row,
+				cell->row_max * sizeof(one_cut *))))
+			err_msg("Allocation", "append_cut_row", "cell->cut_row");
+		if (!(cell->cut_beta = (double *) mem_realloc(cell->cut_beta,
+				cell->row_max * num->mast_cols * sizeof(double))))
+			err_msg("Allocation", "append_cut_row", "cell->cut_beta");
+		if (!(cell->cut_bx = (double *) mem_realloc(cell->cut_bx,
+				cell->row_max * sizeof(double))))
+			err_msg("Allocation", "append_cut_row", "cell->cut_bx");
+	}
+
+	cut->row_num = num->mast_rows + cell->row_cnt;
+	set_cut_row(cell, num, cell->row_cnt++, cut);
+}
+
+/************************************************************************\
+** This function places _cut_ in slot _r_ of the row table.  Its beta
+ ** is copied into the contiguous beta matrix, and its product with the
+ ** point of the cached beta x X vector is evaluated, so that the cache
+ ** stays valid without a full refresh.
+ \***********************************************************************/
+void set_cut_row(cell_type *cell, num_type *num, int r, one_cut *cut)
+{
+	double *row = cell->cut_beta + r * num->mast_cols;
+	int idx;
+
+	cell->cut_row[r] = cut;
+	cell->cut_bx[r] = 0.0;
+	for (idx = 0; idx < num->mast_cols; idx++)
+	{
+		row[idx] = cut->beta[idx + 1];
+		cell->cut_bx[r] += row[idx] * cell->bx_x[idx + 1];
+	}
+}
+
+/************************************************************************\
+** This function computes bx[r] = beta x X for every cut row r in a
+ ** single pass over the contiguous beta matrix.
+ \***********************************************************************/
+void cut_rows_times_x(cell_type *cell, num_type *num, vector X, double *bx)
+{
+	double *row = cell->cut_beta;
+	double sum;
+	int r, idx;
+
+	for (r = 0; r < cell->row_cnt; r++, row += num->mast_cols)
+	{
+		sum = 0.0;
+		for (idx = 0; idx < num->mast_cols; idx++)
+			sum += row[idx] * X[idx + 1];
+		bx[r] = sum;
+	}
+}
+
+/************************************************************************\
+** This function makes X the point of the cached beta x X vector, which
+ ** is meant to follow the incumbent.  Nothing is done if X has not
+ ** moved; otherwise the whole vector is re-evaluated.  It returns the
+ ** cached vector, indexed by cut row.
+ \***********************************************************************/
+double *update_cut_bx(cell_type *cell, num_type *num, vector X)
+{
+	if (memcmp(cell->bx_x + 1, X + 1, num->mast_cols * sizeof(double)))
+	{
+		copy_arr(cell->bx_x, X, num->mast_cols);
+		cut_rows_times_x(cell, num, X, cell->cut_bx);
+	}
+
+	return cell->cut_bx;
+}
+
+/***********************************************************************\
+** This function deletes a cut row from the master.  The solver moves
+ ** every later row up by one, so the row table is shifted accordingly
+ ** and the row_num of each of those cuts is decremented.
+ \***********************************************************************/
+void remove_cut_row(cell_type *cell, num_type *num, int row)
+{
+	int r;
+
+	if (!remove_row(cell->master, row))
+	{
+		print_contents(cell->master, "contents.out");
+		err_msg("remove_row", "remove_cut_row", "returned FALSE");
+	}
+
+	for (r = row - num->mast_rows + 1; r < cell->row_cnt; r++)
+	{
+		cell->cut_row[r - 1] = cell->cut_row[r];
+		cell->cut_bx[r - 1] = cell->cut_bx[r];
+		if (cell->cut_row[r - 1])
+			--cell->cut_row[r - 1]->row_num;
+	}
+	r = row - num->mast_rows;
+	memmove(cell->cut_beta + r * num->mast_cols,
+			cell->cut_beta + (r + 1) * num->mast_cols,
+			(cell->row_cnt - r - 1) * num->mast_cols * sizeof(double));
+	--cell->row_cnt;
+
+	if (cell->free_row > row)
+		--cell->free_row;
+}
+
+/***********************************************************************\
+** This function removes a cut from the cut_type structure.  In the 
+ ** cuts->val array, the last cut is swapped into the place of the 
+ ** exiting cut.  Note that it is possible for the incumbent cut to be
+ ** swapped from its current position to that of the dropped cut.  In
+ ** this case, we must update s->incumb_cut appropriately.  The master
+ ** row of the cut is left to the caller.
+ \***********************************************************************/
+void unlist_cut(int cut_idx, cell_type *cell, soln_type *s)
+{
+	free_cut(cell->cuts->slab, cell->cuts->val[cut_idx]);
+	cell->cuts->val[cut_idx] = cell->cuts->val[--cell->cuts->cnt];
+
+	/* Worry about swapping down the incumbent cut */
+	if (s->incumb_cut == cell->cuts->cnt)
+		s->incumb_cut = cut_idx;
+
+	/* What if the incumbent cut was the one that was swapped? */
+	/* But it might be the incumbent cut being dropped ! */
+}
+
 /***********************************************************************\
 ** This function removes a cut from both the cut_type structure and the
- ** master problem constraint matrix.  In the cuts->val array, the last
- ** cut is swapped into the place of the exiting cut.  In the constraint
- ** matrix, the row is deleted, and the row numbers of all constraints
- ** below it are decremented.  Note that it is possible for the incumbent
- ** cut to be swapped from its current position to that of the dropped
- ** cut.  In this case, we must update s->incumb_cut appropriately.
+ ** master problem constraint matrix.  The row is deleted, and the row
+ ** numbers of all cuts below it (optimality and feasibility) are
+ ** decremented through the row table.
  ** 
  ** Cuts can be added and removed from the cuts structure only via
- ** this function and add_cut below.
- **
- ** Should there be a corresponding add_cut, so that the only way to get
- ** a new cut is through add_cut, and the only way to get rid of one 
- ** is through drop_cut... control of data...
+ ** this function, release_cut() and add_cut below.
  \***********************************************************************/
 void drop_cut(int cut_idx, prob_type *p, cell_type *cell, soln_type *s)
 {
 	int row; /* Row number in constraint matrix */
-	int idx;
 
 #ifdef TRACE
 	printf("Inside drop_cut, cut_idx=%d\n", cut_idx);
 #endif
 
-	/* Print all the cuts before droping a cut, for the purpose of cut index
-	 checking. zl 
-	 
-	 print_cut_info(c, p->num, "Before Dropping a cut");
-	 */
-
 	/* Get rid of the old cut */
 	row = cell->cuts->val[cut_idx]->row_num;
-	if (!remove_row(cell->master, row))
-	{
-		print_contents(cell->master, "contents.out");
-		err_msg("remove_row", "drop_cut", "returned FALSE");
-	}
-	free_cut(cell->cuts->val[cut_idx]);
+	remove_cut_row(cell, p->num, row);
 
 #ifdef DEBUG
 	printf("cuts->cnt=%d, row=%d, s->incumb_cut=%d\n",
 			cell->cuts->cnt, row, s->incumb_cut);
 #endif
 
-	/* Update the surviving cuts */
-	cell->cuts->val[cut_idx] = cell->cuts->val[--cell->cuts->cnt];
-	for (idx = 0; idx < cell->cuts->cnt; idx++)
-		if (cell->cuts->val[idx]->row_num > row)
-			--cell->cuts->val[idx]->row_num;
+	unlist_cut(cut_idx, cell, s);
+}
 
-	/* Worry about swapping down the incumbent cut */
-	if (s->incumb_cut == cell->cuts->cnt)
-		s->incumb_cut = cut_idx;
+/***********************************************************************\
+** Like drop_cut(), this function removes a cut from the cut_type
+ ** structure, but its row stays in the master as cell->free_row, to be
+ ** overwritten in place by the very next call to add_cut().  It must
+ ** only be used when a cut is about to be added, since the master is
+ ** not valid for solving while a row is vacant.
+ \***********************************************************************/
+void release_cut(int cut_idx, prob_type *p, cell_type *cell, soln_type *s)
+{
+	int row;
 
-	/* What if the incumbent cut was the one that was swapped? */
-	/* But it might be the incumbent cut being dropped ! */
+#ifdef TRACE
+	printf("Inside release_cut, cut_idx=%d\n", cut_idx);
+#endif
 
-	/* Print all the cuts after dropping a cut, for the purpose of cut index
-	 checking. zl 
+	if (cell->free_row >= 0)
+	{
+		/* Only one row may be vacant at a time */
+		drop_cut(cut_idx, p, cell, s);
+		return;
+	}
 
-	 print_cut_info(c, p->num, "After dropping a cut");
-	 */
+	row = cell->cuts->val[cut_idx]->row_num;
+	cell->cut_row[row - p->num->mast_rows] = NULL;
+	cell->free_row = row;
+
+	unlist_cut(cut_idx, cell, s);
 }
 
 /***********************************************************************\
@@ -1254,9 +1433,10 @@ void drop_cut(int cut_idx, prob_type *p, cell_type *cell, soln_type *s)
  **
  **      Beta x X  +  Eta  >=  Alpha
  **
- ** For now, Eta does not have a coefficient.  All the eta
- ** coefficients (not just the one for this cut) will be updated in
- ** change_eta_col(), before each master program is solved.
+ ** The eta column of the master actually holds zeta = k * (eta - shift)
+ ** (see change_eta_col()), so the row is entered once and for all as
+ **
+ **      Beta x X  +  zeta / cut_obs  >=  Alpha - shift
  ** The function returns TRUE if the cut was successfully added;
  ** FALSE otherwise, in case anyone cares.
  **
@@ -1268,10 +1448,11 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 	int beg_col; /* column where beta coefficients begin */
 	int end_col; /* column where beta coefficients finish */
 	int *coef_col; /* column number of each beta coefficient */
+	double *coef_val; /* beta, with the zeta coefficient in position 0 */
 	int cnt;
 	double rhs; /* rhs value in regularized QP method. */
 //	BOOL reach_max_cuts = TRUE;
-	int row;
+	sparse_matrix coef; /* the cut, when it overwrites a released row */
 	/*int idx;*/
 #ifdef TRACE
 	printf("Inside add_cut\n");
@@ -1289,34 +1470,14 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 //	else
 //		reach_max_cuts = FALSE;
 
-	/*deleate all feasibility cuts so that the new optimality cut can be added to the end of the optimality cuts  Yifan /03/09/2012*/
-	for (cnt = cell->feasible_cuts_added->cnt - 1; cnt >= 0; cnt--)
-	{
-		row = cell->feasible_cuts_added->val[cnt]->row_num;
-		if (!remove_row(cell->master, row))
-		{
-			print_problem(cell->master, "master_errors_notice");
-			print_contents(cell->master, "contents.out");
-			err_msg("remove_row", "drop_cut", "returned FALSE");
-		}
-	}
-
 	/*
 	 ** Initialize an array to specify columns of each coefficient in
-	 ** beta.  The one-norm of beta is temporarily used as the coefficeint on
-	 ** eta (it is assumed to be replaced in the next step in solve_master()).
+	 ** beta.  The zeroth position is the eta column, whose coefficient
+	 ** 1 / cut_obs stays fixed for the life of the cut.
 	 */
 	beg_col = 0;
 	end_col = p->num->mast_cols;
 
-	/*
-	 ** Assign the column values for each element in the beta vector.
-	 ** The zeroth position will be set to the eta column, which will
-	 ** temporarily receive a coefficient equal to the 1-norm of beta.
-	 ** (or whatever is stored in beta[0])
-	 **
-	 ** This ought to be reworked... shouldn't have to alloc every time...
-	 */
 	/*
 	 if (cut->subfeaflag==FALSE) {
 	 for (idx=0; idx<cell->cuts->cnt; idx++) {
@@ -1339,6 +1500,12 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 		coef_col[cnt + 1] = cnt;
 	coef_col[0] = p->num->mast_cols;
 
+	if (!(coef_val = arr_alloc(p->num->mast_cols+1, double)))
+		err_msg("Allocation", "add_cut", "coef_val");
+	for (cnt = 1; cnt <= p->num->mast_cols; cnt++)
+		coef_val[cnt] = cut->beta[cnt];
+	coef_val[0] = 1.0 / (double) cut->cut_obs;
+
 #ifdef DEBUG
 	printf("Adding the row:\n");
 	print_vect(cut->beta, end_col - beg_col, "cell->beta");
@@ -1365,6 +1532,7 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 		rhs = cut->alpha - CxX(cut->beta, s->incumb_x, p->num->mast_cols);
 
 	cut->alpha_incumb = rhs;
+	rhs -= cell->eta_shift;
 
 	/* print out information for checking purpose. zl */
 	/*  fprintf (g_FilePointer, "\n***** In cuts.c -- add_cut() *****\n");
@@ -1374,35 +1542,40 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 	 fprintf (g_FilePointer, "inc_x[%d] = %f,  beta[%d] = %f\n", 
 	 cnt+1, s->incumb_x[cnt+1], cnt+1, cut->beta[cnt+1]); 
 	 */
-	if (!add_row(cell->master, beg_col, end_col, coef_col, cut->beta, GE, rhs))
-		err_msg("LP solver", "add_cut", "ans");
-
-	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
-	cut->row_num = p->num->mast_rows + cell->cuts->cnt;
-
-	/* Since a new optimality cut is added, the row number of every feasibility cut will increase by 1*/
-	for (cnt = 0; cnt < cell->feasible_cuts_added->cnt; cnt++)
+	/*
+	 ** If a cut was just released to make room for this one, overwrite its
+	 ** row in place (every coefficient, since beta is dense, and the rhs).
+	 ** Otherwise append a new row after all the existing cut rows.  Either
+	 ** way, no other row of the master moves.
+	 */
+	if (cell->free_row >= 0)
 	{
-		++cell->feasible_cuts_added->val[cnt]->row_num;
+		coef.cnt = p->num->mast_cols + 1;
+		if (!(coef.row = arr_alloc(coef.cnt, int)))
+			err_msg("Allocation", "add_cut", "coef.row");
+		for (cnt = 0; cnt < coef.cnt; cnt++)
+			coef.row[cnt] = cell->free_row;
+		coef.col = coef_col;
+		coef.val = coef_val;
+		if (!change_coef(cell->master, &coef)
+				|| change_rhside(cell->master, 1, &cell->free_row, &rhs))
+			err_msg("LP solver", "add_cut", "ans");
+		mem_free(coef.row);
+
+		cut->row_num = cell->free_row;
+		set_cut_row(cell, p->num, cell->free_row - p->num->mast_rows, cut);
+		cell->free_row = -1;
 	}
-
-	/* add all the removed feasibility cuts back to the problem after optimality cuts*/
-	for (cnt = 0; cnt < cell->feasible_cuts_added->cnt; cnt++)
+	else
 	{
-		if (sd_global->config.MASTER_TYPE == SDLP)
-			rhs = cell->feasible_cuts_added->val[cnt]->alpha;
-		else
-			rhs = cell->feasible_cuts_added->val[cnt]->alpha
-					- CxX(cell->feasible_cuts_added->val[cnt]->beta, s->incumb_x,
-							p->num->mast_cols) + sd_global->config.FEA_TOLER;
-		/* putshing the solution a little inside the boundary 04/30/2013 Yifan*/
-
-		if (!add_row(cell->master, beg_col, end_col, coef_col,
-				cell->feasible_cuts_added->val[cnt]->beta, GE, rhs))
-			err_msg("LP solver", "add_cut_to_master", "ans");
+		if (!add_row(cell->master, beg_col, end_col, coef_col, coef_val, GE,
+				rhs))
+			err_msg("LP solver", "add_cut", "ans");
+		append_cut_row(cell, p->num, cut);
 	}
 
 	mem_free(coef_col);
+	mem_free(coef_val);
 
 	cell->cuts->val[cell->cuts->cnt] = cut;
 
@@ -1415,7 +1588,7 @@ int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cel
 	return cell->cuts->cnt++;
 }
 
-void add_cut_to_master(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cell, soln_type *s, int idx)
+void add_cut_to_master(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *cell, soln_type *s)
 {
 	int beg_col; /* column where beta coefficients begin */
 	int end_col; /* column where beta coefficients finish */
@@ -1483,9 +1656,7 @@ void add_cut_to_master(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cel
 
 	if (!add_row_to_master(cell->master, beg_col, end_col, coef_col, cut->beta, GE, rhs))
 		err_msg("LP solver", "add_cut", "ans");
-	/* THIS IS A SERIOUS PROBLEM, ROW_NUM IS NOT CORRECT, ONLY ONE CUT IN MASTER!!!*/
-	/* Yifan 03/11/2012 Be careful of this row number*/
-	cut->row_num = p->num->mast_rows + cell->cuts->cnt + idx;
+	append_cut_row(cell, p->num, cut);
 
 	mem_free(coef_col);
 
@@ -1501,82 +1672,74 @@ void add_cut_to_master(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cel
 }
 
 /***********************************************************************\
-** This function allocates memory for the arrays inside a single
- ** cut, and initializes its values accordingly.  The cut structure 
- ** itself is assumed to be already allocated.  Note, each beta 
- ** vector contains room for its one-norm, thought it just gets
- ** filled with zero anyway.
+** This function carves a single cut and its arrays from _slab_, and
+ ** initializes its values accordingly.  Its istars start _width_ bytes
+ ** apiece, as istar_width() gives for the largest index in sigma, so
+ ** set_istar() seldom has to widen them.  Everything the slab hands out
+ ** is zeroed, the beta vector too.  Note, each beta vector contains
+ ** room for its one-norm, thought it just gets filled with zero anyway.
  \***********************************************************************/
-one_cut *new_cut(int num_x, int num_istar, int num_samples)
+one_cut *new_cut(cut_slab_type *slab, int num_istar, int num_samples,
+		int width)
 {
 	one_cut *cut;
-	int cnt;
 
 #ifdef TRACE
 	printf("Inside new_cut\n");
 #endif
 
-	cut = (one_cut *) mem_malloc (sizeof(one_cut));
+	cut = pool_alloc(slab->cut, one_cut);
 	cut->cut_obs = num_samples;
 	cut->omega_cnt = num_istar;
 	cut->slack_cnt = 0;
 	cut->is_incumbent = FALSE; /*added by Yifan 02/02/2012 new cut is by defalut not incumbent*/
 
-	if (!(cut->istar = arr_alloc(num_istar, int)))
-		err_msg("Allocation", "new_cut", "istar");
-
-	if (!(cut->beta = arr_alloc(num_x+1, double)))
-		err_msg("Allocation", "new_cut", "beta");
+	cut->istar_width = width;
+	cut->istar = cut_buf_get(slab, num_istar, cut->istar_width);
+	cut->beta = pool_alloc(slab->beta, double);
 
 	cut->subfeaflag = TRUE;
 
 	cut->alpha = 0.0;
 	cut->alpha_incumb = 0.0;
 
-	for (cnt = 0; cnt <= num_x; cnt++)
-		cut->beta[cnt] = 0.0;
-
 	return cut;
 }
 
 /*added by Yifan to generate the feasibility cut*/
-one_cut *new_fea_cut(int num_x, int num_istar, int num_samples)
+one_cut *new_fea_cut(cut_slab_type *slab, int num_istar, int num_samples,
+		int width)
 {
 	one_cut *cut;
-	int cnt;
 
 #ifdef TRACE
 	printf("Inside new_cut\n");
 #endif
 
-	cut = (one_cut *) mem_malloc (sizeof(one_cut));
+	cut = pool_alloc(slab->cut, one_cut);
 	cut->cut_obs = num_samples;
 	cut->omega_cnt = num_istar;
 	cut->slack_cnt = 0; /*make sure the cut won't be dropped Yifan /08/22/2011*/
 	cut->is_incumbent = FALSE; /*added by Yifan 02/02/2012 new cut is by defalut not incumbent*/
 
-	if (!(cut->istar = arr_alloc(num_istar, int)))
-		err_msg("Allocation", "new_fea_cut", "istar");
-
-	if (!(cut->beta = arr_alloc(num_x+1, double)))
-		err_msg("Allocation", "new_fea_cut", "beta");
+	cut->istar_width = width;
+	cut->istar = cut_buf_get(slab, num_istar, cut->istar_width);
+	cut->beta = pool_alloc(slab->beta, double);
 
 	cut->subfeaflag = FALSE;
 
 	cut->alpha = 0.0;
-	for (cnt = 0; cnt <= num_x; cnt++)
-		cut->beta[cnt] = 0.0;
 
 	return cut;
 }
 
 /***********************************************************************\
-** This function frees the two arrays allocated for a single cut.
+** This function gives a single cut and its arrays back to _slab_.
  ** When the incumbent cut is re-evaluated, its original value
  ** is erased and freed, and replaced by a new one.  Also, before
  ** exiting, the program must free all the cuts.
  \***********************************************************************/
-void free_cut(one_cut *cut)
+void free_cut(cut_slab_type *slab, one_cut *cut)
 {
 
 #ifdef LOOP
@@ -1588,27 +1751,27 @@ void free_cut(one_cut *cut)
 		/*
 		 printf("zl_free_cut ~1\n");
 		 */
-		if (cut->istar)
-			mem_free(cut->istar);
-		if (cut->beta)
-			mem_free(cut->beta);
+		cut_buf_put(slab, cut->istar, cut->omega_cnt, cut->istar_width);
+		pool_free(slab->beta, cut->beta);
 		if (cut->is_incumbent)
 		{
-			mem_free(cut->subobj_omega);
-			mem_free(cut->subobj_freq);
+			cut_buf_put(slab, cut->subobj_omega, cut->omega_cnt + 1,
+					sizeof(double));
+			cut_buf_put(slab, cut->subobj_freq, cut->omega_cnt + 1,
+					sizeof(int));
 		} /*added by Yifan 02/02/12 */
-		mem_free(cut);
+		pool_free(slab->cut, cut);
 	}
 }
 
 /***********************************************************************\
 ** This function allocates memory for a new cut structure.  This entails
  ** the structure itself, and the _val_ array of one_cut pointers inside
- ** the structure.  The actual one_cut structures are allocated 
+ ** the structure.  The actual one_cut structures are carved from _slab_
  ** according to the _num_betas_ parameter, via calls to new_cut().
  ** Note that the allocated cuts are NOT initialized.
  \***********************************************************************/
-cut_type *new_cuts(int num_cuts, int num_x, int num_betas)
+cut_type *new_cuts(cut_slab_type *slab, int num_cuts, int num_betas)
 {
 	cut_type *cuts;
 	int cnt;
@@ -1620,12 +1783,13 @@ cut_type *new_cuts(int num_cuts, int num_x, int num_betas)
 	if (!(cuts = (cut_type *) mem_malloc (sizeof(cut_type))))
 		err_msg("Allocation", "new_cuts", "cuts");
 
-	if (!(cuts->val = arr_alloc(num_cuts, cut_ptr)))
+	if (!(cuts->val = arr_alloc_in(MEM_CUTS, num_cuts, cut_ptr)))
 		err_msg("Allocation", "new_cuts", "cuts->val");
 
+	cuts->slab = slab;
 	cuts->cnt = num_betas;
 	for (cnt = 0; cnt < num_betas && cnt < num_cuts; cnt++)
-		cuts->val[cnt] = new_cut(num_x, 0, 0);
+		cuts->val[cnt] = new_cut(slab, 0, 0, sizeof(signed char));
 
 	return cuts;
 }
@@ -1643,11 +1807,175 @@ void free_cuts(cut_type *cuts)
 #endif
 
 	for (cnt = 0; cnt < cuts->cnt; cnt++)
-		free_cut(cuts->val[cnt]);
+		free_cut(cuts->slab, cuts->val[cnt]);
 	mem_free(cuts->val);
 	mem_free(cuts);
 }
 
+/***********************************************************************\
+** This function creates the slab the cuts of a run are carved from,
+ ** for master programs of _num_x_ columns.  The cuts of a cell are bounded
+ ** by _max_cuts_, and so many beta rows make up a block.  No block is
+ ** allocated until the first cut is requested.
+ \***********************************************************************/
+cut_slab_type *new_cut_slab(int num_x, int max_cuts)
+{
+	cut_slab_type *slab;
+	int k;
+
+#ifdef TRACE
+	printf("Inside new_cut_slab\n");
+#endif
+
+	if (!(slab = (cut_slab_type *) mem_malloc (sizeof(cut_slab_type))))
+		err_msg("Allocation", "new_cut_slab", "slab");
+
+	slab->num_x = num_x;
+	slab->max_cuts = max_cuts;
+	slab->cut = new_mem_pool(sizeof(one_cut), max_cuts, MEM_CUTS);
+	slab->beta = new_mem_pool((num_x + 1) * sizeof(double), max_cuts,
+			MEM_CUTS);
+	for (k = 0; k < SLAB_CLASSES; k++)
+		slab->buf[k] = NULL;
+
+	return slab;
+}
+
+/***********************************************************************\
+** This function releases the slab, and with it every cut it ever
+ ** handed out; the cut structures must not be used past this point.
+ \***********************************************************************/
+void free_cut_slab(cut_slab_type *slab)
+{
+	int k;
+
+	free_mem_pool(slab->cut);
+	free_mem_pool(slab->beta);
+	for (k = 0; k < SLAB_CLASSES; k++)
+		if (slab->buf[k])
+			free_mem_pool(slab->buf[k]);
+	mem_free(slab);
+}
+
+/* This function returns the size class of a buffer of _size_ bytes, or
+ SLAB_CLASSES if it is too long for any */
+int slab_class(size_t size)
+{
+	int k;
+
+	for (k = 0; k < SLAB_CLASSES; k++)
+		if (size <= ((size_t) SLAB_MIN << k))
+			break;
+
+	return k;
+}
+
+/***********************************************************************\
+** This function returns a zeroed buffer for _n_ elements of _size_ bytes
+ ** from the pool of its size class, creating the pool when it is first
+ ** needed.  Buffers longer than the largest class come from the heap.
+ ** The buffer must be given back with the same _n_ and _size_.
+ \***********************************************************************/
+void *cut_buf_get(cut_slab_type *slab, int n, size_t size)
+{
+	void *buf;
+	size_t bytes;
+	int k;
+
+	k = slab_class(n * size);
+	if (k == SLAB_CLASSES)
+	{
+		if (!(buf = mem_calloc(n, size)))
+			err_msg("Allocation", "cut_buf_get", "buf");
+		return buf;
+	}
+
+	if (!slab->buf[k])
+	{
+		bytes = (size_t) SLAB_MIN << k;
+		slab->buf[k] = new_mem_pool(bytes, (int) max(1, SCRATCH_SIZE / bytes),
+				MEM_CUTS);
+	}
+
+	return mem_pool_get(slab->buf[k]);
+}
+
+/* This function gives a buffer from cut_buf_get() back to its size class.
+ A NULL buffer is ignored. */
+void cut_buf_put(cut_slab_type *slab, void *buf, int n, size_t size)
+{
+	int k;
+
+	if (!buf)
+		return;
+
+	k = slab_class(n * size);
+	if (k == SLAB_CLASSES)
+		mem_free(buf);
+	else
+		mem_pool_put(slab->buf[k], buf);
+}
+
+/***********************************************************************\
+** This function returns the number of bytes an istar of _pi_ needs.
+ ** Sigma indices and the negative codes (DROPPED, EVICTED) both fit.
+ \***********************************************************************/
+int istar_width(int pi)
+{
+	if (pi <= ISTAR_CHAR)
+		return sizeof(signed char);
+	if (pi <= ISTAR_SHORT)
+		return sizeof(short);
+	return sizeof(int);
+}
+
+/***********************************************************************\
+** This function stores _pi_ as the istar of observation _obs_ in _cut_.
+ ** Should _pi_ not fit the cut's current width, all of its istars are
+ ** first copied into a wider buffer from _slab_, and the old one is given
+ ** back.  Cuts never narrow again, since sigma rarely shrinks by much.
+ \***********************************************************************/
+void set_istar(cut_slab_type *slab, one_cut *cut, int obs, int pi)
+{
+	void *wide;
+	int width, cnt;
+
+	if ((width = istar_width(pi)) > cut->istar_width)
+	{
+		wide = cut_buf_get(slab, cut->omega_cnt, width);
+		for (cnt = 0; cnt < cut->omega_cnt; cnt++)
+			if (width == sizeof(short))
+				((short *) wide)[cnt] = (short) get_istar(cut, cnt);
+			else
+				((int *) wide)[cnt] = get_istar(cut, cnt);
+		cut_buf_put(slab, cut->istar, cut->omega_cnt, cut->istar_width);
+		cut->istar = wide;
+		cut->istar_width = width;
+	}
+
+	if (cut->istar_width == sizeof(signed char))
+		((signed char *) cut->istar)[obs] = (signed char) pi;
+	else if (cut->istar_width == sizeof(short))
+		((short *) cut->istar)[obs] = (short) pi;
+	else
+		((int *) cut->istar)[obs] = pi;
+}
+
+/***********************************************************************\
+** This function copies the istars of _src_ into _dest_, which must have
+ ** been made for the same number of observations, at the width of _src_.
+ \***********************************************************************/
+void copy_istar(cut_slab_type *slab, one_cut *dest, one_cut *src)
+{
+	if (dest->istar_width != src->istar_width)
+	{
+		cut_buf_put(slab, dest->istar, dest->omega_cnt, dest->istar_width);
+		dest->istar_width = src->istar_width;
+		dest->istar = cut_buf_get(slab, dest->omega_cnt, dest->istar_width);
+	}
+	memcpy(dest->istar, src->istar, (size_t) src->omega_cnt * src->istar_width);
+}
+
 /***********************************************************************\
  ** This function allocates memory for a new batch cuts structure.  This entails
  ** the structure itself, and the _batch_ array of _cuts_ pointers inside
@@ -1683,7 +2011,7 @@ void free_bcuts(batch_cut_type *batch_cuts)
 	printf("Inside free_bcuts\n");
 #endif
 	/* Free all cuts structure saved for the compromise problem Yifan 2013/01/17 */
-	for (idx = 0; idx < BATCH_SIZE; idx++)
+	for (idx = 0; idx < batch_cuts->b_size; idx++)
 	{
       if (batch_cuts->batch[idx] != NULL) {
         free_cuts(batch_cuts->batch[idx]);
@@ -1714,7 +2042,7 @@ void print_cut(cut_type *cuts, num_type *num, int idx)
 		printf("%f ", cuts->val[idx]->beta[cnt]);
 	printf("\nistar: ");
 	for (cnt = 0; cnt < cuts->val[idx]->omega_cnt; cnt++)
-		printf("%d ", cuts->val[idx]->istar[cnt]);
+		printf("%d ", get_istar(cuts->val[idx], cnt));
 	printf("\n");
 }
 
@@ -12,15 +12,18 @@
 void SD_cut(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 		omega_type *omega, num_type *num, one_cut *cut, vector Xvect,
 		double *pi_ratio, double max_ratio, double min_ratio, int num_samples,
-		BOOL *dual_statble_flag);
+		BOOL *dual_statble_flag, mem_arena_type *scratch);
 i_type compute_istar(int obs, one_cut *cut, sigma_type *sigma,
 		delta_type *delta, vector Xvect, num_type *num, vector Pi_Tbar_X,
 		double *argmax, BOOL pi_eval, int ictr);
 i_type compute_new_istar(int obs, one_cut *cut, sigma_type *sigma,
 		delta_type *delta, vector Xvect, num_type *num, vector Pi_Tbar_X,
 		double *argmax, int ictr);
-void free_cut(one_cut *cut);
-one_cut *new_fea_cut(int num_x, int num_istar, int num_samples);
+double istar_arg(sigma_type *sigma, delta_type *delta, num_type *num,
+		vector Xvect, vector Pi_Tbar_X, int sig_pi, int obs, double argmax);
+void free_cut(cut_slab_type *slab, one_cut *cut);
+one_cut *new_fea_cut(cut_slab_type *slab, int num_istar, int num_samples,
+		int width);
 int FEA_cut(sdglobal_type* sd_global, cell_type *cell, soln_type *soln,
 		sigma_type *sigma, delta_type *delta, omega_type *omega, num_type *num,
 		int num_samples, BOOL *dual_statble_flag, BOOL new_omega,
@@ -29,11 +32,19 @@ int add_to_cutpool(sdglobal_type* sd_global, double *alpha, double *beta,
 		cell_type *c, soln_type *s, int mast_cols);
 int FEA_cut_check_add(sdglobal_type* sd_global, cell_type *cell,
 		prob_type *prob, soln_type *soln, vector x_k);
-void decrease_feacut_rownum(cell_type *c);
 void update_dual_size(cell_type *c, soln_type *s, prob_type *p);
-cut_type *new_cuts(int num_cuts, int num_x, int num_betas);
-one_cut *new_cut(int num_x, int num_istar, int num_samples);
+cut_type *new_cuts(cut_slab_type *slab, int num_cuts, int num_betas);
+one_cut *new_cut(cut_slab_type *slab, int num_istar, int num_samples,
+		int width);
 void free_cuts(cut_type *cuts);
+cut_slab_type *new_cut_slab(int num_x, int max_cuts);
+void free_cut_slab(cut_slab_type *slab);
+int slab_class(size_t size);
+void *cut_buf_get(cut_slab_type *slab, int n, size_t size);
+void cut_buf_put(cut_slab_type *slab, void *buf, int n, size_t size);
+int istar_width(int pi);
+void set_istar(cut_slab_type *slab, one_cut *cut, int obs, int pi);
+void copy_istar(cut_slab_type *slab, one_cut *dest, one_cut *src);
 void print_cut(cut_type *cuts, num_type *num, int idx);
 void print_cut_info(cell_type *c, num_type *num, char *phrase);
 BOOL stochastic_updates(sdglobal_type* sd_global, cell_type *c,
@@ -51,11 +62,19 @@ void reduce_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s);
 void thin_cuts(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s);
+void init_cut_rows(cell_type *c, num_type *num);
+void append_cut_row(cell_type *c, num_type *num, one_cut *cut);
+void set_cut_row(cell_type *c, num_type *num, int r, one_cut *cut);
+void cut_rows_times_x(cell_type *c, num_type *num, vector X, double *bx);
+double *update_cut_bx(cell_type *c, num_type *num, vector X);
+void remove_cut_row(cell_type *c, num_type *num, int row);
+void unlist_cut(int cnt, cell_type *c, soln_type *s);
 void drop_cut(int cnt, prob_type *p, cell_type *c, soln_type *s);
+void release_cut(int cnt, prob_type *p, cell_type *c, soln_type *s);
 int add_cut(sdglobal_type* sd_global, one_cut *cut, prob_type *p, cell_type *c,
 		soln_type *s);
 void add_cut_to_master(sdglobal_type* sd_global, one_cut *cut, prob_type *p,
-		cell_type *c, soln_type *s, int idx);
+		cell_type *c, soln_type *s);
 batch_cut_type *new_bcuts(prob_type *p, int bsize, batch_cut_type *batch_cuts);
 void free_bcuts(batch_cut_type *bcuts);
 
@@ -11,6 +11,9 @@
  **
  ** calc_delta_row()
  ** calc_delta_col()
+ ** grow_delta()
+ ** place_delta()     // which tiles of a delta on disk stay in memory
+ ** prefetch_delta()
  ** print_delta()
  ** new_delta()
  ** free_delta()
@@ -31,9 +34,11 @@
 #include "soln.h"
 #include "utility.h"
 #include "delta.h"
+#include "lambda.h"
 #include "omega.h"
 #include "log.h"
 #include "sdglobal.h"
+#include <string.h>
 
 /***********************************************************************\
 ** This function calculates a new row in the delta structure, based
@@ -43,12 +48,10 @@
  ** from all previous ones, and thus a new row is warranted.
  \***********************************************************************/
 void calc_delta_row(sdglobal_type* sd_global, delta_type *delta,
-		lambda_type *lambda, omega_type *omega, num_type *num, int pi_idx)
+		lambda_type *lambda, omega_type *omega, num_type *num, int pi_idx,
+		mem_arena_type *scratch)
 {
 	int obs;
-	sparse_vect Romega;
-	sparse_matrix Tomega;
-	vector lamb_pi;
 	vector pi_cross_T;
 
 #ifdef TRACE
@@ -57,18 +60,17 @@ void calc_delta_row(sdglobal_type* sd_global, delta_type *delta,
 
 	if (sd_global->MALLOC)
 	{
-		printf("before init_R_T_omega\n");
+		printf("before get_R_T_omega\n");
 		malloc_verify();
 	}
 
-	/* Initialize all vectors for calculations */
-	init_R_T_omega(&Romega, &Tomega, omega, num);
+	grow_delta(delta, pi_idx, omega->most);
+	delta->val[pi_idx] = pool_alloc(delta->row_pool, pi_R_T_type);
+	delta->tiles[pi_idx] = new_mem_pool(delta->vect_size, DELTA_CHUNK,
+			MEM_DELTA);
+	delta->tiles[pi_idx]->map = delta->map;
 
-	if (!(delta->val[pi_idx] = arr_alloc(num->iter, pi_R_T_type)))
-		err_msg("Allocation", "calc_delta_row", "delta->val");
-
-	lamb_pi = expand_vect(lambda->val[pi_idx], lambda->row, num->rv_rows,
-			num->sub_rows);
+	pi_cross_T = scratch_alloc(scratch, num->rv_cols+1, double);
 
 	/* For all observations, calculate pi X R and pi X T */
 	for (obs = 0; obs < omega->most; obs++)
@@ -77,15 +79,12 @@ void calc_delta_row(sdglobal_type* sd_global, delta_type *delta,
 			get_R_T_omega(sd_global, omega, obs);
 
 			/* Multiply the new dual vector by previous observations of omega */
-			/* Reduce the vector resulting from Pi x T to its sparse form */
-			delta->val[pi_idx][obs].R = PIxR(lamb_pi, &Romega);
-			pi_cross_T = PIxT(lamb_pi, &Tomega, num->mast_cols);
-			delta->val[pi_idx][obs].T = reduce_vect(pi_cross_T, delta->col,
+			delta->val[pi_idx][obs].R = lambda_RT(lambda, pi_idx, omega->RT,
+					pi_cross_T, num->rv_cols);
+			delta->val[pi_idx][obs].T = copy_vect_coef(
+					pool_alloc(delta->tiles[pi_idx], coef_type), pi_cross_T,
 					num->rv_cols);
-			mem_free(pi_cross_T);
 		}
-
-	mem_free(lamb_pi);
 }
 
 /***********************************************************************\
@@ -98,42 +97,69 @@ void calc_delta_row(sdglobal_type* sd_global, delta_type *delta,
  ** from all previous ones, and thus a new column must be calculated.  
  \***********************************************************************/
 void calc_delta_col(sdglobal_type* sd_global, delta_type *delta,
-		lambda_type *lambda, omega_type *omega, num_type *num, int obs)
+		lambda_type *lambda, omega_type *omega, num_type *num, int obs,
+		mem_arena_type *scratch)
 {
 	int pi_idx;
-	sparse_vect Romega;
-	sparse_matrix Tomega;
-	vector lamb_pi;
 	vector pi_cross_T;
 
 #ifdef TRACE
 	printf("Inside calc_delta_col\n");
 #endif
 
-	/* Initialize vectors for calculations */
-	init_R_T_omega(&Romega, &Tomega, omega, num);
 	get_R_T_omega(sd_global, omega, obs);
+	grow_delta(delta, lambda->cnt, omega->most);
+	pi_cross_T = scratch_alloc(scratch, num->rv_cols+1, double);
 
 	/* For all dual vectors, lambda(pi), calculate pi X Romega and pi X Tomega */
 	for (pi_idx = 0; pi_idx < lambda->cnt; pi_idx++)
 	{
-		/* Retrieve a new (sparse) dual vector, and expand it into a full vector */
-		lamb_pi = expand_vect(lambda->val[pi_idx], lambda->row, num->rv_rows,
-				num->sub_rows);
-
-		/* Multiply the dual vector by the observation of Romega and Tomega */
-		/* Reduce PIxT from its full vector form into a sparse vector */
-		delta->val[pi_idx][obs].R = PIxR(lamb_pi, &Romega);
-		pi_cross_T = PIxT(lamb_pi, &Tomega, num->mast_cols);
-		delta->val[pi_idx][obs].T = reduce_vect(pi_cross_T, delta->col,
+		/* Multiply the nonzero duals by the observation of Romega and Tomega */
+		delta->val[pi_idx][obs].R = lambda_RT(lambda, pi_idx, omega->RT,
+				pi_cross_T, num->rv_cols);
+		delta->val[pi_idx][obs].T = copy_vect_coef(
+				pool_alloc(delta->tiles[pi_idx], coef_type), pi_cross_T,
 				num->rv_cols);
-		mem_free(pi_cross_T);
-		mem_free(lamb_pi);
-		/*
-		 ** Sloppy and slow to alloc & free pi_cross_T and lamb_pi every iteration!
-		 */
+	}
+}
+
+/***********************************************************************\
+** This function makes sure each row of the delta structure has room for
+ ** _most_ observations.  When it does not, the first _rows_ rows are
+ ** moved to rows at least twice as long, carved from a new pool, and the
+ ** old pool is released; so rows grow with the observations actually
+ ** seen, a handful of times over the run, and are still indexed directly.
+ \***********************************************************************/
+void grow_delta(delta_type *delta, int rows, int most)
+{
+	mem_pool_type *pool;
+	pi_R_T_type *row;
+	int len, r;
+
+	if (most <= delta->row_len)
+		return;
+	if (most > delta->row_max)
+		err_msg("Size", "grow_delta", "most");
 
+#ifdef TRACE
+	printf("Inside grow_delta\n");
+#endif
+
+	len = max(delta->row_len, DELTA_CHUNK);
+	while (len < most)
+		len *= 2;
+	len = min(len, delta->row_max);
+
+	pool = new_mem_pool(len * sizeof(pi_R_T_type), 4, MEM_DELTA);
+	for (r = 0; r < rows; r++)
+	{
+		row = pool_alloc(pool, pi_R_T_type);
+		memcpy(row, delta->val[r], delta->row_len * sizeof(pi_R_T_type));
+		delta->val[r] = row;
 	}
+	free_mem_pool(delta->row_pool);
+	delta->row_pool = pool;
+	delta->row_len = len;
 }
 
 /***********************************************************************\
@@ -142,25 +168,22 @@ void calc_delta_col(sdglobal_type* sd_global, delta_type *delta,
  ** been deleted, the last row in the delta matrix is copied into its
  ** place.
  \***********************************************************************/
-void drop_delta_row(delta_type *delta, lambda_type *lambda, omega_type *omega,
-		int row)
+void drop_delta_row(delta_type *delta, lambda_type *lambda, int row)
 {
-	int col;
-
 #ifdef TRACE
 	printf("Inside drop_delta_row()\n");
 #endif
 
-	/* Free each calculation of Pi x T */
-	for (col = 0; col < omega->most; col++)
-		if (valid_omega_idx(omega, col))
-			mem_free(delta->val[row][col].T);
+	/* Free each calculation of Pi x T, all at once with the row's tiles */
+	free_mem_pool(delta->tiles[row]);
 
 	/* Free the specified row */
-	mem_free(delta->val[row]);
+	pool_free(delta->row_pool, delta->val[row]);
 
 	/* Copy the last row into the position of the vacated row */
 	delta->val[row] = delta->val[lambda->cnt];
+	delta->tiles[row] = delta->tiles[lambda->cnt];
+	delta->tiles[lambda->cnt] = NULL;
 }
 
 /***********************************************************************\
@@ -179,19 +202,72 @@ void drop_delta_col(delta_type *delta, lambda_type *lambda, int col)
 
 	for (row = 0; row < lambda->cnt; row++)
 	{
-		mem_free(delta->val[row][col].T);
+		pool_free(delta->tiles[row], delta->val[row][col].T);
 		delta->val[row][col].T = NULL;
 		delta->val[row][col].R = 0.0;
 	}
 }
 
 /***********************************************************************\
-**
+** This function places the tiles of a delta kept on disk.  The rows of
+ ** duals which compute_istar() picked in the last DELTA_HOT iterations,
+ ** as sigma->last records, or which are istars of a current cut, and so
+ ** will be read when the cuts are reformed, are read ahead.  The others
+ ** are marked cold, so the system pages them out before anything else.
  \***********************************************************************/
+void place_delta(delta_type *delta, lambda_type *lambda, sigma_type *sigma,
+		cut_type *cuts, int iter, mem_arena_type *scratch)
+{
+	mem_block_type *block;
+	BOOL *hot;
+	int row, cnt, obs, pi;
+
+	if (!delta->map)
+		return;
+
+#ifdef TRACE
+	printf("Inside place_delta()\n");
+#endif
+
+	hot = scratch_alloc(scratch, lambda->cnt, BOOL);
+	for (cnt = 0; cnt < sigma->cnt; cnt++)
+		if (sigma->last[cnt] >= iter - DELTA_HOT)
+			hot[sigma->lamb[cnt]] = TRUE;
+	for (cnt = 0; cnt < cuts->cnt; cnt++)
+		for (obs = 0; obs < cuts->val[cnt]->omega_cnt; obs++)
+			if ((pi = get_istar(cuts->val[cnt], obs)) >= 0)
+				hot[sigma->lamb[pi]] = TRUE;
+
+	for (row = 0; row < lambda->cnt; row++)
+		for (block = delta->tiles[row]->blocks; block; block = block->next)
+			mem_advise(block, mem_round(sizeof(mem_block_type)) + block->used,
+					hot[row]);
+}
 
 /***********************************************************************\
-**
+** This function reads ahead, for a delta kept on disk, the tiles which
+ ** hold observation _obs_ for every dual in sigma.  SD_cut() calls it a
+ ** chunk of observations ahead of the one it is at, since the tiles of a
+ ** row hold observations mostly in the order they were seen.
  \***********************************************************************/
+void prefetch_delta(delta_type *delta, sigma_type *sigma, omega_type *omega,
+		int obs)
+{
+	int cnt;
+
+	if (!delta->map)
+		return;
+
+	/* Start at the first observation of the chunk that is still there */
+	while (obs < omega->most && !valid_omega_idx(omega, obs))
+		obs++;
+	if (obs >= omega->most)
+		return;
+
+	for (cnt = 0; cnt < sigma->cnt; cnt++)
+		mem_advise(delta->val[sigma->lamb[cnt]][obs].T,
+				DELTA_CHUNK * mem_round(delta->vect_size), TRUE);
+}
 
 /***********************************************************************\
 ** This function is intended for debugging purposes.  It prints
@@ -218,9 +294,14 @@ void print_delta(delta_type *delta, num_type *num, int idx, int obs)
  ** values.  (they are only filled as they are produced).
  ** Not even the arrays of pi_R_T_types are allocated, as this also
  ** occurs in calc_delta_row().  However, the column coordinates of the
- ** eventual multiplications are initialized, since they are known.
+ ** eventual multiplications are initialized, since they are known,
+ ** and the pool the rows will come from is set up; the pi X T vectors
+ ** (_num_rv_cols_ entries) come from the tiles of each row, in a file
+ ** when _disk_ is set.  The rows start with room for DELTA_CHUNK
+ ** observations and grow as they come, up to _num_obs_.
  \***********************************************************************/
-delta_type *new_delta(int num_iter, coord_type *coord)
+delta_type *new_delta(int num_iter, int num_obs, int num_rv_cols,
+		coord_type *coord, BOOL disk)
 {
 	delta_type *d;
 
@@ -231,9 +312,20 @@ delta_type *new_delta(int num_iter, coord_type *coord)
 	if (!(d = (delta_type *) mem_malloc (sizeof(delta_type))))
 		err_msg("Allocation", "new_delta", "d");
 
-	if (!(d->val = arr_alloc(num_iter, pi_R_T_type*)))
+	if (!(d->val = arr_alloc_in(MEM_DELTA, num_iter, pi_R_T_type*)))
 		err_msg("Allocation", "new_delta", "d->val");
 
+	d->row_max = num_obs;
+	d->row_len = min(DELTA_CHUNK, num_obs);
+	d->row_pool = new_mem_pool(d->row_len * sizeof(pi_R_T_type), 4,
+			MEM_DELTA);
+	if (!(d->tiles = arr_alloc_in(MEM_DELTA, num_iter, mem_pool_type*)))
+		err_msg("Allocation", "new_delta", "d->tiles");
+	d->max_rows = num_iter;
+	d->vect_size = (num_rv_cols + 1) * sizeof(coef_type);
+	d->map = NULL;
+	if (disk)
+		d->map = new_mem_map(DELTA_CHUNK * mem_round(d->vect_size));
 	d->col = coord->delta_col;
 
 	return d;
@@ -241,26 +333,26 @@ delta_type *new_delta(int num_iter, coord_type *coord)
 
 /***********************************************************************\
 ** This function frees all the data associated with the delta
- ** three-dimensional matrix.  Since the size of the matrix is
- ** determined by the number of distinct realizations and dual
- ** vectors, these counts must be passed in.  Note that delta->col
+ ** three-dimensional matrix.  Its rows and pi X T vectors all go at
+ ** once with the pools they came from.  Note that delta->col
  ** is not freed, since it belongs to the coord structure, and may
  ** be used by the next cell / soln.
  \***********************************************************************/
-void free_delta(delta_type *delta, omega_type *omega, int num_lamb)
+void free_delta(delta_type *delta)
 {
-	int cnt, idx;
+	int row;
 
 #ifdef TRACE
 	printf("Inside free_delta\n");
 #endif
 
-	for (cnt = 0; cnt < num_lamb; cnt++)
-	{
-		for (idx = 0; idx < omega->most; idx++)
-			if (valid_omega_idx(omega, idx))
-				mem_free(delta->val[cnt][idx].T);
-		mem_free(delta->val[cnt]);
-	}mem_free(delta->val);
+	for (row = 0; row < delta->max_rows; row++)
+		if (delta->tiles[row])
+			free_mem_pool(delta->tiles[row]);
+	mem_free(delta->tiles);
+	if (delta->map)
+		free_mem_map(delta->map);
+	free_mem_pool(delta->row_pool);
+	mem_free(delta->val);
 	mem_free(delta);
 }
@@ -9,15 +9,21 @@
 #define DELTA_H_
 #include "sdglobal.h"
 
-delta_type *new_delta(int num_iter, coord_type *coord);
+delta_type *new_delta(int num_iter, int num_obs, int num_rv_cols,
+		coord_type *coord, BOOL disk);
 void calc_delta_col(sdglobal_type* sd_global, delta_type *delta, lambda_type *lambda, omega_type *omega,
-		num_type *num, int obs);
+		num_type *num, int obs, mem_arena_type *scratch);
 void calc_delta_row(sdglobal_type* sd_global, delta_type *delta,
-		lambda_type *lambda, omega_type *omega, num_type *num, int pi_idx);
+		lambda_type *lambda, omega_type *omega, num_type *num, int pi_idx,
+		mem_arena_type *scratch);
+void grow_delta(delta_type *delta, int rows, int most);
+void place_delta(delta_type *delta, lambda_type *lambda, sigma_type *sigma,
+		cut_type *cuts, int iter, mem_arena_type *scratch);
+void prefetch_delta(delta_type *delta, sigma_type *sigma, omega_type *omega,
+		int obs);
 void drop_delta_col(delta_type *delta, lambda_type *lambda, int col);
-void drop_delta_row(delta_type *delta, lambda_type *lambda, omega_type *omega,
-		int row);
-void free_delta(delta_type *delta, omega_type *omega, int num_lamb);
+void drop_delta_row(delta_type *delta, lambda_type *lambda, int row);
+void free_delta(delta_type *delta);
 void print_delta(delta_type *delta, num_type *num, int idx, int obs);
 
 #endif /* DELTA_H_ */
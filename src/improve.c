@@ -22,9 +22,13 @@
 #include "utility.h"
 #include "theta.h"
 #include "improve.h"
+#include "cuts.h"
 #include "omega.h"
+#include "log.h"
 #include "sdglobal.h"
 
+#include <string.h>
+
 /***********************************************************************\ 
  ** This function determines whether the "stagewise descent property" is 
  ** satisified.  If the current approximation of f_k gives a lower difference
@@ -64,6 +68,7 @@ BOOL check_improvement(sdglobal_type* sd_global, prob_type *prob,
 	/*soln->incumb_est = f_k(soln->incumb_x, prob->c, cell->cuts,
 	 cell->theta, prob->num, cell, &best);*/
 
+	update_cut_bx(cell, prob->num, soln->incumb_x);
 	soln->incumb_est = max_cut_height(sd_global, cell->cuts, soln->incumb_x,
 			cell, prob->num);
 	soln->incumb_est += CxX(prob->c, soln->incumb_x, prob->num->mast_cols);
@@ -223,6 +228,7 @@ BOOL new_check_improvement(sdglobal_type* sd_global, prob_type *prob,
 	/*soln->incumb_est = f_k(soln->incumb_x, prob->c, cell->cuts,
 	 cell->theta, prob->num, cell, &best);*/
 
+	update_cut_bx(cell, prob->num, soln->incumb_x);
 	soln->incumb_est = max_cut_height(sd_global, cell->cuts, soln->incumb_x,
 			cell, prob->num);
 	soln->incumb_est += CxX(prob->c, soln->incumb_x, prob->num->mast_cols);
@@ -301,7 +307,7 @@ void new_incumbent(prob_type *p, cell_type *c, soln_type *s, double est)
 			if (valid_omega_idx(s->omega, obs))
 			{
 				/* Find the pi from the cut's argmax for this observation */
-				i.sigma = c->cuts->val[s->incumb_cut]->istar[obs];
+				i.sigma = get_istar(c->cuts->val[s->incumb_cut], obs);
 				i.delta = c->sigma->lamb[i.sigma];
 
 				/*
@@ -336,21 +342,40 @@ void new_incumbent(prob_type *p, cell_type *c, soln_type *s, double est)
 }
 
 /* This function loops through a set of cuts and find the highest cut height
- at the specified position x */
+ at the specified position x.  The cuts must be those of the cell's master;
+ their Beta x X products come from the cell's cache when X is the point it
+ was last refreshed at (see update_cut_bx()), and from one pass over the
+ cell's beta matrix otherwise. */
 double max_cut_height(sdglobal_type* sd_global, cut_type *cuts, vector X,
 		cell_type *c, num_type *num)
 {
 	double Sm;
 	double ht;
+	double *bx;
 	int cnt;
 
-	Sm = cut_height(sd_global, cuts->val[0], X, c, num);
+	if (memcmp(c->bx_x + 1, X + 1, num->mast_cols * sizeof(double)))
+	{
+		if (!(bx = arr_alloc(c->row_cnt+1, double)))
+			err_msg("Allocation", "max_cut_height", "bx");
+		cut_rows_times_x(c, num, X, bx);
+	}
+	else
+		bx = c->cut_bx;
+
+	Sm = cut_height_bx(sd_global, cuts->val[0],
+			bx[cuts->val[0]->row_num - num->mast_rows], c);
 	for (cnt = 1; cnt < cuts->cnt; cnt++)
 	{
-		ht = cut_height(sd_global, cuts->val[cnt], X, c, num);
+		ht = cut_height_bx(sd_global, cuts->val[cnt],
+				bx[cuts->val[cnt]->row_num - num->mast_rows], c);
 		if (Sm < ht)
 			Sm = ht;
 	}
+
+	if (bx != c->cut_bx)
+		mem_free(bx);
+
 	return Sm;
 }
 
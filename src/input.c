@@ -1660,6 +1660,23 @@ int load_config(sdglobal_type* sd_global, BOOL read_seeds, BOOL read_iters)
 	sd_global->config.SUB_LB_CHECK  = 0;			/* Subprob LB check. 0 for no check.
                                        zl 09/20/05 */
 	sd_global->config.AUTO_SEED     = 0;
+	sd_global->config.NUM_THREADS   = 1;
+	sd_global->config.SEQ_TEST      = 0;
+	sd_global->config.SEQ_DELTA     = 0.03;
+	sd_global->config.SEQ_ERROR     = 0.05;
+	sd_global->config.EVAL_VR       = 0;
+	sd_global->config.EVAL_LHS_BLOCK = 100;
+	sd_global->config.REP_WORKERS   = 1;
+	sd_global->config.MAX_REPS      = BATCH_SIZE;
+	sd_global->config.ADAPT_REPS    = 0;
+	sd_global->config.MIN_REPS      = 3;
+	sd_global->config.REP_TOL       = 0.01;
+	sd_global->config.BATCH_DECOMP  = 0;
+	sd_global->config.PH_RHO        = 1.0;
+	sd_global->config.PH_TOL        = 1e-4;
+	sd_global->config.PH_MAX_ITER   = 200;
+	sd_global->config.MEM_BUDGET    = 0;
+	sd_global->config.DELTA_DISK    = 0;
 
 	sd_global->config.SMOOTH_I     = 50;
 	sd_global->config.SMOOTH_PARM  = 0.25;
@@ -1771,6 +1788,40 @@ int load_config(sdglobal_type* sd_global, BOOL read_seeds, BOOL read_iters)
 				status = fscanf(f_in, "%d", &(sd_global->config.MODEL_FORMAT));
 			else if (!strcmp(param, "BOOTSTRAP_TEST"))
 				status = fscanf(f_in, "%d", &(sd_global->config.BOOTSTRAP_TEST));
+			else if (!strcmp(param, "NUM_THREADS"))
+				status = fscanf(f_in, "%d", &(sd_global->config.NUM_THREADS));
+			else if (!strcmp(param, "SEQ_TEST"))
+				status = fscanf(f_in, "%d", &(sd_global->config.SEQ_TEST));
+			else if (!strcmp(param, "SEQ_DELTA"))
+				status = fscanf(f_in, "%lf", &(sd_global->config.SEQ_DELTA));
+			else if (!strcmp(param, "SEQ_ERROR"))
+				status = fscanf(f_in, "%lf", &(sd_global->config.SEQ_ERROR));
+			else if (!strcmp(param, "EVAL_VR"))
+				status = fscanf(f_in, "%d", &(sd_global->config.EVAL_VR));
+			else if (!strcmp(param, "EVAL_LHS_BLOCK"))
+				status = fscanf(f_in, "%d", &(sd_global->config.EVAL_LHS_BLOCK));
+			else if (!strcmp(param, "REP_WORKERS"))
+				status = fscanf(f_in, "%d", &(sd_global->config.REP_WORKERS));
+			else if (!strcmp(param, "MAX_REPS"))
+				status = fscanf(f_in, "%d", &(sd_global->config.MAX_REPS));
+			else if (!strcmp(param, "ADAPT_REPS"))
+				status = fscanf(f_in, "%d", &(sd_global->config.ADAPT_REPS));
+			else if (!strcmp(param, "MIN_REPS"))
+				status = fscanf(f_in, "%d", &(sd_global->config.MIN_REPS));
+			else if (!strcmp(param, "REP_TOL"))
+				status = fscanf(f_in, "%lf", &(sd_global->config.REP_TOL));
+			else if (!strcmp(param, "BATCH_DECOMP"))
+				status = fscanf(f_in, "%d", &(sd_global->config.BATCH_DECOMP));
+			else if (!strcmp(param, "PH_RHO"))
+				status = fscanf(f_in, "%lf", &(sd_global->config.PH_RHO));
+			else if (!strcmp(param, "PH_TOL"))
+				status = fscanf(f_in, "%lf", &(sd_global->config.PH_TOL));
+			else if (!strcmp(param, "PH_MAX_ITER"))
+				status = fscanf(f_in, "%d", &(sd_global->config.PH_MAX_ITER));
+			else if (!strcmp(param, "MEM_BUDGET"))
+				status = fscanf(f_in, "%d", &(sd_global->config.MEM_BUDGET));
+			else if (!strcmp(param, "DELTA_DISK"))
+				status = fscanf(f_in, "%d", &(sd_global->config.DELTA_DISK));
 			else if (!strcmp(param, "RUN_SEED1"))
 				if (read_seeds)
 					status = fscanf(f_in, "%lld", &(sd_global->config.RUN_SEED1));
@@ -11,6 +11,8 @@
  **
  **
  ** calc_lambda()
+ ** equal_lambda()
+ ** lambda_RT()
  ** print_lambda()
  ** new_lambda()
  ** free_lambda()
@@ -39,7 +41,8 @@
  ** whose rows in the constraint matrix have random elements.  Thus 
  ** the (full) dual vector, Pi,  passed to the function is converted 
  ** into the sparse vector lambda_pi.  This vector is then compared with
- ** all previous lambda_pi vectors, searching for a duplication.
+ ** all previous lambda_pi vectors with the same nonzero positions,
+ ** searching for a duplication.
  ** If a duplicate is found, the vector is not added to the 
  ** structure, and the function returns the index of the duplicate 
  ** vector.  Otherwise, it adds the vector to the end of the structure, 
@@ -50,7 +53,9 @@ int calc_lambda(sdglobal_type* sd_global, lambda_type *lambda, num_type *num,
 {
 	int pi_idx; /* steps through lambda structure */
 	int length; /* length of each lambda_pi vector */
-	double *lambda_pi; /* sparse vector of dual variables */
+	int cnt, nnz;
+	unsigned int h = 2166136261u;
+	sparse_vect *lambda_pi; /* sparse vector of dual variables */
 
 #ifdef TRACE
 	printf("Inside calc_lambda\n");
@@ -59,25 +64,103 @@ int calc_lambda(sdglobal_type* sd_global, lambda_type *lambda, num_type *num,
 	length = num->rv_rows;
 
 	/* Pull out only those elements in dual vector which have rv's */
-	lambda_pi = reduce_vect(Pi, lambda->row, length);
+	reduce_vect_to(lambda->dense, Pi, lambda->row, length);
 
-	/* Compare resulting lambda_pi with all previous vectors */
+	/* Count its nonzeros, and hash (FNV-1a) their positions */
+	nnz = 0;
+	for (cnt = 1; cnt <= length; cnt++)
+		if (lambda->dense[cnt] != 0.0)
+		{
+			h = (h ^ (unsigned int) cnt) * 16777619u;
+			nnz++;
+		}
+
+	/* Compare it with all previous vectors with the same nonzeros */
 	for (pi_idx = 0; pi_idx < lambda->cnt; pi_idx++)
-		if (equal_arr(lambda_pi, lambda->val[pi_idx], length,
-				sd_global->config.TOLERANCE))
+		if (lambda->hash[pi_idx] == h && lambda->val[pi_idx].cnt == nnz
+				&& equal_lambda(&lambda->val[pi_idx], lambda->dense,
+						sd_global->config.TOLERANCE))
 		{
-			mem_free(lambda_pi);
 			*new_lamb = FALSE;
 			return pi_idx;
 		}
 
-	/* Add the vector to lambda struct */
-	lambda->val[lambda->cnt] = lambda_pi;
+	/* Add the nonzeros of the vector to lambda struct */
+	lambda_pi = &lambda->val[lambda->cnt];
+	if (!(lambda_pi->row = arr_alloc_in(MEM_LAMBDA, nnz+1, int)))
+		err_msg("Allocation", "calc_lambda", "lambda_pi->row");
+	if (!(lambda_pi->val = arr_alloc_in(MEM_LAMBDA, nnz+1, double)))
+		err_msg("Allocation", "calc_lambda", "lambda_pi->val");
+	lambda_pi->cnt = 0;
+	lambda_pi->val[0] = lambda->dense[0];
+	for (cnt = 1; cnt <= length; cnt++)
+		if (lambda->dense[cnt] != 0.0)
+		{
+			++lambda_pi->cnt;
+			lambda_pi->row[lambda_pi->cnt] = cnt;
+			lambda_pi->val[lambda_pi->cnt] = lambda->dense[cnt];
+		}
+	lambda->hash[lambda->cnt] = h;
 
 	*new_lamb = TRUE;
 	return lambda->cnt++;
 }
 
+/***********************************************************************\
+** This function compares a stored lambda_pi with the dense vector
+ ** _dense_, which has the same number of nonzeros, just as equal_arr()
+ ** would compare _dense_ with the stored vector made dense.  Since a
+ ** zero only equals a zero, checking the stored nonzeros is enough.
+ \***********************************************************************/
+BOOL equal_lambda(sparse_vect *lamb, double *dense, double tolerance)
+{
+	int cnt;
+
+	if (DBL_ABS(dense[0] - lamb->val[0]) > DBL_ABS(tolerance * dense[0]))
+		return FALSE;
+
+	for (cnt = 1; cnt <= lamb->cnt; cnt++)
+		if (DBL_ABS(dense[lamb->row[cnt]] - lamb->val[cnt])
+				> DBL_ABS(tolerance * dense[lamb->row[cnt]]))
+			return FALSE;
+
+	return TRUE;
+}
+
+/***********************************************************************\
+** This function multiplies lambda_pi _idx_ by the observation of omega
+ ** whose values are in _RT_, visiting only the random elements in the
+ ** rows of its nonzero duals.  It returns lambda_pi X R(omega), and fills
+ ** _pi_T_ with lambda_pi X T(omega) in the _num_cols_ columns of delta,
+ ** with the 1-norm in position 0.
+ \***********************************************************************/
+double lambda_RT(lambda_type *lambda, int idx, double *RT, vector pi_T,
+		int num_cols)
+{
+	sparse_vect *lamb;
+	double pi_R;
+	int cnt, pos, k;
+
+	lamb = &lambda->val[idx];
+	pi_R = 0.0;
+	for (cnt = 0; cnt <= num_cols; cnt++)
+		pi_T[cnt] = 0.0;
+
+	for (cnt = 1; cnt <= lamb->cnt; cnt++)
+	{
+		pos = lamb->row[cnt];
+		for (k = lambda->rt_beg[pos]; k < lambda->rt_beg[pos + 1]; k++)
+			if (lambda->rt_col[k])
+				pi_T[lambda->rt_col[k]] += lamb->val[cnt]
+						* RT[lambda->rt_idx[k]];
+			else
+				pi_R += lamb->val[cnt] * RT[lambda->rt_idx[k]];
+	}
+	pi_T[0] = one_norm(pi_T + 1, num_cols);
+
+	return pi_R;
+}
+
 /***********************************************************************\
 **
  \***********************************************************************/
@@ -85,9 +168,9 @@ void print_lambda(lambda_type *lambda, num_type *num, int idx)
 {
 	int cnt;
 
-	printf("\nLambda %d:: ", idx);
-	for (cnt = 0; cnt <= num->rv_rows; cnt++)
-		printf("%f  ", lambda->val[idx][cnt]);
+	printf("\nLambda %d:: %f  ", idx, lambda->val[idx].val[0]);
+	for (cnt = 1; cnt <= lambda->val[idx].cnt; cnt++)
+		printf("%d:%f  ", lambda->val[idx].row[cnt], lambda->val[idx].val[cnt]);
 	printf("\nLambda Rows: ");
 	for (cnt = 0; cnt <= num->rv_rows; cnt++)
 		printf("%d ", lambda->row[cnt]);
@@ -96,16 +179,18 @@ void print_lambda(lambda_type *lambda, num_type *num, int idx)
 
 /***********************************************************************\
 ** This function allocates a new lambda structure, with room
- ** for num_lambdas lambda vectors of size vect_size.  It returns a 
+ ** for num_lambdas lambda vectors over num->rv_rows rows.  It returns a 
  ** pointer to the structure.  Only some of the individual lambda vectors 
  ** are expected to be allocated (according to the num_vect parameter)
- ** so that there is room for new lambdas to be created. 
+ ** so that there is room for new lambdas to be created; they start out
+ ** with no nonzeros.  It also groups the random elements of R and T by
+ ** their rows, for lambda_RT().
  \***********************************************************************/
-lambda_type *new_lambda(int num_iter, int num_lambda, int num_rv_rows,
+lambda_type *new_lambda(int num_iter, int num_lambda, num_type *num,
 		coord_type *coord)
 {
 	lambda_type *lambda;
-	int cnt;
+	int cnt, pos, elem, col;
 
 #ifdef TRACE
 	printf("Inside new_lambda\n");
@@ -114,16 +199,57 @@ lambda_type *new_lambda(int num_iter, int num_lambda, int num_rv_rows,
 	if (!(lambda = (lambda_type *) mem_malloc (sizeof(lambda_type))))
 		err_msg("Allocation", "new_lambda", "lambda");
 
-	if (!(lambda->val = arr_alloc(num_iter, vector)))
+	if (!(lambda->val = arr_alloc_in(MEM_LAMBDA, num_iter, sparse_vect)))
 		err_msg("Allocation", "new_lambda", "lambda->val");
+	if (!(lambda->hash = arr_alloc_in(MEM_LAMBDA, num_iter, unsigned int)))
+		err_msg("Allocation", "new_lambda", "lambda->hash");
+	if (!(lambda->dense = arr_alloc_in(MEM_LAMBDA, num->rv_rows+1, double)))
+		err_msg("Allocation", "new_lambda", "lambda->dense");
 
 	for (cnt = 0; cnt < num_lambda; cnt++)
-		if (!(lambda->val[cnt] = arr_alloc(num_rv_rows+1, double)))
-			err_msg("Allocation", "new_lambda", "lambda->val[cnt]");
+	{
+		if (!(lambda->val[cnt].row = arr_alloc_in(MEM_LAMBDA, 1, int)))
+			err_msg("Allocation", "new_lambda", "lambda->val[cnt].row");
+		if (!(lambda->val[cnt].val = arr_alloc_in(MEM_LAMBDA, 1, double)))
+			err_msg("Allocation", "new_lambda", "lambda->val[cnt].val");
+		lambda->hash[cnt] = 2166136261u;
+	}
 
 	lambda->cnt = num_lambda;
 	lambda->row = coord->lambda_row;
 
+	/* Group the random elements of R and T by the position of their row */
+	if (!(lambda->rt_beg = arr_alloc_in(MEM_LAMBDA, num->rv_rows+2, int)))
+		err_msg("Allocation", "new_lambda", "lambda->rt_beg");
+	if (!(lambda->rt_idx = arr_alloc_in(MEM_LAMBDA, num->rv_R+num->rv_T+1, int)))
+		err_msg("Allocation", "new_lambda", "lambda->rt_idx");
+	if (!(lambda->rt_col = arr_alloc_in(MEM_LAMBDA, num->rv_R+num->rv_T+1, int)))
+		err_msg("Allocation", "new_lambda", "lambda->rt_col");
+
+	cnt = 0;
+	for (pos = 1; pos <= num->rv_rows; pos++)
+	{
+		lambda->rt_beg[pos] = cnt;
+		for (elem = 1; elem <= num->rv_R + num->rv_T; elem++)
+			if (coord->omega_row[elem] == lambda->row[pos])
+			{
+				/* The elements of R come first, and have no column */
+				col = 0;
+				if (elem > num->rv_R)
+				{
+					for (col = num->rv_cols; col > 0; col--)
+						if (coord->delta_col[col] == coord->omega_col[elem])
+							break;
+					if (!col)
+						continue;
+				}
+				lambda->rt_idx[cnt] = elem;
+				lambda->rt_col[cnt] = col;
+				cnt++;
+			}
+	}
+	lambda->rt_beg[num->rv_rows + 1] = cnt;
+
 	return lambda;
 }
 
@@ -139,9 +265,16 @@ void free_lambda(lambda_type *lambda)
 #endif
 
 	for (cnt = 0; cnt < lambda->cnt; cnt++)
-		mem_free(lambda->val[cnt]);
-
+	{
+		mem_free(lambda->val[cnt].row);
+		mem_free(lambda->val[cnt].val);
+	}
 	mem_free(lambda->val);
+	mem_free(lambda->hash);
+	mem_free(lambda->dense);
+	mem_free(lambda->rt_beg);
+	mem_free(lambda->rt_idx);
+	mem_free(lambda->rt_col);
 	mem_free(lambda);
 }
 
@@ -171,11 +304,13 @@ void write_lambda(FILE *fptr, lambda_type *lambda, num_type *num)
 	fprintf(fptr, "\nVAL");
 	for (cnt = 0; cnt < lambda->cnt; cnt++)
 	{
-		for (idx = 0; idx < num->rv_rows; idx++)
+		/* Only the nonzeros are kept, each after its position in ROWS */
+		for (idx = 1; idx <= lambda->val[cnt].cnt; idx++)
 		{
-			if (!(idx % NUM_DBLS))
+			if (!((idx - 1) % NUM_DBLS))
 				fprintf(fptr, "\n");
-			fprintf(fptr, "%lf ", lambda->val[cnt][cnt]);
+			fprintf(fptr, "%d:%lf ", lambda->val[cnt].row[idx],
+					lambda->val[cnt].val[idx]);
 		}
 		fprintf(fptr, "\n");
 	}
@@ -11,7 +11,10 @@
 
 int calc_lambda(sdglobal_type* sd_global, lambda_type *lambda, num_type *num,
 		vector Pi, BOOL *new_lamb);
-lambda_type *new_lambda(int num_iter, int num_lambda, int num_rv_rows,
+BOOL equal_lambda(sparse_vect *lamb, double *dense, double tolerance);
+double lambda_RT(lambda_type *lambda, int idx, double *RT, vector pi_T,
+		int num_cols);
+lambda_type *new_lambda(int num_iter, int num_lambda, num_type *num,
 		coord_type *coord);
 void free_lambda(lambda_type *lambda);
 void print_lambda(lambda_type *lambda, num_type *num, int idx);
@@ -26,22 +26,195 @@
 #include "log.h"
 #include "sdglobal.h"
 #include <time.h>
+#include <stdint.h>
+#include <pthread.h>
+#ifdef SD_unix
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+/* The allocations in use, an open-addressed table of mem_notes_size
+ entries (a power of two) keyed by address, and the bytes they add up
+ to by subsystem; mem_use[MEM_SUBSYS] is all of them.  Worker threads
+ allocate too, so both are only touched under mem_lock. */
+mem_note_type *mem_notes = NULL;
+size_t mem_notes_size = 0;
+size_t mem_notes_cnt = 0;
+mem_use_type mem_use[MEM_SUBSYS + 1];
+pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+
+char *mem_subsys_name[MEM_SUBSYS] =
+{ "other", "delta", "sigma", "lambda", "omega", "cuts", "solver" };
+
+/* This function returns the slot of a table of _size_ entries where the
+ search for _ptr_ starts. */
+size_t mem_note_home(size_t size, void *ptr)
+{
+	return (size_t) (((uintptr_t) ptr >> 4) * 0x9E3779B97F4A7C15ULL >> 16)
+			& (size - 1);
+}
+
+/* This function returns the slot of the table where _ptr_ is, or the
+ empty one where it would go. */
+size_t mem_note_slot(mem_note_type *notes, size_t size, void *ptr)
+{
+	size_t i;
+
+	i = mem_note_home(size, ptr);
+	while (notes[i].ptr && notes[i].ptr != ptr)
+		i = (i + 1) & (size - 1);
+
+	return i;
+}
+
+/* This function adds _size_ bytes, which may be negative, to the use of
+ subsystem _sub_ and of all of them. */
+void mem_account(int sub, sd_long size)
+{
+	mem_use[sub].cur += size;
+	if (mem_use[sub].cur > mem_use[sub].peak)
+		mem_use[sub].peak = mem_use[sub].cur;
+	mem_use[MEM_SUBSYS].cur += size;
+	if (mem_use[MEM_SUBSYS].cur > mem_use[MEM_SUBSYS].peak)
+		mem_use[MEM_SUBSYS].peak = mem_use[MEM_SUBSYS].cur;
+}
+
+/*************************************************************************\
+** This function notes that _size_ bytes at _ptr_ are in use by subsystem
+ ** _sub_.  The table is doubled whenever it would be half full; it comes
+ ** straight from calloc(), so that it is not noted in itself.  An address
+ ** noted already was freed behind our back, and is taken over.
+ \*************************************************************************/
+void mem_note(void *ptr, size_t size, int sub)
+{
+	mem_note_type *notes;
+	size_t i, n;
+
+	pthread_mutex_lock(&mem_lock);
+	if (2 * (mem_notes_cnt + 1) > mem_notes_size)
+	{
+		n = mem_notes_size ? 2 * mem_notes_size : 1024;
+		if (!(notes = (mem_note_type *) calloc(n, sizeof(mem_note_type))))
+			err_msg("Allocation", "mem_note", "notes");
+		for (i = 0; i < mem_notes_size; i++)
+			if (mem_notes[i].ptr)
+				notes[mem_note_slot(notes, n, mem_notes[i].ptr)] = mem_notes[i];
+		free(mem_notes);
+		mem_notes = notes;
+		mem_notes_size = n;
+	}
+
+	i = mem_note_slot(mem_notes, mem_notes_size, ptr);
+	if (mem_notes[i].ptr)
+		mem_account(mem_notes[i].sub, -(sd_long) mem_notes[i].size);
+	else
+		mem_notes_cnt++;
+	mem_notes[i].ptr = ptr;
+	mem_notes[i].size = size;
+	mem_notes[i].sub = sub;
+	mem_account(sub, size);
+	pthread_mutex_unlock(&mem_lock);
+}
+
+/*************************************************************************\
+** This function takes _ptr_ off the table and its bytes off the use of
+ ** its subsystem, and returns the subsystem (MEM_OTHER for an address
+ ** that was never noted).  The entries after it are shifted back into
+ ** the gap, so that every one stays reachable from its home slot.
+ \*************************************************************************/
+int mem_unnote(void *ptr)
+{
+	size_t i, j, home;
+	int sub = MEM_OTHER;
+
+	if (!ptr)
+		return sub;
+
+	pthread_mutex_lock(&mem_lock);
+	if (mem_notes_size)
+	{
+		i = mem_note_slot(mem_notes, mem_notes_size, ptr);
+		if (mem_notes[i].ptr)
+		{
+			sub = mem_notes[i].sub;
+			mem_account(sub, -(sd_long) mem_notes[i].size);
+			mem_notes_cnt--;
+			j = i;
+			while (TRUE)
+			{
+				mem_notes[i].ptr = NULL;
+				do
+				{
+					j = (j + 1) & (mem_notes_size - 1);
+					if (!mem_notes[j].ptr)
+						break;
+					home = mem_note_home(mem_notes_size, mem_notes[j].ptr);
+				} while (i <= j ? (i < home && home <= j)
+						: (i < home || home <= j));
+				if (!mem_notes[j].ptr)
+					break;
+				mem_notes[i] = mem_notes[j];
+				i = j;
+			}
+		}
+	}
+	pthread_mutex_unlock(&mem_lock);
+
+	return sub;
+}
+
+/* This function returns the bytes in use by subsystem _sub_ (MEM_SUBSYS
+ for all of them), or the most there have been if _peak_ is set. */
+sd_long mem_in_use(int sub, BOOL peak)
+{
+	sd_long size;
+
+	pthread_mutex_lock(&mem_lock);
+	size = peak ? mem_use[sub].peak : mem_use[sub].cur;
+	pthread_mutex_unlock(&mem_lock);
+
+	return size;
+}
+
+/*************************************************************************\
+** This function appends a line to _fptr_ with the memory in use, then
+ ** at its peak, in all and for each subsystem, in kilobytes, after
+ ** iteration _iter_ of replication _rep_.
+ \*************************************************************************/
+void write_mem_usage(FILE *fptr, int rep, int iter)
+{
+	int sub;
 
-sd_long MEM_USED = 0;
+	fprintf(fptr, "%d, %d, %lld, %lld", rep, iter,
+			mem_in_use(MEM_SUBSYS, FALSE) / 1024,
+			mem_in_use(MEM_SUBSYS, TRUE) / 1024);
+	for (sub = 0; sub < MEM_SUBSYS; sub++)
+		fprintf(fptr, ", %lld, %lld", mem_in_use(sub, FALSE) / 1024,
+				mem_in_use(sub, TRUE) / 1024);
+	fprintf(fptr, "\n");
+}
 
 /*************************************************************************\
 ** This function records the information present in a call to one of the
  ** dynamic allocation routines.  It stores a string, intended to be the
  ** name of the pointer or the size of the allocation, and a pointer,
- ** intended to be the return value from the memory allocation.
+ ** intended to be the return value from the memory allocation.  The
+ ** memory is accounted to MEM_OTHER.
  \*************************************************************************/
-void *log_alloc(char *string, void *return_ptr, int size)
+void *log_alloc(char *string, void *return_ptr, size_t size)
+{
+	return log_alloc_in(MEM_OTHER, string, return_ptr, size);
+}
+
+/* As log_alloc(), but the memory is accounted to subsystem _sub_ */
+void *log_alloc_in(int sub, char *string, void *return_ptr, size_t size)
 {
 	/*
 	 fprintf(sd_global->fptrALLOC, "%lld : %s : size %d\n", return_ptr, string, size);
 	 */
 
-	MEM_USED += size;
+	if (return_ptr)
+		mem_note(return_ptr, size, sub);
 
 	return return_ptr;
 }
@@ -59,6 +232,7 @@ void *log_free(char *string, void *ptr)
 	//fprintf(fptrFREE, "%d : %s\n", ptr, string); 
 	//modified by Yifan to avoid wrong type warning July 26 2011
 
+	mem_unnote(ptr);
 	free(ptr);
 	return NULL;
 }
@@ -67,16 +241,19 @@ void *log_free(char *string, void *ptr)
 ** A call to realloc involves both a free (of the original pointer) and
  ** an alloc (for the new pointer).  This function accepts a string,
  ** an original pointer for the free log file, and the same string with 
- ** the realloc'ed pointer for the alloc log file.
+ ** the realloc'ed pointer for the alloc log file.  The memory stays with
+ ** the subsystem it was accounted to; when realloc fails, the original
+ ** pointer is still in use.
  \*************************************************************************/
-void *log_realloc(char *string, void *free_ptr, void *alloc_ptr, int size)
+void *log_realloc(char *string, void *free_ptr, void *alloc_ptr, size_t size)
 {
 	/*
 	 fprintf(fptrFREE, "%lld : %s\n", free_ptr, string);
 	 fprintf(sd_global->fptrALLOC, "%lld : %s : size %d\n", alloc_ptr, string, size);
 	 */
 
-	MEM_USED += size;
+	if (alloc_ptr)
+		mem_note(alloc_ptr, size, mem_unnote(free_ptr));
 
 	return alloc_ptr;
 }
@@ -89,15 +266,24 @@ void *log_realloc(char *string, void *free_ptr, void *alloc_ptr, int size)
  \*************************************************************************/
 void log_start(sdglobal_type* sd_global)
 {
-#ifdef WRITE
 	FILE *fptr;
-#endif
+	int sub;
+
 	 /*sd_global->fptrALLOC = fopen("alloc.log", "w");
 	 sd_global->fptrFREE  = fopen("free.log", "w");*/
 
-	MEM_USED = 0;
 	sd_global->LAST_CLOCK = clock();
 
+	/* Start the memory statistics, with a line naming its columns */
+	if ((fptr = fopen(MEM_DAT, "w")))
+	{
+		fprintf(fptr, "# rep, iter, total KB, peak");
+		for (sub = 0; sub < MEM_SUBSYS; sub++)
+			fprintf(fptr, ", %s, peak", mem_subsys_name[sub]);
+		fprintf(fptr, "\n");
+		fclose(fptr);
+	}
+
 #ifdef WRITE
 	/* Erase any previous data files */
 	fptr = fopen(ITER_DAT, "w");
@@ -116,7 +302,20 @@ void log_start(sdglobal_type* sd_global)
  \*************************************************************************/
 void log_stop(sdglobal_type* sd_global)
 {
-	/* FILE		*fptr;*/
+	FILE *fptr;
+	int sub;
+
+	/* Summarize what each subsystem held, at its peak and still now */
+	printf("\nMemory (KB)      in use        peak\n");
+	for (sub = 0; sub <= MEM_SUBSYS; sub++)
+		printf("  %-10s %11lld %11lld\n",
+				sub < MEM_SUBSYS ? mem_subsys_name[sub] : "total",
+				mem_in_use(sub, FALSE) / 1024, mem_in_use(sub, TRUE) / 1024);
+	if ((fptr = fopen(MEM_DAT, "a")))
+	{
+		write_mem_usage(fptr, -1, -1);
+		fclose(fptr);
+	}
 #ifdef WRITE
 	if (sd_global->fptrALLOC != NULL)
 	{
@@ -129,6 +328,337 @@ void log_stop(sdglobal_type* sd_global)
 #endif
 }
 
+/*************************************************************************\
+** Rounds _size_ up to a multiple of 16 bytes, so that whatever is carved
+ ** from a block of memory is aligned for any type.
+ \*************************************************************************/
+size_t mem_round(size_t size)
+{
+	return (size + 15) / 16 * 16;
+}
+
+/*************************************************************************\
+** This function allocates a block of memory with room for _size_ bytes
+ ** after its header, none of them used yet.
+ \*************************************************************************/
+mem_block_type *new_mem_block(size_t size, int sub)
+{
+	mem_block_type *block;
+
+	if (!(block = (mem_block_type *) mem_malloc_in (sub, mem_round(sizeof(mem_block_type)) + size)))
+		err_msg("Allocation", "new_mem_block", "block");
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+/*************************************************************************\
+** This function creates a pool of objects of _size_ bytes, carved
+ ** _per_block_ at a time from blocks of memory accounted to subsystem
+ ** _sub_.  No block is allocated until the first object is requested.
+ \*************************************************************************/
+mem_pool_type *new_mem_pool(size_t size, int per_block, int sub)
+{
+	mem_pool_type *pool;
+
+	if (!(pool = (mem_pool_type *) mem_malloc (sizeof(mem_pool_type))))
+		err_msg("Allocation", "new_mem_pool", "pool");
+	pool->size = mem_round(max(size, sizeof(void *)));
+	pool->per_block = max(1, per_block);
+	pool->blocks = NULL;
+	pool->free_list = NULL;
+	pool->cnt = 0;
+	pool->peak = 0;
+	pool->sub = sub;
+	pool->map = NULL;
+
+	return pool;
+}
+
+/*************************************************************************\
+** This function returns a zeroed object from the pool: one that was
+ ** given back, or else the next one of the current block, which is
+ ** replaced by a new block once it is used up.
+ \*************************************************************************/
+void *mem_pool_get(mem_pool_type *pool)
+{
+	void *ptr;
+	mem_block_type *block;
+
+	if (pool->free_list)
+	{
+		ptr = pool->free_list;
+		pool->free_list = *(void **) ptr;
+	}
+	else
+	{
+		if (!pool->blocks || pool->blocks->used == pool->blocks->size)
+		{
+			if (pool->map)
+				block = mem_map_get(pool->map, pool->size * pool->per_block);
+			else
+				block = new_mem_block(pool->size * pool->per_block, pool->sub);
+			block->next = pool->blocks;
+			pool->blocks = block;
+		}
+		block = pool->blocks;
+		ptr = (char *) block + mem_round(sizeof(mem_block_type)) + block->used;
+		block->used += pool->size;
+	}
+	memset(ptr, 0, pool->size);
+	if (++pool->cnt > pool->peak)
+		pool->peak = pool->cnt;
+
+	return ptr;
+}
+
+/*************************************************************************\
+** This function gives an object back to its pool, where it waits for
+ ** the next request.  A NULL pointer is ignored.
+ \*************************************************************************/
+void mem_pool_put(mem_pool_type *pool, void *ptr)
+{
+	if (!ptr)
+		return;
+	*(void **) ptr = pool->free_list;
+	pool->free_list = ptr;
+	pool->cnt--;
+}
+
+/*************************************************************************\
+** This function releases every block of the pool, and so every object
+ ** it ever handed out, then the pool itself.
+ \*************************************************************************/
+void free_mem_pool(mem_pool_type *pool)
+{
+	mem_block_type *block;
+
+	while ((block = pool->blocks))
+	{
+		pool->blocks = block->next;
+		if (pool->map)
+			mem_map_put(pool->map, block);
+		else
+			mem_free(block);
+	}
+	mem_free(pool);
+}
+
+/*************************************************************************\
+** This function creates a map for blocks of _size_ bytes (past their
+ ** header), kept in a file of the working directory rather than on the
+ ** heap.  The file is unlinked at once, so it goes when the program does,
+ ** and it is mapped MAP_EXTENT bytes at a time as it grows.  Mapped blocks
+ ** are not counted by mem_in_use().
+ \*************************************************************************/
+mem_map_type *new_mem_map(size_t size)
+{
+	mem_map_type *map;
+#ifdef SD_unix
+	char name[] = "sd_map.XXXXXX";
+	size_t page;
+
+	if (!(map = (mem_map_type *) mem_malloc (sizeof(mem_map_type))))
+		err_msg("Allocation", "new_mem_map", "map");
+	if ((map->fd = mkstemp(name)) < 0)
+		err_msg("File", "new_mem_map", name);
+	unlink(name);
+
+	/* Blocks fill whole pages, so every extent starts on one */
+	page = (size_t) sysconf(_SC_PAGESIZE);
+	map->block = (mem_round(sizeof(mem_block_type)) + size + page - 1)
+			/ page * page;
+	map->per_extent = (int) max(1, MAP_EXTENT / map->block);
+	map->cnt = 0;
+	map->extent = NULL;
+	map->used = map->per_extent;
+	map->free_list = NULL;
+#else
+	map = NULL;
+	err_msg("Platform", "new_mem_map", "DELTA_DISK");
+#endif
+
+	return map;
+}
+
+/*************************************************************************\
+** This function returns a block of the map with room for _size_ bytes:
+ ** one that was given back, or else the next one of the last extent,
+ ** mapping a new extent at the end of the file when it is used up.
+ \*************************************************************************/
+mem_block_type *mem_map_get(mem_map_type *map, size_t size)
+{
+	mem_block_type *block;
+#ifdef SD_unix
+	size_t len;
+	char *base;
+
+	if (mem_round(sizeof(mem_block_type)) + size > map->block)
+		err_msg("Size", "mem_map_get", "size");
+
+	if ((block = map->free_list))
+		map->free_list = block->next;
+	else
+	{
+		if (map->used == map->per_extent)
+		{
+			len = map->block * map->per_extent;
+			if (ftruncate(map->fd, (off_t) (len * (map->cnt + 1))))
+				err_msg("File", "mem_map_get", "ftruncate");
+			base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+					map->fd, (off_t) (len * map->cnt));
+			if (base == MAP_FAILED)
+				err_msg("Allocation", "mem_map_get", "mmap");
+			if (!(map->extent = (char **) mem_realloc (map->extent,
+					(map->cnt + 1) * sizeof(char *))))
+				err_msg("Allocation", "mem_map_get", "map->extent");
+			map->extent[map->cnt++] = base;
+			map->used = 0;
+		}
+		block = (mem_block_type *) (map->extent[map->cnt - 1]
+				+ map->block * map->used++);
+	}
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+#else
+	block = NULL;
+#endif
+
+	return block;
+}
+
+/* This function gives a block back to its map, for the next request. */
+void mem_map_put(mem_map_type *map, mem_block_type *block)
+{
+	block->next = map->free_list;
+	map->free_list = block;
+}
+
+/*************************************************************************\
+** This function unmaps every extent of the map, and so every block it
+ ** ever handed out, then closes its file and frees the map.
+ \*************************************************************************/
+void free_mem_map(mem_map_type *map)
+{
+#ifdef SD_unix
+	int cnt;
+
+	for (cnt = 0; cnt < map->cnt; cnt++)
+		munmap(map->extent[cnt], map->block * map->per_extent);
+	if (map->extent)
+		mem_free(map->extent);
+	close(map->fd);
+	mem_free(map);
+#endif
+}
+
+/*************************************************************************\
+** This function tells the system that the _len_ bytes at _ptr_ will be
+ ** needed soon (_hot_), so it reads them ahead, or that they will not,
+ ** so it pages them out before others.  It only matters for mapped blocks.
+ \*************************************************************************/
+void mem_advise(void *ptr, size_t len, BOOL hot)
+{
+#ifdef SD_unix
+	size_t page;
+	char *start;
+
+	page = (size_t) sysconf(_SC_PAGESIZE);
+	start = (char *) ((uintptr_t) ptr & ~(uintptr_t) (page - 1));
+	len += (char *) ptr - start;
+	if (hot)
+		madvise(start, len, MADV_WILLNEED);
+#ifdef MADV_COLD
+	else
+		madvise(start, len, MADV_COLD);
+#endif
+#endif
+}
+
+/*************************************************************************\
+** This function creates an arena of scratch space, with a first block
+ ** of _size_ bytes.
+ \*************************************************************************/
+mem_arena_type *new_mem_arena(size_t size)
+{
+	mem_arena_type *arena;
+
+	if (!(arena = (mem_arena_type *) mem_malloc (sizeof(mem_arena_type))))
+		err_msg("Allocation", "new_mem_arena", "arena");
+	arena->blocks = new_mem_block(mem_round(size), MEM_OTHER);
+	arena->cnt = 0;
+	arena->peak = 0;
+
+	return arena;
+}
+
+/*************************************************************************\
+** This function returns _size_ zeroed bytes of scratch space from the
+ ** arena, starting a new block when the current one has no room left.
+ \*************************************************************************/
+void *mem_arena_get(mem_arena_type *arena, size_t size)
+{
+	mem_block_type *block;
+	void *ptr;
+
+	size = mem_round(size);
+	if (arena->blocks->used + size > arena->blocks->size)
+	{
+		block = new_mem_block(max(size, arena->blocks->size), MEM_OTHER);
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+	block = arena->blocks;
+	ptr = (char *) block + mem_round(sizeof(mem_block_type)) + block->used;
+	block->used += size;
+	memset(ptr, 0, size);
+	arena->cnt += size;
+	if (arena->cnt > arena->peak)
+		arena->peak = arena->cnt;
+
+	return ptr;
+}
+
+/*************************************************************************\
+** This function takes back all the scratch space of the arena at once.
+ ** If it took more than one block, they are replaced by a single block
+ ** as large as all of them, so that the arena soon stops allocating.
+ \*************************************************************************/
+void mem_arena_reset(mem_arena_type *arena)
+{
+	mem_block_type *block;
+	size_t size;
+
+	if (arena->blocks->next)
+	{
+		size = 0;
+		while ((block = arena->blocks))
+		{
+			size += block->size;
+			arena->blocks = block->next;
+			mem_free(block);
+		}
+		arena->blocks = new_mem_block(size, MEM_OTHER);
+	}
+	arena->blocks->used = 0;
+	arena->cnt = 0;
+}
+
+void free_mem_arena(mem_arena_type *arena)
+{
+	mem_block_type *block;
+
+	while ((block = arena->blocks))
+	{
+		arena->blocks = block->next;
+		mem_free(block);
+	}
+	mem_free(arena);
+}
+
 /* modified by zl 
  void malloc_verify()
  {  }
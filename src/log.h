@@ -9,11 +9,36 @@
 #define LOG_H_
 #include "sdglobal.h"
 
+#include <stdio.h>
+
 BOOL malloc_verify(void);
-void *log_alloc(char *string, void *return_ptr, int size);
+size_t mem_note_home(size_t size, void *ptr);
+size_t mem_note_slot(mem_note_type *notes, size_t size, void *ptr);
+void mem_account(int sub, sd_long size);
+void mem_note(void *ptr, size_t size, int sub);
+int mem_unnote(void *ptr);
+sd_long mem_in_use(int sub, BOOL peak);
+void write_mem_usage(FILE *fptr, int rep, int iter);
+void *log_alloc(char *string, void *return_ptr, size_t size);
+void *log_alloc_in(int sub, char *string, void *return_ptr, size_t size);
 void *log_free(char *string, void *ptr);
-void *log_realloc(char *string, void *free_ptr, void *alloc_ptr, int size);
+void *log_realloc(char *string, void *free_ptr, void *alloc_ptr, size_t size);
 void log_start(sdglobal_type* sd_global);
 void log_stop(sdglobal_type* sd_global);
+size_t mem_round(size_t size);
+mem_block_type *new_mem_block(size_t size, int sub);
+mem_pool_type *new_mem_pool(size_t size, int per_block, int sub);
+void *mem_pool_get(mem_pool_type *pool);
+void mem_pool_put(mem_pool_type *pool, void *ptr);
+void free_mem_pool(mem_pool_type *pool);
+mem_map_type *new_mem_map(size_t size);
+mem_block_type *mem_map_get(mem_map_type *map, size_t size);
+void mem_map_put(mem_map_type *map, mem_block_type *block);
+void free_mem_map(mem_map_type *map);
+void mem_advise(void *ptr, size_t len, BOOL hot);
+mem_arena_type *new_mem_arena(size_t size);
+void *mem_arena_get(mem_arena_type *arena, size_t size);
+void mem_arena_reset(mem_arena_type *arena);
+void free_mem_arena(mem_arena_type *arena);
 
 #endif /* LOG_H_ */
@@ -12,6 +12,7 @@
  ** add_cut()
  ** change_cut()
  ** change_eta_col()
+ ** init_eta_col()
  **
  ** History:
  **   02 Feb 1992 - <Jason Mai> - created.
@@ -63,8 +64,8 @@ BOOL solve_master(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	printf("Inside solve_master\n");
 #endif
 
-	/* Update eta coefficient on all cuts, based on cut_obs */
-	change_eta_col(c->master, c->cuts, c->k, s, p->num);
+	/* Update the cost (and bound) of the scaled eta column for this k */
+	change_eta_col(c->master, c, p->num);
 
 #ifdef SAVE
 	fname[6] = '0' + mnum / 100 % 10;
@@ -92,6 +93,7 @@ BOOL solve_master(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	get_dual(s->Master_pi, c->master, p->num,
 			p->num->mast_rows + c->cuts->cnt + c->feasible_cuts_added->cnt);
 	get_dual_slacks(s->Master_dj, c->master, p->num, p->num->mast_cols + 1);
+	unscale_eta_dj(s->Master_dj, c, p->num);
 
 	/** 
 	 if (c->k == config.MAX_ITER)
@@ -104,7 +106,7 @@ BOOL solve_master(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	 } 
 	 **/
 
-	s->candid_est = get_objective(c->master);
+	s->candid_est = get_objective(c->master) + eta_offset(c);
 
 	/* Calculate gamma for next improvement check on incumbent x */
 	s->gamma = s->candid_est - s->incumb_est;
@@ -143,18 +145,16 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 	printf("Inside solve_QP_master\n");
 #endif
 
-	/* In regularized QP method, we switch from dual simplex optimizer to
-	 barrier optimizer for solving quadratic master problem. zl */
+	/* The regularized master changes by one cut per iteration, so it is
+	 solved by dual simplex from the previous basis rather than by barrier
+	 from scratch (barrier is left as a fallback in solve_problem()). */
 
-	change_solver_barrier(cell->master);
+	change_qp_method(cell->master, ALG_DUAL);
 
-	/* Update eta coefficient on all cuts, based on cut_obs */
-	change_eta_col(cell->master, cell->cuts, cell->k, s, p->num);
-
-	if (sd_global->config.LB_TYPE == 1)
-	{
-		update_rhs(sd_global, p, cell, s);
-	}
+	/* Update the cost (and bound) of the scaled eta column for this k.
+	 ** The (k/cut_obs - 1) * Eta0 term of LB_TYPE 1 is absorbed in the
+	 ** scaling, so the cut rhs no longer needs updating here. */
+	change_eta_col(cell->master, cell, p->num);
 
 #ifdef SAVE
 	fname[6] = '0' + mnum / 100 % 10;
@@ -163,11 +163,11 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 	++mnum;
 	print_problem(cell->master, fname);
 	printf("Saving file: %s\n", fname);
+	write_prob(cell->master, "master.lp");
 #endif
 
 	/* Recording the time for solving master QPs. zl, 06/29/04. */
 	start = clock();
-	write_prob(cell->master, "master.lp");
 	ans = solve_problem(sd_global, cell->master);
 	end = clock();
 	s->run_time->soln_master_iter = ((double) (end - start)) / CLOCKS_PER_SEC;
@@ -175,7 +175,7 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 
 	cell->LP_cnt++; /* # of LPs solved increase by 1. zl 06/30/02 */
 
-	s->opt_value = get_objective(cell->master);
+	s->opt_value = get_objective(cell->master) + eta_offset(cell);
 	/*
 	 fprintf(g_FilePointer, "\n****** In solve_QP_master ******\n");
 	 */
@@ -259,6 +259,7 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 	 */
 
 	get_dual_slacks(s->Master_dj, cell->master, NULL, p->num->mast_cols + 1);
+	unscale_eta_dj(s->Master_dj, cell, p->num);
 
 #ifdef CAL_CHECK
 	write_prob(cell->master, "quad_cut.lp");
@@ -327,6 +328,8 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 	}
 
 	get_x(cell->master, eta, p->num->mast_cols, p->num->mast_cols); /* 2011.10.30 */
+	if (cell->k > 0)
+		eta[0] = eta[0] / (double) cell->k + cell->eta_shift;
 
 #ifdef CAL_CHECK
 	fprintf(g_FilePointer, "\nSm = %f, eta = %f \n", Sm, eta[0]);
@@ -364,11 +367,13 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 			candid_est, s->incumb_est, gamma);
 #endif
 
-	/* In regularized QP method, we need to switch back from barrier
-	 optimizer to primal simplex optimizer each time after solving the 
-	 quadratic master problem. zl */
+	/* In regularized QP method, we need to switch back to the LP
+	 optimizer each time after solving the quadratic master problem. zl
+	 Other QPs (the compromise problem, the master of full_test) go back
+	 to barrier. */
 
 	change_solver_primal(cell->master);
+	change_qp_method(cell->master, ALG_QP_BARRIER);
 
 	//mem_free(eta);  //Deleted by Yifan since _eta_ is not allocated above April 27 2011
 
@@ -380,86 +385,145 @@ BOOL solve_QP_master(sdglobal_type* sd_global, prob_type *p, cell_type *cell, so
 }
 
 /***********************************************************************\
-** This function performs the updates on all the coefficients of eta
- ** in the master problem constraint matrix.  During every iteration,
- ** each of the coefficieints on eta are increased, so that the effect
- ** of the cut on the objective function is decreased.
+** In an SD cut the coefficient on eta, k / cut_obs, grows with every
+ ** iteration, and so does the rhs term (k / cut_obs - 1) * Eta0 used
+ ** with LB_TYPE 1.  Rather than rewriting these for every cut before
+ ** every solve, the eta column of the master holds the scaled variable
+ **
+ **      zeta = k * (eta - shift)
  **
- ** THIS ONLY WORKS FOR A SINGLE CELL !!!!!!!!   FIX IT !!!!!
- ** Multiply them properly, as you do in f_k in theta.c.
+ ** where shift is cell->eta_shift (Eta0 for a QP master with LB_TYPE 1,
+ ** zero otherwise).  Substituting, each cut reads
  **
- ** And what is going to happen when you start to drop cuts ???
- ** The location of the cut is no longer valid...
+ **      Beta x X  +  zeta / cut_obs  >=  Alpha - shift
  **
- ** Each cut needs to memorize its row.  Then this function will
- ** loop through cuts, and change correctly... if no cuts are dropped...
- ** 
- ** Or each cut can memorize its row name (you'll have to give it one, 
- ** like "0" and "1" and "2"), then request the row number of this
- ** row name from the solver, then change the coefficient at that row.
+ ** which never changes once the cut has been added.  Only the cost of
+ ** zeta, 1 / k, moves with k, and the objective is off by the constant
+ ** shift (see eta_offset()).  This function brings the cost and lower
+ ** bound of the column up to date, and only calls the solver when they
+ ** actually change, so a solve costs O(1) here instead of O(cuts).
+ **
+ ** With no optimality cuts, eta has no cost and a lower bound of 0.
  \***********************************************************************/
-void change_eta_col(one_problem *p, cut_type *cuts, int k, soln_type *soln,
-		num_type *num)
+void change_eta_col(one_problem *p, cell_type *cell, num_type *num)
 {
-	double *coef;
-	int c;
-	int eta_col[1]; /* added by Yifan to change eta coefficient in objective function 08/26/11*/
-	double lb_0_neginf[1];/*added by Yifan to change eta coefficient in objective function 08/26/11*/
+	int eta_col[1];
 	char lu[1];
-	double eta_coef0[1];
-	double eta_coef1[1];
-	BOOL etaFlag = FALSE;
+	double obj[1];
+	double lb[1];
 
 #ifdef TRACE
 	printf("Inside change_eta_col\n");
 #endif
 
 	eta_col[0] = num->mast_cols;
-	eta_coef0[0] = 0.0;
-	eta_coef1[0] = 1.0;
 	lu[0] = 'L';
 
-	/*
-	 ** Calculate an array of coefficients for the eta column.
-	 */
-	if (!(coef = arr_alloc(cuts->cnt, double)))
-		err_msg("Allocation", "change_eta_col", "coef");
-
-	for (c = 0; c < cuts->cnt; c++)
+	if (cell->cuts->cnt > 0 && cell->k > 0)
+	{
+		obj[0] = 1.0 / (double) cell->k;
+		lb[0] = -INFBOUND;
+	}
+	else
 	{
-		coef[cuts->val[c]->row_num - num->mast_rows] = (double) k
-				/ (double) cuts->val[c]->cut_obs;
-		etaFlag = TRUE;
+		/* if feasibility cut is added without any general cut, eta's lower bd sholud be 0. Yifan 08/26/2011*/
+		obj[0] = 0.0;
+		lb[0] = -(double) cell->k * cell->eta_shift;
 	}
 
-	/*
-	 ** Change the eta column in the master program, which corresponds
-	 ** to the eta variable, starting with the row after the A matrix
-	 ** and ending with the row of the last cut.
-	 */
-	if (!(change_col(p, num->mast_cols, coef, num->mast_rows,
-			num->mast_rows + cuts->cnt)))
+	if (obj[0] != cell->eta_obj)
 	{
-		print_contents(p, "contents.out");
-		err_msg("change_col", "change_eta_col", "returned FALSE");
+		change_objective(p, 1, eta_col, obj);
+		cell->eta_obj = obj[0];
 	}
 
-	/*added by Yifan to update the coefficient of eta in the objective 08/24/2011*/
-	if (etaFlag == TRUE)
+	if (lb[0] != cell->eta_lb)
 	{
-		change_objective(p, 1, eta_col, eta_coef1);
-		lb_0_neginf[0] = -INFBOUND;
+		change_bound(p, 1, eta_col, lu, lb); /* 2011.10.30 */
+		cell->eta_lb = lb[0];
 	}
+}
+
+/***********************************************************************\
+** This function sets up the scaled eta column (see change_eta_col())
+ ** for a freshly copied master.  new_master() gives eta a cost of one,
+ ** no lower bound, and a coefficient of one in every existing cut, so
+ ** those cuts are rewritten in their scaled form here.
+ \***********************************************************************/
+void init_eta_col(sdglobal_type* sd_global, cell_type *cell, num_type *num)
+{
+	sparse_matrix coef;
+	int *indices;
+	double *rhs;
+	int c;
+
+#ifdef TRACE
+	printf("Inside init_eta_col\n");
+#endif
+
+	if (sd_global->config.MASTER_TYPE == SDQP && sd_global->config.LB_TYPE == 1)
+		cell->eta_shift = sd_global->Eta0;
 	else
+		cell->eta_shift = 0.0;
+	cell->eta_obj = 1.0;
+	cell->eta_lb = -INFBOUND;
+
+	if (cell->cuts->cnt == 0)
+		return;
+
+	coef.cnt = cell->cuts->cnt;
+	if (!(coef.row = arr_alloc(cell->cuts->cnt, int)))
+		err_msg("Allocation", "init_eta_col", "coef.row");
+	if (!(coef.col = arr_alloc(cell->cuts->cnt, int)))
+		err_msg("Allocation", "init_eta_col", "coef.col");
+	if (!(coef.val = arr_alloc(cell->cuts->cnt, double)))
+		err_msg("Allocation", "init_eta_col", "coef.val");
+	if (!(indices = arr_alloc(cell->cuts->cnt, int)))
+		err_msg("Allocation", "init_eta_col", "indices");
+	if (!(rhs = arr_alloc(cell->cuts->cnt, double)))
+		err_msg("Allocation", "init_eta_col", "rhs");
+
+	for (c = 0; c < cell->cuts->cnt; c++)
 	{
-		change_objective(p, 1, eta_col, eta_coef0);
-		lb_0_neginf[0] = 0.0;
+		coef.row[c] = indices[c] = cell->cuts->val[c]->row_num;
+		coef.col[c] = num->mast_cols;
+		coef.val[c] = 1.0 / (double) cell->cuts->val[c]->cut_obs;
+		rhs[c] = cell->cuts->val[c]->alpha - cell->eta_shift;
 	}
 
-	change_bound(p, 1, eta_col, lu, lb_0_neginf); /* 2011.10.30 */
-	/* if feasibility cut is added without any general cut, eta's lower bd sholud be 0. Yifan 08/26/2011*/
+	if (!change_coef(cell->master, &coef)
+			|| change_rhside(cell->master, cell->cuts->cnt, indices, rhs))
+	{
+		print_contents(cell->master, "contents.out");
+		err_msg("change_coef", "init_eta_col", "returned FALSE");
+	}
+
+	mem_free(coef.row);
+	mem_free(coef.col);
+	mem_free(coef.val);
+	mem_free(indices);
+	mem_free(rhs);
+}
+
+/***********************************************************************\
+** Since the master holds zeta = k * (eta - shift) in place of eta, its
+ ** objective value misses the constant shift whenever eta is costed.
+ ** This function returns the amount to add back.
+ \***********************************************************************/
+double eta_offset(cell_type *cell)
+{
+	return cell->eta_obj != 0.0 ? cell->eta_shift : 0.0;
+}
 
-	mem_free(coef);
+/***********************************************************************\
+** The reduced cost the solver reports for zeta is 1/k times that of
+ ** eta.  This function converts it back, in place, in the vector of
+ ** reduced costs obtained from get_dual_slacks().
+ \***********************************************************************/
+void unscale_eta_dj(vector dj, cell_type *cell, num_type *num)
+{
+	if (cell->k > 0)
+		dj[num->mast_cols + 1] *= (double) cell->k;
 }
 
 /***********************************************************************\
@@ -494,7 +558,7 @@ one_problem *new_master(one_problem *master, cut_type *cuts, int extra_cuts,
 	printf("Inside new_master\n");
 #endif
 
-	if (!(copy = (one_problem *) mem_malloc (sizeof(one_problem))))
+	if (!(copy = (one_problem *) mem_malloc_in (MEM_SOLVER, sizeof(one_problem))))
 		err_msg("Allocation", "new_master", "copy");
 
 	/* Initialize unused fields in a master copy's CPLEX data. */
@@ -526,35 +590,35 @@ one_problem *new_master(one_problem *master, cut_type *cuts, int extra_cuts,
 	copy->objsen = master->objsen;
 
 	/* Make all allocations of known sizes, as calculated above */
-	if (!(copy->name = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->name = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "new_master", "copy->name");
-	if (!(copy->objname = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->objname = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "new_master", "copy->objname");
-	if (!(copy->objx = arr_alloc(copy->macsz, double)))
+	if (!(copy->objx = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->objx");
-	if (!(copy->bdl = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdl = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->bdl");
-	if (!(copy->bdu = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdu = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "new_master", "copy->bdu");
-	if (!(copy->rhsx = arr_alloc(copy->marsz, double)))
+	if (!(copy->rhsx = arr_alloc_in(MEM_SOLVER, copy->marsz, double)))
 		err_msg("Allocation", "new_master", "copy->rhsx");
-	if (!(copy->senx = arr_alloc(copy->marsz, char)))
+	if (!(copy->senx = arr_alloc_in(MEM_SOLVER, copy->marsz, char)))
 		err_msg("Allocation", "new_master", "copy->senx");
-	if (!(copy->matbeg = arr_alloc(copy->macsz, int)))
+	if (!(copy->matbeg = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "new_master", "copy->matbeg");
-	if (!(copy->matcnt = arr_alloc(copy->macsz, int)))
+	if (!(copy->matcnt = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "new_master", "copy->matcnt");
-	if (!(copy->cname = arr_alloc(copy->macsz, string)))
+	if (!(copy->cname = arr_alloc_in(MEM_SOLVER, copy->macsz, string)))
 		err_msg("Allocation", "new_master", "copy->cname");
-	if (!(copy->cstore = arr_alloc(copy->cstorsz, char)))
+	if (!(copy->cstore = arr_alloc_in(MEM_SOLVER, copy->cstorsz, char)))
 		err_msg("Allocation", "new_master", "copy->cstore");
-	if (!(copy->rname = arr_alloc(copy->marsz, string)))
+	if (!(copy->rname = arr_alloc_in(MEM_SOLVER, copy->marsz, string)))
 		err_msg("Allocation", "new_master", "copy->rname");
-	if (!(copy->rstore = arr_alloc(copy->rstorsz, char)))
+	if (!(copy->rstore = arr_alloc_in(MEM_SOLVER, copy->rstorsz, char)))
 		err_msg("Allocation", "new_master", "copy->rstore");
-	if (!(copy->matval = arr_alloc(copy->matsz, double)))
+	if (!(copy->matval = arr_alloc_in(MEM_SOLVER, copy->matsz, double)))
 		err_msg("Allocation", "new_master", "copy->matval");
-	if (!(copy->matind = arr_alloc(copy->matsz, int)))
+	if (!(copy->matind = arr_alloc_in(MEM_SOLVER, copy->matsz, int)))
 		err_msg("Allocation", "new_master", "copy->matind");
 
 	/*
@@ -698,7 +762,7 @@ one_problem *orig_new_master(one_problem *master, cut_type *cuts,
 	printf("Inside orig_new_master\n");
 #endif
 
-	if (!(copy = (one_problem *) mem_malloc (sizeof(one_problem))))
+	if (!(copy = (one_problem *) mem_malloc_in (MEM_SOLVER, sizeof(one_problem))))
 		err_msg("Allocation", "orig_new_master", "copy");
 
 	/* Initialize unused fields in a master copy's CPLEX data. */
@@ -730,35 +794,35 @@ one_problem *orig_new_master(one_problem *master, cut_type *cuts,
 	copy->objsen = master->objsen;
 
 	/* Make all allocations of known sizes, as calculated above */
-	if (!(copy->name = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->name = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "orig_new_master", "copy->name");
-	if (!(copy->objname = arr_alloc(NAME_SIZE, char)))
+	if (!(copy->objname = arr_alloc_in(MEM_SOLVER, NAME_SIZE, char)))
 		err_msg("Allocation", "orig_new_master", "copy->objname");
-	if (!(copy->objx = arr_alloc(copy->macsz, double)))
+	if (!(copy->objx = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "orig_new_master", "copy->objx");
-	if (!(copy->bdl = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdl = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "orig_new_master", "copy->bdl");
-	if (!(copy->bdu = arr_alloc(copy->macsz, double)))
+	if (!(copy->bdu = arr_alloc_in(MEM_SOLVER, copy->macsz, double)))
 		err_msg("Allocation", "orig_new_master", "copy->bdu");
-	if (!(copy->rhsx = arr_alloc(copy->marsz, double)))
+	if (!(copy->rhsx = arr_alloc_in(MEM_SOLVER, copy->marsz, double)))
 		err_msg("Allocation", "orig_new_master", "copy->rhsx");
-	if (!(copy->senx = arr_alloc(copy->marsz, char)))
+	if (!(copy->senx = arr_alloc_in(MEM_SOLVER, copy->marsz, char)))
 		err_msg("Allocation", "orig_new_master", "copy->senx");
-	if (!(copy->matbeg = arr_alloc(copy->macsz, int)))
+	if (!(copy->matbeg = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "orig_new_master", "copy->matbeg");
-	if (!(copy->matcnt = arr_alloc(copy->macsz, int)))
+	if (!(copy->matcnt = arr_alloc_in(MEM_SOLVER, copy->macsz, int)))
 		err_msg("Allocation", "orig_new_master", "copy->matcnt");
-	if (!(copy->cname = arr_alloc(copy->macsz, string)))
+	if (!(copy->cname = arr_alloc_in(MEM_SOLVER, copy->macsz, string)))
 		err_msg("Allocation", "orig_new_master", "copy->cname");
-	if (!(copy->cstore = arr_alloc(copy->cstorsz, char)))
+	if (!(copy->cstore = arr_alloc_in(MEM_SOLVER, copy->cstorsz, char)))
 		err_msg("Allocation", "orig_new_master", "copy->cstore");
-	if (!(copy->rname = arr_alloc(copy->marsz, string)))
+	if (!(copy->rname = arr_alloc_in(MEM_SOLVER, copy->marsz, string)))
 		err_msg("Allocation", "orig_new_master", "copy->rname");
-	if (!(copy->rstore = arr_alloc(copy->rstorsz, char)))
+	if (!(copy->rstore = arr_alloc_in(MEM_SOLVER, copy->rstorsz, char)))
 		err_msg("Allocation", "orig_new_master", "copy->rstore");
-	if (!(copy->matval = arr_alloc(copy->matsz, double)))
+	if (!(copy->matval = arr_alloc_in(MEM_SOLVER, copy->matsz, double)))
 		err_msg("Allocation", "orig_new_master", "copy->matval");
-	if (!(copy->matind = arr_alloc(copy->matsz, int)))
+	if (!(copy->matind = arr_alloc_in(MEM_SOLVER, copy->matsz, int)))
 		err_msg("Allocation", "orig_new_master", "copy->matind");
 
 	/*
@@ -921,33 +985,3 @@ void free_master(one_problem *copy)
 	free_one_prob(copy);
 }
 
-void update_rhs(sdglobal_type* sd_global, prob_type *prob, cell_type *cell,
-		soln_type *soln)
-{
-	int cnt;
-	double *rhs;
-	int *indices;
-
-#ifdef TRACE
-	printf("Inside change_rhs.\n");
-#endif
-
-	if (!(rhs = arr_alloc(cell->cuts->cnt, double)))
-		err_msg("Allocation", "change_rhs", "rhs");
-	if (!(indices = arr_alloc(cell->cuts->cnt, int)))
-		err_msg("Allocation", "change_rhs", "indices");
-
-	for (cnt = 0; cnt < cell->cuts->cnt; cnt++)
-	{
-		rhs[cnt] = cell->cuts->val[cnt]->alpha_incumb;
-		rhs[cnt] += ((double) cell->k / (double) cell->cuts->val[cnt]->cut_obs
-				- 1) * sd_global->Eta0;
-		indices[cnt] = cell->cuts->val[cnt]->row_num;
-	}
-
-	/* Now we change the rhs of the master problem. */
-	change_rhside(cell->master, cell->cuts->cnt, indices, rhs);
-	mem_free(rhs);
-	mem_free(indices);
-}
-
@@ -17,9 +17,10 @@ one_problem *new_master(one_problem *master, cut_type *cuts, int extra_cuts,
 		vector x_k);
 one_problem *orig_new_master(one_problem *master, cut_type *cuts,
 		int extra_cuts);
-void change_eta_col(one_problem *p, cut_type *cuts, int k, soln_type *soln,
-		num_type *num);
+void change_eta_col(one_problem *p, cell_type *cell, num_type *num);
+void init_eta_col(sdglobal_type* sd_global, cell_type *cell, num_type *num);
+double eta_offset(cell_type *cell);
+void unscale_eta_dj(vector dj, cell_type *cell, num_type *num);
 void free_master(one_problem *copy);
-void update_rhs(sdglobal_type* sd_global, prob_type *prob, cell_type *cell, soln_type *soln);
 
 #endif /* MASTER_H_ */
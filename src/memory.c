@@ -41,6 +41,7 @@ void write_statistics(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	/* int		cnt, idx;*/
 	clock_t cur_clock;
 	double conf_int[2];
+	FILE *f_mem;
 	/*added by Yifan to print out 1st stage solutions xlm files*/
 	/*
 	 char		mname[20] = "m   .xlm";
@@ -57,6 +58,15 @@ void write_statistics(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	cur_clock = clock();
 //	time_diff = cur_clock - sd_global->LAST_CLOCK;
 	sd_global->LAST_CLOCK = cur_clock;
+	sd_global->MEM_USED = mem_in_use(MEM_SUBSYS, FALSE);
+
+	/* Record the memory each subsystem holds, once a print cycle */
+	if (!(c->k % sd_global->config.PRINT_CYCLE)
+			&& (f_mem = fopen(MEM_DAT, "a")))
+	{
+		write_mem_usage(f_mem, p->current_batch_id, c->k);
+		fclose(f_mem);
+	}
 
 #ifdef WRITE
 	/* Write out the size of each structure, plus memory allocated */
@@ -111,9 +121,6 @@ void thin_data(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	printf("Inside thin_data()\n");
 #endif
 
-	/* Reset the amount of memory allocated during this iteration */
-	sd_global->MEM_USED = 0;
-
 	/* If its possible to thin out any cuts, then try it */
 	if (c->k >= sd_global->config.DROP_TIME)
 		thin_cuts(sd_global, p, c, s);
@@ -163,7 +170,7 @@ void thin_pi(prob_type *p, cell_type *c, soln_type *s)
 	{
 		for (idx = 0; idx < c->cuts->val[cnt]->omega_cnt; idx++)
 		{
-			pi_idx = c->cuts->val[cnt]->istar[idx];
+			pi_idx = get_istar(c->cuts->val[cnt], idx);
 
 #ifdef PIS
 			if (pi_idx < 0 || pi_idx >= c->sigma->cnt)
@@ -215,7 +222,7 @@ void thin_pi(prob_type *p, cell_type *c, soln_type *s)
 		if (lamb_histo[pi_idx] == 0)
 		{
 			++lamb_cnt;
-			drop_lambda(c->lambda, s->delta, s->omega, c->sigma, pi_idx);
+			drop_lambda(c->lambda, s->delta, c->sigma, pi_idx);
 		}
 	}
 
@@ -233,6 +240,129 @@ void thin_pi(prob_type *p, cell_type *c, soln_type *s)
 	mem_free(lamb_histo);
 }
 
+/***************************************************************************\
+** This function keeps the memory in use within MEM_BUDGET megabytes.
+ ** Once it passes BUDGET_HIGH of the budget, the dual vectors in lambda
+ ** whose entries in sigma have gone longest without being an istar are
+ ** evicted, as many as should bring it down to BUDGET_LOW of the budget
+ ** (each takes a row of delta with it), though never one that was an
+ ** istar this iteration.  The cuts stay valid: the istars that referred
+ ** to an evicted sigma are recomputed, at the incumbent, from the ones
+ ** that remain.  Observations can not be evicted without biasing the
+ ** estimates, so they are only merged with their duplicates.
+ \***************************************************************************/
+void thin_to_budget(sdglobal_type* sd_global, prob_type *p, cell_type *c,
+		soln_type *s)
+{
+	sd_long in_use, budget;
+	size_t lamb_size;
+	int *lamb_last, *histo;
+	BOOL *evict;
+	vector pi_Tbar_x;
+	double argmax;
+	int cnt, obs, pi_idx, idx, n_evict, cutoff;
+	int sig_cnt = 0;
+	int lamb_cnt = 0;
+
+	if (sd_global->config.MEM_BUDGET <= 0)
+		return;
+	budget = (sd_long) sd_global->config.MEM_BUDGET * 1024 * 1024;
+	in_use = mem_in_use(MEM_SUBSYS, FALSE);
+	if (in_use <= BUDGET_HIGH * budget || c->lambda->cnt < 2)
+		return;
+
+#ifdef TRACE
+	printf("Inside thin_to_budget()\n");
+#endif
+
+	/* A lambda was last used when the last of its sigmas was */
+	lamb_last = scratch_alloc(c->scratch, c->lambda->cnt, int);
+	for (pi_idx = 0; pi_idx < c->lambda->cnt; pi_idx++)
+		lamb_last[pi_idx] = -1;
+	for (pi_idx = 0; pi_idx < c->sigma->cnt; pi_idx++)
+		if (lamb_last[c->sigma->lamb[pi_idx]] < c->sigma->last[pi_idx])
+			lamb_last[c->sigma->lamb[pi_idx]] = c->sigma->last[pi_idx];
+
+	/* What a lambda holds: its delta row and pi X T vectors, and itself
+	 (sparse, so taken as the average of those stored).  Vectors kept in
+	 a mapped file are not counted in use, so evicting them frees none */
+	lamb_size = s->delta->row_pool->size
+			+ mem_in_use(MEM_LAMBDA, FALSE) / c->lambda->cnt;
+	if (!s->delta->map)
+		lamb_size += s->omega->cnt * s->delta->vect_size;
+	n_evict = (int) ((in_use - BUDGET_LOW * budget) / lamb_size) + 1;
+	n_evict = min(n_evict, c->lambda->cnt - 1);
+
+	/* Count the lambdas last used in each iteration (a bucket up, for
+	 those never used), and find the bucket the coldest n_evict end in;
+	 those of this iteration stay */
+	histo = scratch_alloc(c->scratch, c->k + 2, int);
+	for (pi_idx = 0; pi_idx < c->lambda->cnt; pi_idx++)
+		++histo[min(lamb_last[pi_idx], c->k) + 1];
+	idx = 0;
+	for (cutoff = 0; cutoff < c->k && idx + histo[cutoff] < n_evict; cutoff++)
+		idx += histo[cutoff];
+	n_evict = min(n_evict - idx, histo[cutoff]);
+
+	/* All of the colder buckets go, and the first n_evict of that one */
+	evict = scratch_alloc(c->scratch, c->lambda->cnt, BOOL);
+	for (pi_idx = 0; pi_idx < c->lambda->cnt; pi_idx++)
+		if (lamb_last[pi_idx] + 1 < cutoff)
+			evict[pi_idx] = TRUE;
+		else if (lamb_last[pi_idx] + 1 == cutoff && n_evict > 0)
+		{
+			evict[pi_idx] = TRUE;
+			n_evict--;
+		}
+
+	/* Flag the istars of the sigmas that go, then drop those sigmas */
+	for (cnt = 0; cnt < c->cuts->cnt; cnt++)
+		for (obs = 0; obs < c->cuts->val[cnt]->omega_cnt; obs++)
+			if (get_istar(c->cuts->val[cnt], obs) >= 0
+					&& evict[c->sigma->lamb[get_istar(c->cuts->val[cnt], obs)]])
+				set_istar(c->cuts->slab, c->cuts->val[cnt], obs, EVICTED);
+	for (pi_idx = c->sigma->cnt - 1; pi_idx >= 0; pi_idx--)
+		if (evict[c->sigma->lamb[pi_idx]])
+		{
+			++sig_cnt;
+			drop_sigma(c->sigma, c->cuts, pi_idx);
+		}
+
+	/* No sigma refers to them any longer */
+	for (pi_idx = c->lambda->cnt - 1; pi_idx >= 0; pi_idx--)
+		if (evict[pi_idx])
+		{
+			++lamb_cnt;
+			drop_lambda(c->lambda, s->delta, c->sigma, pi_idx);
+		}
+
+	/* Recompute the flagged istars, as SD_cut() would at the incumbent */
+	pi_Tbar_x = scratch_alloc(c->scratch, c->sigma->cnt, double);
+	for (pi_idx = 0; pi_idx < c->sigma->cnt; pi_idx++)
+		for (idx = 1; idx <= p->num->nz_cols; idx++)
+			pi_Tbar_x[pi_idx] += c->sigma->val[pi_idx].T[idx]
+					* s->incumb_x[c->sigma->col[idx]];
+	for (cnt = 0; cnt < c->cuts->cnt; cnt++)
+		for (obs = 0; obs < c->cuts->val[cnt]->omega_cnt; obs++)
+			if (get_istar(c->cuts->val[cnt], obs) == EVICTED)
+			{
+				if (valid_omega_idx(s->omega, obs) && c->sigma->cnt)
+					set_istar(c->cuts->slab, c->cuts->val[cnt], obs,
+							compute_istar(obs, c->cuts->val[cnt], c->sigma,
+									s->delta, s->incumb_x, p->num, pi_Tbar_x,
+									&argmax, FALSE, c->k).sigma);
+				else
+					set_istar(c->cuts->slab, c->cuts->val[cnt], obs, DROPPED);
+			}
+
+	thin_omega(sd_global, p, c, s);
+
+#ifdef RUN
+	printf("thin_to_budget() evicted %d sigmas and %d lambdas at %lld KB.\n",
+			sig_cnt, lamb_cnt, in_use / 1024);
+#endif
+}
+
 /***************************************************************************\
 ** This function steps through the observations in omega and eliminates
  ** any which do not seem necessary.  This involves freeing the entry
@@ -241,7 +371,9 @@ void thin_pi(prob_type *p, cell_type *c, soln_type *s)
 void thin_omega(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s)
 {
-	int obs, dupl;
+	int obs, dupl, cnt, top, size;
+	int *head, *next;
+	unsigned int *sig;
 	int omeg_cnt = 0;
 
 #ifdef TRACE
@@ -249,34 +381,106 @@ void thin_omega(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 
 #endif
 
-	/* Loop through the latest observations of omega, starting at the end */
-	for (obs = s->omega->most - 1; obs >= s->omega->last; obs--)
+	/*
+	 ** Signatures are taken over the cuts which hold every observation up
+	 ** to _top_; those beyond it wait until a cut covers them.
+	 */
+	top = 0;
+	for (cnt = 0; cnt < c->cuts->cnt; cnt++)
+		if (c->cuts->val[cnt]->omega_cnt > top)
+			top = c->cuts->val[cnt]->omega_cnt;
+	if (top > s->omega->most)
+		top = s->omega->most;
+	if (top <= s->omega->last)
+		return;
+
+	/* Chain the observations into buckets by signature, in scratch */
+	for (size = MEMO_START; size < 2 * top; size *= 2)
+		;
+	head = scratch_alloc(c->scratch, size, int);
+	next = scratch_alloc(c->scratch, top, int);
+	sig = scratch_alloc(c->scratch, top, unsigned int);
+	for (cnt = 0; cnt < size; cnt++)
+		head[cnt] = -1;
+
+	/* Earlier observations are chained first, so only newer ones are dropped */
+	for (obs = 0; obs < top; obs++)
 	{
 
 #ifdef OMEG
-		printf("Checking omega %d.\n");
+		printf("Checking omega %d.\n", obs);
 #endif
 
 		/* First make sure the observation hasn't been dropped already */
-		if (valid_omega_idx(s->omega, obs))
+		if (!valid_omega_idx(s->omega, obs))
+			continue;
+
+		sig[obs] = omega_signature(sd_global, c->cuts, c->sigma, s->delta,
+				obs, top);
+
+		/* Only compare in full against the observations in the same bucket */
+		if (obs >= s->omega->last)
 		{
-			/* Check whether this observation has been duplicated by another */
-			if (duplicate_omega(sd_global, p, c, s, obs, &dupl))
+			for (dupl = head[sig[obs] & (size - 1)]; dupl >= 0; dupl =
+					next[dupl])
+				if (sig[dupl] == sig[obs]
+						&& duplic_omega_col(sd_global, c->cuts, c->sigma,
+								s->delta, p->num, dupl, obs))
+					break;
+
+			if (dupl >= 0)
 			{
 				/* Drop this omega in favor of its duplicate */
 				drop_omega(s->omega, s->delta, c->lambda, c->cuts, obs, dupl);
 				omeg_cnt++;
+				continue;
 			}
 		}
+
+		next[obs] = head[sig[obs] & (size - 1)];
+		head[sig[obs] & (size - 1)] = obs;
 	}
 	/* Next time we'll stop where we started this time */
-	s->omega->last = s->omega->most;
+	s->omega->last = top;
 
 #ifdef RUN
 	printf("thin_omega() dropped %d omegas.\n", omeg_cnt);
 #endif
 }
 
+/***************************************************************************\
+** This function hashes the istars of observation _obs_ in every cut that
+ ** holds all observations below _top_, together with its Pi x Romega in
+ ** each of those rows of delta.  Pi x Romega is cut to THIN_TOLER of its
+ ** mantissa first, so two observations that duplic_omega_col() would match
+ ** nearly always share a signature; a pair split by a bin edge is simply
+ ** left unmerged.
+ \***************************************************************************/
+unsigned int omega_signature(sdglobal_type* sd_global, cut_type *cuts,
+		sigma_type *sigma, delta_type *delta, int obs, int top)
+{
+	unsigned int h = 2166136261u;
+	double mant;
+	int cnt, pi, expo;
+
+	for (cnt = 0; cnt < cuts->cnt; cnt++)
+		if (cuts->val[cnt]->omega_cnt >= top)
+		{
+			pi = get_istar(cuts->val[cnt], obs);
+			h = (h ^ (unsigned int) (pi + 2)) * 16777619u;
+			if (pi < 0)
+				continue;
+
+			mant = frexp(delta->val[sigma->lamb[pi]][obs].R, &expo);
+			if (sd_global->config.THIN_TOLER > 0.0)
+				mant = floor(mant / sd_global->config.THIN_TOLER);
+			h = (h ^ (unsigned int) (sd_long) mant) * 16777619u;
+			h = (h ^ (unsigned int) expo) * 16777619u;
+		}
+
+	return h;
+}
+
 /***************************************************************************\
 ** This function drops a designated row from the sigma structure.  The
  ** row is freed, the count is decremented, and the last entry in sigma
@@ -296,17 +500,19 @@ void drop_sigma(sigma_type *sigma, cut_type *cuts, int idx)
 	--sigma->cnt;
 
 	/* Free the data associated with the dropped one */
-	mem_free(sigma->val[idx].T);
+	pool_free(sigma->pool, sigma->val[idx].T);
 
 	/* Swap the last entry into the open position */
 	sigma->lamb[idx] = sigma->lamb[sigma->cnt];
 	sigma->val[idx] = sigma->val[sigma->cnt];
+	sigma->ck[idx] = sigma->ck[sigma->cnt];
+	sigma->last[idx] = sigma->last[sigma->cnt];
 
 	/* Update the istars of any cut which referenced the swapped sigma */
 	for (cnt = 0; cnt < cuts->cnt; cnt++)
 		for (obs = 0; obs < cuts->val[cnt]->omega_cnt; obs++)
-			if (cuts->val[cnt]->istar[obs] == sigma->cnt)
-				cuts->val[cnt]->istar[obs] = idx;
+			if (get_istar(cuts->val[cnt], obs) == sigma->cnt)
+				set_istar(cuts->slab, cuts->val[cnt], obs, idx);
 
 	/* Here you should do something to fix up the istars of dropped sigma */
 }
@@ -321,8 +527,8 @@ void drop_sigma(sigma_type *sigma, cut_type *cuts, int idx)
  ** corresponds (1-to-1) to a row in delta, so this function calls on
  ** drop_delta_row() to free it.
  \***************************************************************************/
-void drop_lambda(lambda_type *lambda, delta_type *delta, omega_type *omega,
-		sigma_type *sigma, int idx)
+void drop_lambda(lambda_type *lambda, delta_type *delta, sigma_type *sigma,
+		int idx)
 {
 	int cnt;
 
@@ -334,13 +540,15 @@ void drop_lambda(lambda_type *lambda, delta_type *delta, omega_type *omega,
 	--lambda->cnt;
 
 	/* Free the designated lambda vector */
-	mem_free(lambda->val[idx]);
+	mem_free(lambda->val[idx].row);
+	mem_free(lambda->val[idx].val);
 
 	/* Swap the last entry in lambda into the emptied position */
 	lambda->val[idx] = lambda->val[lambda->cnt];
+	lambda->hash[idx] = lambda->hash[lambda->cnt];
 
 	/* Update the rest of the world, to make it look like lambda never existed */
-	drop_delta_row(delta, lambda, omega, idx);
+	drop_delta_row(delta, lambda, idx);
 
 	/* Change any references in sigma to the swapped entry in lambda */
 	for (cnt = 0; cnt < sigma->cnt; cnt++)
@@ -372,7 +580,7 @@ void drop_omega(omega_type *omega, delta_type *delta, lambda_type *lambda,
 #endif
 
 	/* Free the entry in omega */
-	mem_free(omega->idx[drop]);
+	pool_free(omega->pool, omega->idx[drop]);
 
 	/* Free the column in delta */
 	drop_delta_col(delta, lambda, drop);
@@ -380,7 +588,7 @@ void drop_omega(omega_type *omega, delta_type *delta, lambda_type *lambda,
 	/* Fix the cuts' istars, so the dropped omega is erased */
 	for (cnt = 0; cnt < cuts->cnt; cnt++)
 		if (drop < cuts->val[cnt]->omega_cnt)
-			cuts->val[cnt]->istar[drop] = DROPPED;
+			set_istar(cuts->slab, cuts->val[cnt], drop, DROPPED);
 
 	/* Update the counters of the omega structure */
 	omega->weight[keep] += omega->weight[drop];
@@ -392,121 +600,51 @@ void drop_omega(omega_type *omega, delta_type *delta, lambda_type *lambda,
 }
 
 /***************************************************************************\
-** This function determines whether the specified observation of omega
- ** is essentially a duplicate of some previous observation.  It returns
- ** TRUE if (according to some criteria) it's a duplicate; FALSE otherwise.
- ** It initializes the _dupl_ parameter with the index of the duplicate.
+** This function compares the columns of two observations in delta over
+ ** every row that either of them uses as an istar in some cut.  Rows
+ ** shared by several cuts are simply compared again.
  \***************************************************************************/
-BOOL duplicate_omega(sdglobal_type* sd_global, prob_type *p, cell_type *c,
-		soln_type *s, int obs, int *dupl)
+BOOL duplic_omega_col(sdglobal_type* sd_global, cut_type *cuts,
+		sigma_type *sigma, delta_type *delta, num_type *num, int omeg_idx,
+		int obs)
 {
-#ifdef OMEG
-	int cnt;
-#endif
-	int omeg_idx;
-	int *marked1, *marked2;
-
-	/* Allocate arrays large enough to flag any pi in sigma */
-	if (!(marked1 = arr_alloc(c->sigma->cnt, int)))
-		err_msg("Allocation", "duplicate_omega", "marked1");
-	if (!(marked2 = arr_alloc(c->sigma->cnt, int)))
-		err_msg("Allocation", "duplicate_omega", "marked2");
-
-	/* Mark all of the pi's used as istars for omega _obs_ */
-	mark_used_pis(marked1, c->cuts, obs);
-
-#ifdef OMEG
-	printf("Marked1 array: ");
-	for (cnt = 0; cnt < c->sigma->cnt; cnt++)
-	printf("%d ", marked1[cnt]);
-	printf(" MMM\n");
-#endif
+	int cnt, pi;
 
-	/* Loop through all the previous omegas */
-	for (omeg_idx = obs - 1; omeg_idx >= 0; omeg_idx--)
+	for (cnt = 0; cnt < cuts->cnt; cnt++)
 	{
-		if (valid_omega_idx(s->omega, omeg_idx))
-		{
-			/* Copy the original marked array of the _obs_ omega */
-			copy_arr(marked2, marked1, c->sigma->cnt - 1);
-
-			/* Add marks for all pi's used as istars of the current observation */
-			mark_used_pis(marked2, c->cuts, omeg_idx);
-
-			/* Compare the two observations in the marked rows of delta */
-			if (duplic_delta_col(sd_global, s->delta, c->sigma, p->num, marked2,
-					omeg_idx, obs))
-			{
-				*dupl = omeg_idx;
-				return TRUE;
-			}
-		}
+		if (omeg_idx < cuts->val[cnt]->omega_cnt
+				&& (pi = get_istar(cuts->val[cnt], omeg_idx)) >= 0
+				&& !duplic_delta_row(sd_global, delta, num, sigma->lamb[pi],
+						omeg_idx, obs))
+			return FALSE;
+		if (obs < cuts->val[cnt]->omega_cnt
+				&& (pi = get_istar(cuts->val[cnt], obs)) >= 0
+				&& !duplic_delta_row(sd_global, delta, num, sigma->lamb[pi],
+						omeg_idx, obs))
+			return FALSE;
 	}
 
-	mem_free(marked1);
-	mem_free(marked2);
-	*dupl = -1;
-
-	return FALSE;
-}
-
-/***************************************************************************\
-** This function determines whether two columns in delta are essentially
- ** the same by checking the rows specified by in _marked_ array.
- ** It returns TRUE if the two columns were within the tolerance for
- ** every row in the marked array; FALSE otherwise.
- \***************************************************************************/
-BOOL duplic_delta_col(sdglobal_type* sd_global, delta_type *delta,
-		sigma_type *sigma, num_type *num, int *marked, int omeg_idx, int obs)
-{
-	int cnt, pi;
-
-#ifdef LOOP
-	printf("Inside duplic_delta_col()\n");
-#endif
-
-	/* Loop through all the rows in the marked array */
-	for (cnt = 0; cnt < sigma->cnt; cnt++)
-		if (marked[cnt] == USED)
-		{
-			/* Locate row in delta */
-			pi = sigma->lamb[cnt];
-
-			/* Check the Pi x Romega field for significant difference */
-			if (DBL_ABS(delta->val[pi][omeg_idx].R - delta->val[pi][obs].R)
-					> DBL_ABS(sd_global->config.THIN_TOLER * delta->val[pi][obs].R))
-				return FALSE;
-
-			/* Check the Pi x Tomega vector for significant difference */
-			if (!equal_arr(delta->val[pi][obs].T, delta->val[pi][omeg_idx].T,
-					num->rv_cols, sd_global->config.THIN_TOLER))
-				return FALSE;
-		}
-
 	return TRUE;
 }
 
 /***************************************************************************\
-** This function tallies those pi's which are referenced by the istar 
- ** field of the current cuts.  For each cut, it evaluates the _obs_ entry
- ** in the istar array and marks that field in the _marked_ array as USED.
- ** Entries in the marked array which aren't used as istars are left alone.
+** This function compares two observations in row _pi_ of delta.  It
+ ** returns TRUE if both Pi x Romega and Pi x Tomega agree within THIN_TOLER.
  \***************************************************************************/
-void mark_used_pis(int *marked, cut_type *cuts, int obs)
+BOOL duplic_delta_row(sdglobal_type* sd_global, delta_type *delta,
+		num_type *num, int pi, int omeg_idx, int obs)
 {
-	int cnt, pi;
+	/* Check the Pi x Romega field for significant difference */
+	if (DBL_ABS(delta->val[pi][omeg_idx].R - delta->val[pi][obs].R)
+			> DBL_ABS(sd_global->config.THIN_TOLER * delta->val[pi][obs].R))
+		return FALSE;
 
-#ifdef LOOP
-	printf("Inside mark_used_pis()\n");
-#endif
+	/* Check the Pi x Tomega vector for significant difference */
+	if (!equal_coef(delta->val[pi][obs].T, delta->val[pi][omeg_idx].T,
+			num->rv_cols, sd_global->config.THIN_TOLER))
+		return FALSE;
 
-	for (cnt = 0; cnt < cuts->cnt; cnt++)
-		if (obs < cuts->val[cnt]->omega_cnt)
-		{
-			pi = cuts->val[cnt]->istar[obs];
-			if (pi >= 0)
-				marked[pi] = USED;
-		}
+	return TRUE;
 }
 
 /***************************************************************************\
@@ -5,6 +5,8 @@
  **
  **
  ** generate_observ()
+ ** generate_observ_u()
+ ** add_observ()
  ** equal_obs()
  ** valid_omega_idx()
  ** next_omega_idx()
@@ -13,6 +15,10 @@
  ** print_omega()
  ** new_omega()
  ** free_omega()
+ ** new_obs_memo()
+ ** free_obs_memo()
+ ** obs_memo_slot()
+ ** obs_memo_add()
  **
  ** History:
  **   ?? Oct 1991 - <Jason Mai> - created.
@@ -45,7 +51,6 @@ int generate_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num,
 		BOOL *new_omeg, sd_long *RUN_SEED)
 {
 	int *observ;
-	int cnt, next;
 
 #ifdef TRACE
 	printf("Inside generate_observ\n");
@@ -55,10 +60,41 @@ int generate_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num,
 	 ** Make room for the observations and their 1-norm, then request a 
 	 ** new vector of realizations (indices) along with the 1-norm.
 	 */
-	if (!(observ = arr_alloc(num->cipher+1, int)))
-		err_msg("Allocation", "generate_observ", "observ");
+	observ = pool_alloc(omega->pool, int);
 	observ[0] = get_omega_idx(sd_global, observ + 1, NULL, 1, RUN_SEED);
-        
+
+#ifdef TRACE
+	printf("Exiting generate_observ\n");
+#endif
+	return add_observ(omega, num, observ, new_omeg);
+}
+
+/***********************************************************************\
+** This function is the same as generate_observ(), except that the
+ ** realization is located from the uniforms in u (see omega_idx_from_u())
+ ** instead of from a seed.
+ \***********************************************************************/
+int generate_observ_u(sdglobal_type* sd_global, omega_type *omega, num_type *num,
+		BOOL *new_omeg, double *u)
+{
+	int *observ;
+
+	observ = pool_alloc(omega->pool, int);
+	observ[0] = omega_idx_from_u(sd_global, observ + 1, u);
+
+	return add_observ(omega, num, observ, new_omeg);
+}
+
+/***********************************************************************\
+** This function compares the realization vector observ with all the
+ ** previous ones.  If it finds a duplicate, it frees observ, raises the
+ ** weight of the duplicate and returns its index; otherwise, it adds
+ ** observ to the list of distinct realizations and returns its index.
+ \***********************************************************************/
+int add_observ(omega_type *omega, num_type *num, int *observ, BOOL *new_omeg)
+{
+	int cnt, next;
+
 	/* Compare vector with all the previous observations */
 	for (cnt = 0; cnt < omega->most; cnt++)
 		if (valid_omega_idx(omega, cnt))
@@ -66,7 +102,7 @@ int generate_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num,
 			{
 				(*new_omeg) = FALSE;
 				omega->weight[cnt]++;
-				mem_free(observ);
+				pool_free(omega->pool, observ);
 				//omega->batch_idx[omega->k] = omega->idx[cnt];
 				return cnt;
 			}
@@ -92,9 +128,6 @@ int generate_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num,
 	printf("cnt=%d, next=%d, most=%d.\n", omega->cnt, omega->next, omega->most);
 #endif
 
-#ifdef TRACE
-	printf("Exiting generate_observ\n");
-#endif
 	//omega->batch_idx[omega->k] = omega->idx[next];
 	return next;
 }
@@ -287,9 +320,11 @@ void print_omega(omega_type *omega, num_type *num, int idx)
  ** and the array of pointers to observation vectors (idx).  It 
  ** allocates the weight and filter arrays, and intializes cnt and next.
  ** However, the actual arrays of indices for each observation are
- ** NOT allocated, since this is done as each realization is observed.
+ ** NOT allocated, since this is done as each realization is observed,
+ ** from the pool set up here (_num_cipher_ ints and the 1-norm each).
  \***********************************************************************/
-omega_type *new_omega(int num_iter, int num_rv, coord_type *coord)
+omega_type *new_omega(int num_iter, int num_rv, int num_cipher,
+		coord_type *coord)
 {
 	omega_type *omega;
 
@@ -303,26 +338,34 @@ omega_type *new_omega(int num_iter, int num_rv, coord_type *coord)
 	if (!(omega->RT = (double *) mem_calloc (num_rv+1, sizeof(double))))
 		err_msg("Allocation", "new_omega", "omega->RT");
 
-	if (!(omega->weight = (int *) mem_calloc (num_iter, sizeof(int))))
+	if (!(omega->weight = (int *) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(int))))
 		err_msg("Allocation", "new_omega", "omega->weight");
 
 	/* Calloc automatically initializes the array to zero */
-	if (!(omega->filter = (int *) mem_calloc (num_iter, sizeof(int))))
+	if (!(omega->filter = (int *) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(int))))
 		err_msg("Allocation", "new_omega", "omega->filter");
 
 	/* Yifan 03/20/2012 Test for omega issues*/
-	if (!(omega->used_opt_cut = (BOOL *) mem_calloc (num_iter, sizeof(BOOL))))
+	if (!(omega->used_opt_cut = (BOOL *) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(BOOL))))
 		err_msg("Allocation", "new_omega", "omega->filter");
 
-	if (!(omega->idx = (int **) mem_calloc (num_iter, sizeof(int *))))
+	if (!(omega->idx = (int **) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(int *))))
 		err_msg("Allocation", "new_omega", "omega->idx");
 
-	if (!(omega->batch_idx = (int **) mem_calloc (num_iter, sizeof(int *))))
+	if (!(omega->batch_idx = (int **) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(int *))))
 		err_msg("Allocation", "new_omega", "omega->idx");
   
-    if(!(omega->fidx = (sd_long *) mem_calloc (num_iter, sizeof(sd_long))))
+    if(!(omega->fidx = (sd_long *) mem_calloc_in (MEM_OMEGA, num_iter,
+			sizeof(sd_long))))
       err_msg("Allocation", "new_omega", "omega->idx");
 
+	omega->pool = new_mem_pool((num_cipher + 1) * sizeof(int), POOL_BLOCK,
+			MEM_OMEGA);
 	omega->cnt = 0;
 	omega->next = 0;
 	omega->most = 0;
@@ -341,16 +384,12 @@ omega_type *new_omega(int num_iter, int num_rv, coord_type *coord)
  \***********************************************************************/
 void free_omega(omega_type *omega)
 {
-	int cnt;
-
 #ifdef TRACE
 	printf("Inside free_omega\n");
 #endif
 
-	for (cnt = 0; cnt < omega->most; cnt++)
-		if (valid_omega_idx(omega, cnt))
-			mem_free(omega->idx[cnt]);
-
+	/* The observations go with their pool */
+	free_mem_pool(omega->pool);
 	mem_free(omega->idx);
 	mem_free(omega->weight);
 	mem_free(omega->filter);
@@ -361,3 +400,106 @@ void free_omega(omega_type *omega)
 	mem_free(omega);
 }
 /*  */
+
+/***********************************************************************\
+** This function allocates an empty obs_memo_type for observations of
+ ** len integers (num->cipher+1, counting the 1-norm).
+ \***********************************************************************/
+obs_memo_type *new_obs_memo(int len)
+{
+	obs_memo_type *memo;
+
+	if (!(memo = (obs_memo_type *) mem_malloc (sizeof(obs_memo_type))))
+		err_msg("Allocation", "new_obs_memo", "memo");
+	if (!(memo->key = (int **) mem_calloc (MEMO_START, sizeof(int *))))
+		err_msg("Allocation", "new_obs_memo", "memo->key");
+	if (!(memo->val = arr_alloc(MEMO_START, double)))
+		err_msg("Allocation", "new_obs_memo", "memo->val");
+	memo->size = MEMO_START;
+	memo->cnt = 0;
+	memo->len = len;
+
+	return memo;
+}
+
+/***********************************************************************\
+** This function frees the memo, its stored observations included.
+ \***********************************************************************/
+void free_obs_memo(obs_memo_type *memo)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < memo->size; cnt++)
+		if (memo->key[cnt])
+			mem_free(memo->key[cnt]);
+	mem_free(memo->key);
+	mem_free(memo->val);
+	mem_free(memo);
+}
+
+/***********************************************************************\
+** This function returns the bucket of the memo which holds observ,
+ ** or, if observ has not been stored, the empty bucket where it would
+ ** go.  The caller tells the two apart by memo->key[slot] being NULL.
+ \***********************************************************************/
+int obs_memo_slot(obs_memo_type *memo, int *observ)
+{
+	unsigned int h = 2166136261u;
+	int cnt, slot;
+
+	/* FNV-1a over the integers of the encoded observation */
+	for (cnt = 0; cnt < memo->len; cnt++)
+		h = (h ^ (unsigned int) observ[cnt]) * 16777619u;
+
+	for (slot = h & (memo->size - 1); memo->key[slot];
+			slot = (slot + 1) & (memo->size - 1))
+		if (equal_obs(memo->key[slot], observ, memo->len - 1))
+			break;
+
+	return slot;
+}
+
+/***********************************************************************\
+** This function stores a copy of observ in the memo with the value val.
+ ** The observation must not be in the memo already.  The table is
+ ** doubled whenever it becomes half full; once MEMO_MAX observations are
+ ** held, new ones are simply not remembered.
+ \***********************************************************************/
+void obs_memo_add(obs_memo_type *memo, int *observ, double val)
+{
+	int **old_key;
+	double *old_val;
+	int old_size, cnt, slot;
+
+	if (memo->cnt >= MEMO_MAX)
+		return;
+
+	if (2 * (memo->cnt + 1) > memo->size)
+	{
+		old_key = memo->key;
+		old_val = memo->val;
+		old_size = memo->size;
+		memo->size *= 2;
+		if (!(memo->key = (int **) mem_calloc (memo->size, sizeof(int *))))
+			err_msg("Allocation", "obs_memo_add", "memo->key");
+		if (!(memo->val = arr_alloc(memo->size, double)))
+			err_msg("Allocation", "obs_memo_add", "memo->val");
+		for (cnt = 0; cnt < old_size; cnt++)
+			if (old_key[cnt])
+			{
+				slot = obs_memo_slot(memo, old_key[cnt]);
+				memo->key[slot] = old_key[cnt];
+				memo->val[slot] = old_val[cnt];
+			}
+		mem_free(old_key);
+		mem_free(old_val);
+	}
+
+	slot = obs_memo_slot(memo, observ);
+	if (!(memo->key[slot] = arr_alloc(memo->len, int)))
+		err_msg("Allocation", "obs_memo_add", "memo->key[slot]");
+	for (cnt = 0; cnt < memo->len; cnt++)
+		memo->key[slot][cnt] = observ[cnt];
+	memo->val[slot] = val;
+	memo->cnt++;
+}
@@ -13,13 +13,21 @@ BOOL equal_obs(int *a, int *b, int len);
 BOOL valid_omega_idx(omega_type *omega, int idx);
 int generate_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num,
 		BOOL *new_omeg, sd_long *RUN_SEED);
+int generate_observ_u(sdglobal_type* sd_global, omega_type *omega, num_type *num,
+		BOOL *new_omeg, double *u);
+int add_observ(omega_type *omega, num_type *num, int *observ, BOOL *new_omeg);
 int get_observ(sdglobal_type* sd_global, omega_type *omega, num_type *num, BOOL *new_omeg);
 int next_omega_idx(omega_type *omega);
-omega_type *new_omega(int num_iter, int num_rv, coord_type *coord);
+omega_type *new_omega(int num_iter, int num_rv, int num_cipher,
+		coord_type *coord);
 void free_omega(omega_type *omega);
 void get_R_T_omega(sdglobal_type* sd_global, omega_type *omega, int obs_idx);
 void init_R_T_omega(sparse_vect *Romega, sparse_matrix *Tomega,
 		omega_type *omega, num_type *num);
+obs_memo_type *new_obs_memo(int len);
+void free_obs_memo(obs_memo_type *memo);
+int obs_memo_slot(obs_memo_type *memo, int *observ);
+void obs_memo_add(obs_memo_type *memo, int *observ, double val);
 void print_omega(omega_type *omega, num_type *num, int idx);
 
 #endif /* OMEGA_H_ */
@@ -15,6 +15,8 @@
  \***********************************************************************/
 
 #include <time.h>
+#include <pthread.h>
+#include <math.h>
 #include "prob.h"
 #include "cell.h"
 #include "soln.h"
@@ -27,6 +29,7 @@
 #include "log.h"
 #include "master.h"
 #include "cuts.h"
+#include "improve.h"
 #include "rvgen.h"
 #include "sdconstants.h"
 #include "sdglobal.h"
@@ -135,7 +138,7 @@ BOOL pre_test_2(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 {
 	cut_type *T;
 	double ULm;
-	int *cdf, *observ;
+	int *cdf, *observ_cnt;
 	int m, sum;
 	sd_long seed;
 
@@ -161,7 +164,7 @@ BOOL pre_test_2(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	seed = sd_global->config.EVAL_SEED1;
 	sum = 0;
 	T = choose_cuts(p, c, s);
-	observ = arr_alloc(c->k, int);
+	observ_cnt = arr_alloc(s->omega->most, int);
 	cdf = arr_alloc(s->omega->most, int);
 
 	empirical_distrib(s->omega, cdf);
@@ -180,12 +183,13 @@ BOOL pre_test_2(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		 ** we can use c->k.  (Jan 93 - They are, so we can).
 		 ** ??????????????????
 		 */
-		sample_omega(sd_global, cdf, observ, c->k);
+		sample_omega(&(sd_global->config.EVAL_SEED1), cdf, s->omega->most,
+				observ_cnt, c->k);
 #ifdef OPT
 		printf("SS-PRINT: passed sample_omega \n");
 #endif
-		reform_cuts(sd_global, c->sigma, s->delta, s->omega, p->num, T, observ,
-				c->k);
+		reform_cuts(sd_global, c->sigma, s->delta, s->omega, p->num, T,
+				observ_cnt, c->k);
 #ifdef OPT
 		printf("SS-PRINT: passed reform_cuts \n");
 #endif
@@ -236,7 +240,7 @@ BOOL pre_test_2(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 #endif
 
 	mem_free(cdf);
-	mem_free(observ);
+	mem_free(observ_cnt);
 	free_cuts(T);
 
 	/* JH: What value for percent_pass here?  */
@@ -278,13 +282,15 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 {
 	cut_type *T;
 	double Lm;
-	int *cdf, *observ;
+	int *cdf;
 	int m, sum;
-#if 0
-	int i; /* for printing cuts information. zl */
-#endif
-	int j;
-	double ht, Sm;
+	int i, n_rep, n_wave;
+	boot_rep_type *rep; /* one slot per thread */
+	pthread_t *thread;
+	sd_long base_seed;
+	double Sm;
+	double llr, llr_pass, llr_fail, llr_accept, llr_reject;
+	BOOL seq_accept = FALSE;
 #ifdef CAL_CHECK
 	double temp;
 #endif
@@ -321,32 +327,8 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 			c->cuts->cnt);
 #endif
 
-	Sm = c->cuts->val[0]->alpha
-			- CxX(c->cuts->val[0]->beta, s->incumb_x, p->num->mast_cols);
-
-	for (j = 1; j < c->cuts->cnt; j++)
-	{
-		ht = c->cuts->val[j]->alpha
-				- CxX(c->cuts->val[j]->beta, s->incumb_x, p->num->mast_cols);
-		if (Sm < ht)
-			Sm = ht;
-	}
-
-#ifdef CAL_CHECK
-	printf("temp LM is : %f\n",temp);
-	printf("SM regular is around %f\n",Sm);
-	printf("incumbent est is: %f\n",s->incumb_est);
-#endif
-
-	Sm = cut_height(sd_global, c->cuts->val[0], s->incumb_x, c, p->num);
-
-	for (j = 1; j < c->cuts->cnt; j++)
-	{
-		ht = cut_height(sd_global, c->cuts->val[j], s->incumb_x, c, p->num);
-
-		if (Sm < ht)
-			Sm = ht;
-	}
+	update_cut_bx(c, p->num, s->incumb_x);
+	Sm = max_cut_height(sd_global, c->cuts, s->incumb_x, c, p->num);
 
 #ifdef CAL_CHECK
 	printf("temp LM is : %f\n",temp);
@@ -359,88 +341,76 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	start = clock();
 
 	sum = 0;
-	T = choose_cuts(p, c, s);
-	observ = arr_alloc(c->k, int);
 	cdf = arr_alloc(s->omega->most, int);
 
 	empirical_distrib(s->omega, cdf);
+
 	/*
-	 printf(" In full_test seed = %d\n", sd_global->config.EVAL_SEED1);
+	 ** The resamplings are independent, so they are carried out in waves of
+	 ** up to NUM_THREADS at a time, each thread with its own copy of the
+	 ** chosen cuts.  Replication m draws from its own random stream, seeded
+	 ** from EVAL_SEED1 and m only, so the outcome does not depend on the
+	 ** number of threads.  The lower bounds, which go through the solver,
+	 ** and the tally are done in order on this thread, with the same early
+	 ** exit as before.
 	 */
-	/* Find out how many of the resamplings satisfy optimality requirement */
-
-	for (m = 0; m < sd_global->config.M; m++)
+	n_rep = sd_global->config.NUM_THREADS;
+	if (n_rep < 1)
+		n_rep = 1;
+	if (n_rep > sd_global->config.M)
+		n_rep = sd_global->config.M;
+	if (!(rep = arr_alloc(n_rep, boot_rep_type)))
+		err_msg("Allocation", "full_test", "rep");
+	if (!(thread = arr_alloc(n_rep, pthread_t)))
+		err_msg("Allocation", "full_test", "thread");
+	for (i = 0; i < n_rep; i++)
 	{
+		rep[i].sd_global = sd_global;
+		rep[i].p = p;
+		rep[i].c = c;
+		rep[i].s = s;
+		rep[i].cdf = cdf;
+		rep[i].T = choose_cuts(p, c, s);
+		if (!(rep[i].observ_cnt = arr_alloc(s->omega->most, int)))
+			err_msg("Allocation", "full_test", "rep[i].observ_cnt");
+	}
 
-		/* 
-		 ** ??????????????????
-		 ** What do we use here? Should we resample k omegas, or omega->cnt omegas?
-		 ** As long as omega->weight is incremented when an omega is dropped,
-		 ** we can use c->k.  (Jan 93 - They are, so we can).
-		 ** ??????????????????
-		 */
-
-		sample_omega(sd_global, cdf, observ, c->k);
-#ifdef OPT
-		printf("SS-PRINT: passed sample_omega \n");
-#endif
-		reform_cuts(sd_global, c->sigma, s->delta, s->omega, p->num, T, observ,
-				c->k);
-#ifdef OPT
-		printf("SS-PRINT: passed reform_cuts \n");
-#endif
-
-#if 0
-		/* Print out the reformed cuts for checking purpose only.  zl */
-		fprintf(g_FilePointer, "\n*** after reform_cuts ***\n");
-		fprintf(g_FilePointer, "m = %d, num_cuts (T) = %d\n", m, T->cnt);
-		for (i=0; i<T->cnt; i++)
-		{
-			fprintf(g_FilePointer, "++ T ++:  i = %d, alpha = %f, row_num = %d, theta = %f\n", i,
-					T->val[i]->alpha,
-					T->val[i]->row_num,
-					s->Master_pi[T->val[i]->row_num]);
-			for (j=0; j<=p->num->mast_cols; j++)
-			fprintf(g_FilePointer, "beta[%d] = %f, ", j,
-					T->val[i]->beta[j]);
-			fprintf(g_FilePointer, "\n");
-		}
-#endif
-		/* Find the highest reformed cut at the incumbent solution */
-
-		Sm = T->val[0]->alpha
-				- CxX(T->val[0]->beta, s->incumb_x, p->num->mast_cols);
+	base_seed = sd_global->config.EVAL_SEED1;
+	randUniform(&(sd_global->config.EVAL_SEED1));
 
-		/* Yifan 04/01/2012 No t/k for the cut height of previous cuts */
-		/* modified by Yifan 2013.05.06 */
-		/*Sm = Sm * (double)T->val[0]->cut_obs / (double)c->k;*/
+	/*
+	 ** With SEQ_TEST, the pass proportion is tested sequentially (Wald's
+	 ** SPRT) between PERCENT_PASS - SEQ_DELTA and PERCENT_PASS + SEQ_DELTA:
+	 ** each replication moves the log likelihood ratio llr by llr_pass or
+	 ** llr_fail, and the test stops once llr leaves [llr_reject, llr_accept].
+	 */
+	seq_probs(sd_global, &llr_pass, &llr_fail, &llr_accept, &llr_reject);
+	llr = 0.0;
 
-		/* Yifan 03/17/2012 Updated for optimality cut height*/
-		/*
-		 if (sd_global->config.LB_TYPE == 1) {
-		 Sm += (1- (double)T->val[0]->cut_obs / (double)c->k) * sd_global->Eta0;
-		 }*/
+	/* Find out how many of the resamplings satisfy optimality requirement */
 
-		for (j = 1; j < T->cnt; j++)
+	for (m = 0; m < sd_global->config.M; m++)
+	{
+		i = m % n_rep;
+		if (i == 0)
 		{
-			ht = T->val[j]->alpha
-					- CxX(T->val[j]->beta, s->incumb_x, p->num->mast_cols);
-
-			/* modified by Yifan 2013.05.06 */
-			/* ht = ht * (double)T->val[j]->cut_obs / (double)c->k;*/
-
-			/*
-			 if (sd_global->config.LB_TYPE == 1) {
-			 ht += (1- (double)T->val[j]->cut_obs / (double)c->k) * sd_global->Eta0;
-			 }*/
-
-			if (Sm < ht)
-				Sm = ht;
+			/* Reform the cuts for the next wave of replications */
+			n_wave = sd_global->config.M - m;
+			if (n_wave > n_rep)
+				n_wave = n_rep;
+			for (i = 0; i < n_wave; i++)
+				rep[i].seed = boot_seed(base_seed, m + i);
+
+			for (i = 1; i < n_wave; i++)
+				if (pthread_create(&thread[i], NULL, boot_replicate, &rep[i]))
+					err_msg("Thread", "full_test", "pthread_create");
+			boot_replicate(&rep[0]);
+			for (i = 1; i < n_wave; i++)
+				pthread_join(thread[i], NULL);
+			i = 0;
 		}
-
-		/* In QP approach, we don't include the incumb_x * c in Sm. zl */
-		if (sd_global->config.MASTER_TYPE == SDLP)
-			Sm += CxX(p->c, s->incumb_x, p->num->mast_cols);
+		T = rep[i].T;
+		Sm = rep[i].Sm;
 
 		if (sd_global->config.MASTER_TYPE == SDLP)
 			Lm = solve_temp_master(sd_global, p, T, c);
@@ -483,10 +453,25 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
         if (sd_global->config.BOOTSTRAP_TEST == 0) {
             sum = sd_global->config.M;
         }
-        
+
+		llr = llr_pass * sum + llr_fail * (m + 1 - sum);
+		if (sd_global->config.SEQ_TEST && sd_global->config.BOOTSTRAP_TEST
+				&& llr >= llr_accept)
+		{
+			seq_accept = TRUE;
+			m++;
+			break;
+		}
+
 		if (m + 1 - sum
-				>= (1 - sd_global->config.PERCENT_PASS) * sd_global->config.M)
+				>= (1 - sd_global->config.PERCENT_PASS) * sd_global->config.M
+				|| (sd_global->config.SEQ_TEST && llr <= llr_reject))
 		{
+			s->passed = sum;
+			s->tested = m + 1;
+			s->full_test_cnt++;
+			s->full_test_reps += m + 1;
+
 			/* Record average error of failed replications in full test.
 			 Only at Max_iter. zl, 08/17/04. */
 			if (c->k >= p->num->iter)
@@ -506,9 +491,9 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 #endif
 
 			/* Yifan 03/19/2012 Avoid memory leaks*/
-			mem_free(observ);
+			free_boot_reps(rep, n_rep);
+			mem_free(thread);
 			mem_free(cdf);
-			free_cuts(T);
 			return FALSE;
 		}
 
@@ -525,6 +510,9 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	/* Record the number of bootstraped replications that satisfy the optimality 
 	 requirement. zl, 06/30/04. */
 	s->passed = sum;
+	s->tested = m;
+	s->full_test_cnt++;
+	s->full_test_reps += m;
 
 	/* Write down all the relevant information on the modification on the
 	 stopping rule. zl */
@@ -549,11 +537,120 @@ BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 #endif
 
 	/* Yifan 03/19/2012 Avoid memory leaks*/
-	mem_free(observ);
+	free_boot_reps(rep, n_rep);
+	mem_free(thread);
 	mem_free(cdf);
-	free_cuts(T);
 
-	return (sum >= sd_global->config.PERCENT_PASS * sd_global->config.M);
+	return (seq_accept
+			|| sum >= sd_global->config.PERCENT_PASS * sd_global->config.M);
+}
+
+/***********************************************************************\
+** This function sets up the sequential probability ratio test of
+ ** full_test() on the pass proportion p of the bootstrap replications,
+ ** with H0: p = PERCENT_PASS - SEQ_DELTA against H1: p = PERCENT_PASS +
+ ** SEQ_DELTA (both kept inside (0,1)) and error probabilities SEQ_ERROR.
+ ** It returns the change in the log likelihood ratio for a passed and a
+ ** failed replication, and the ratios at which H1 and H0 are accepted.
+ \***********************************************************************/
+void seq_probs(sdglobal_type* sd_global, double *llr_pass, double *llr_fail,
+		double *llr_accept, double *llr_reject)
+{
+	double p0, p1, err;
+
+	p0 = sd_global->config.PERCENT_PASS - sd_global->config.SEQ_DELTA;
+	p1 = sd_global->config.PERCENT_PASS + sd_global->config.SEQ_DELTA;
+	if (p0 < 0.001)
+		p0 = 0.001;
+	if (p1 > 0.999)
+		p1 = 0.999;
+	if (p1 <= p0)
+		p1 = p0 + 0.001;
+	err = sd_global->config.SEQ_ERROR;
+
+	*llr_pass = log(p1 / p0);
+	*llr_fail = log((1.0 - p1) / (1.0 - p0));
+	*llr_accept = log((1.0 - err) / err);
+	*llr_reject = log(err / (1.0 - err));
+}
+
+/***********************************************************************\
+** This function carries out the part of one bootstrap replication of
+ ** full_test() that needs no solver: it resamples the observations,
+ ** reforms the chosen cuts with respect to them, and finds the highest
+ ** reformed cut at the incumbent.  It only writes to its own slot, so
+ ** several replications may run at once on different threads.
+ \***********************************************************************/
+void *boot_replicate(void *arg)
+{
+	boot_rep_type *rep = (boot_rep_type *) arg;
+	prob_type *p = rep->p;
+	cut_type *T = rep->T;
+	double ht;
+	int j;
+
+	sample_omega(&rep->seed, rep->cdf, rep->s->omega->most, rep->observ_cnt,
+			rep->c->k);
+#ifdef OPT
+	printf("SS-PRINT: passed sample_omega \n");
+#endif
+	reform_cuts(rep->sd_global, rep->c->sigma, rep->s->delta, rep->s->omega,
+			p->num, T, rep->observ_cnt, rep->c->k);
+#ifdef OPT
+	printf("SS-PRINT: passed reform_cuts \n");
+#endif
+
+	/* Find the highest reformed cut at the incumbent solution */
+
+	/* Yifan 04/01/2012 No t/k for the cut height of previous cuts */
+	/* modified by Yifan 2013.05.06 */
+	rep->Sm = T->val[0]->alpha
+			- CxX(T->val[0]->beta, rep->s->incumb_x, p->num->mast_cols);
+	for (j = 1; j < T->cnt; j++)
+	{
+		ht = T->val[j]->alpha
+				- CxX(T->val[j]->beta, rep->s->incumb_x, p->num->mast_cols);
+		if (rep->Sm < ht)
+			rep->Sm = ht;
+	}
+
+	/* In QP approach, we don't include the incumb_x * c in Sm. zl */
+	if (rep->sd_global->config.MASTER_TYPE == SDLP)
+		rep->Sm += CxX(p->c, rep->s->incumb_x, p->num->mast_cols);
+
+	return NULL;
+}
+
+/***********************************************************************\
+** This function returns the seed of the random stream used by bootstrap
+ ** replication _m_, scrambled from _base_ so that the streams of
+ ** neighbouring replications are not shifted copies of one another.
+ \***********************************************************************/
+sd_long boot_seed(sd_long base, int m)
+{
+	unsigned long long z;
+
+	z = (unsigned long long) base + (unsigned long long) (m + 1)
+			* 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	z &= 0x7FFFFFFFULL;
+
+	return z ? (sd_long) z : 1;
+}
+
+/* This function frees the per-thread slots of full_test() */
+void free_boot_reps(boot_rep_type *rep, int n_rep)
+{
+	int i;
+
+	for (i = 0; i < n_rep; i++)
+	{
+		free_cuts(rep[i].T);
+		mem_free(rep[i].observ_cnt);
+	}
+	mem_free(rep);
 }
 
 /***********************************************************************\  
@@ -569,7 +666,7 @@ cut_type *choose_cuts(prob_type *p, cell_type *c, soln_type *s)
 	cut_type *T;
 	int cnt;
 
-	T = new_cuts(p->num->max_cuts, p->num->mast_cols, 0);
+	T = new_cuts(c->cuts->slab, p->num->max_cuts, 0);
 
 	/* Define what it means to be "close" to the incumbent */
 //	sd_global->config.CONFID_HI * s->incumb_stdev;
@@ -602,10 +699,9 @@ cut_type *choose_cuts(prob_type *p, cell_type *c, soln_type *s)
 		/* Yifan 04/03/2012 Choosing cuts with nonzero dual multipliers */
 		if (s->Master_pi[c->cuts->val[cnt]->row_num + 1] > 0.00001)
 		{
-			T->val[T->cnt] = new_cut(p->num->mast_cols,
-					c->cuts->val[cnt]->omega_cnt, c->cuts->val[cnt]->cut_obs);
-			copy_arr(T->val[T->cnt]->istar, c->cuts->val[cnt]->istar,
-					T->val[T->cnt]->omega_cnt - 1)
+			T->val[T->cnt] = new_cut(T->slab, c->cuts->val[cnt]->omega_cnt,
+					c->cuts->val[cnt]->cut_obs, c->cuts->val[cnt]->istar_width);
+			copy_istar(T->slab, T->val[T->cnt], c->cuts->val[cnt]);
 			T->val[T->cnt]->row_num = c->cuts->val[cnt]->row_num; /* JH 5/98 */
 
 #ifdef OPT
@@ -645,14 +741,16 @@ void empirical_distrib(omega_type *omega, int *cdf)
  ** This function randomly selects a new set of observations from the 
  ** old set of observations stored in omega.  Entries in omega which 
  ** have been observed multiple times have a proportionally higher 
- ** chance of being selected for the new set.  The function fills an
- ** array, assumed to be of a size equal to the number of iterations 
- ** which have passed, with the new set of observations.
+ ** chance of being selected for the new set.  Since only the number of
+ ** times each observation is drawn matters to reform_cuts(), the new
+ ** set is returned as the multinomial count vector _observ_cnt_, of
+ ** length _most_, whose entries add up to k (the number of iterations).
  \***********************************************************************/
-void sample_omega(sdglobal_type* sd_global, int *cdf, int *observ, int k)
+void sample_omega(sd_long *seed, int *cdf, int most, int *observ_cnt, int k)
 {
 	int cnt, obs;
 	int sample;
+	int lo, hi;
 
 #ifdef LOOP
 	printf("Inside sample_omega\n");
@@ -670,19 +768,31 @@ void sample_omega(sdglobal_type* sd_global, int *cdf, int *observ, int k)
 	 ** ???????????????????
 	 */
 
+	for (cnt = 0; cnt < most; cnt++)
+		observ_cnt[cnt] = 0;
+
 	/* Choose k observations according to cdf (k = number of iterations) */
 	for (obs = 0; obs < k; obs++)
 	{
-		sample = randfun(k, &(sd_global->config.EVAL_SEED1));
+		sample = randfun(k, seed);
 		/*
 		 fprintf(g_FilePointer, "obs = %d, sample = %d\n", obs, sample);    
 		 */
-		for (cnt = 0; sample > cdf[cnt]; cnt++)
-			/* Loop until sample falls below cdf */;
-		observ[obs] = cnt;
+		/* Find the first cnt where sample falls below cdf */
+		lo = 0;
+		hi = most - 1;
+		while (lo < hi)
+		{
+			cnt = (lo + hi) / 2;
+			if (sample > cdf[cnt])
+				lo = cnt + 1;
+			else
+				hi = cnt;
+		}
+		observ_cnt[lo]++;
 
 #ifdef OPT
-		printf("%d ", cnt);
+		printf("%d ", lo);
 #endif
 	}
 
@@ -816,15 +926,18 @@ double solve_temp_master(sdglobal_type* sd_global, prob_type *p, cut_type *T,
 
 /***********************************************************************\  
  ** This function will calculate a new set of cuts based on the 
- ** observations of omega passed in as _observ_, and the istar's 
+ ** observations of omega resampled as _observ_cnt_ (the number of times
+ ** each observation was drawn, see sample_omega()), and the istar's 
  ** which have already been stored in the _istar_ field of each cut.  
  ** If an istar field does not exist for a given observation, then 
  ** a value of zero is averaged into the calculation of alpha & beta.
+ ** Each distinct observation is visited once, weighted by its count.
  \***********************************************************************/
 void reform_cuts(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
-		omega_type *omega, num_type *num, cut_type *T, int *observ, int k)
+		omega_type *omega, num_type *num, cut_type *T, int *observ_cnt, int k)
 {
 	int cnt, obs, idx, count; /* modified by Yifan 2013.05.06 */
+	double weight;
 	i_type istar;
 
 #ifdef TRACE
@@ -851,28 +964,31 @@ void reform_cuts(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
 
 		count = 0; /* modified by Yifan 2013.05.06 */
 		/* Reform this cut based on resampled observations */
-		for (obs = 0; obs < k; obs++)
+		for (obs = 0; obs < omega->most; obs++)
 		{
+			if (observ_cnt[obs] == 0)
+				continue;
 			/* Only compute if this observation actually exists in omega */
-			if (valid_omega_idx(omega, observ[obs]))
+			if (valid_omega_idx(omega, obs))
 			{
 				/* Only sum values if the cut has an istar for this observation */
-				if (observ[obs] < T->val[cnt]->omega_cnt&&
-				T->val[cnt]->istar[observ[obs]] != DROPPED){
-				istar.sigma = T->val[cnt]->istar[observ[obs]];
+				if (obs < T->val[cnt]->omega_cnt &&
+				get_istar(T->val[cnt], obs) != DROPPED){
+				istar.sigma = get_istar(T->val[cnt], obs);
 				istar.delta = sigma->lamb[istar.sigma];
+				weight = (double) observ_cnt[obs];
 
-				T->val[cnt]->alpha += sigma->val[istar.sigma].R +
-				delta->val[istar.delta][observ[obs]].R;
+				T->val[cnt]->alpha += weight * (sigma->val[istar.sigma].R +
+				delta->val[istar.delta][obs].R);
 
 				for (idx = 1; idx <= num->nz_cols; idx++)
 				T->val[cnt]->beta[sigma->col[idx]] +=
-				sigma->val[istar.sigma].T[idx];
+				weight * sigma->val[istar.sigma].T[idx];
 
 				for (idx = 1; idx <= num->rv_cols; idx++)
 				T->val[cnt]->beta[delta->col[idx]] +=
-				delta->val[istar.delta][observ[obs]].T[idx];
-				count++; /* modified by Yifan 2013.05.06 */
+				weight * delta->val[istar.delta][obs].T[idx];
+				count += observ_cnt[obs]; /* modified by Yifan 2013.05.06 */
 			}
 		}
 	}
@@ -9,6 +9,20 @@
 #define OPTIMAL_H_
 #include "sdglobal.h"
 
+/* One slot of the bootstrap replications of full_test(), owned by one thread */
+typedef struct
+{
+	sdglobal_type *sd_global;
+	prob_type *p;
+	cell_type *c;
+	soln_type *s;
+	int *cdf; /* empirical distribution shared by all slots (read only) */
+	cut_type *T; /* this slot's copy of the chosen cuts, reformed */
+	int *observ_cnt; /* times each observation was resampled */
+	sd_long seed; /* random stream of the current replication */
+	double Sm; /* highest reformed cut at the incumbent */
+} boot_rep_type;
+
 BOOL full_test(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s);
 BOOL optimal(sdglobal_type* sd_global, prob_type *p, cell_type *c, soln_type *s,
@@ -24,7 +38,12 @@ double solve_temp_master(sdglobal_type* sd_global, prob_type *p, cut_type *T,
 int randfun(int greatest, sd_long *seed);
 void empirical_distrib(omega_type *omega, int *cdf);
 void reform_cuts(sdglobal_type* sd_global, sigma_type *sigma, delta_type *delta,
-		omega_type *omega, num_type *num, cut_type *T, int *observ, int k);
-void sample_omega(sdglobal_type* sd_global, int *cdf, int *observ, int k);
+		omega_type *omega, num_type *num, cut_type *T, int *observ_cnt, int k);
+void sample_omega(sd_long *seed, int *cdf, int most, int *observ_cnt, int k);
+void *boot_replicate(void *arg);
+sd_long boot_seed(sd_long base, int m);
+void seq_probs(sdglobal_type* sd_global, double *llr_pass, double *llr_fail,
+		double *llr_accept, double *llr_reject);
+void free_boot_reps(boot_rep_type *rep, int n_rep);
 
 #endif /* OPTIMAL_H_ */
@@ -26,6 +26,7 @@
 #include "testout.h"
 #include "log.h"
 #include "solver.h"
+#include "subprob.h"
 #include "sdglobal.h"
 #include <string.h>
 
@@ -70,6 +71,26 @@ void solve_SD(sdglobal_type* sd_global, one_problem *original, vector x_k,
 	free_prob(sd_global, prob);
 }
 
+/************************************************************************\
+** This function solves the compromise problem of the replications
+ ** recorded for _prob_, the problem init_batch_data() was given, once
+ ** the replications have stopped.
+ \***********************************************************************/
+void solve_compromise(sdglobal_type* sd_global, prob_type *prob, vector x_k,
+		char *fname)
+{
+	cell_type *cell;
+
+#ifdef TRACE
+	printf("Inside solve_compromise\n");
+#endif
+
+	prob->current_batch_id = sd_global->reps.num - 1;
+	cell = new_cell(sd_global, prob, 0);
+	solve_batch(sd_global, cell, prob, x_k, fname);
+	free_cell(cell, prob->num);
+}
+
 /***********************************************************************\
 ** This function allocates memory for the fields of the problem
  ** data structure, separates the original problem into two stages,
@@ -174,6 +195,9 @@ prob_type *new_prob(sdglobal_type* sd_global, one_problem *original, int num_rv,
 	p->coord->lambda_row = find_rows(num_rv, &p->num->rv_rows,
 			p->coord->omega_row, p->coord->omega_col, col+1);
 
+	/* Rows of the subproblem rhs which depend on X or omega */
+	p->sub_rhs = new_sub_rhs(p);
+
 	return p;
 }
 
@@ -200,6 +224,7 @@ void free_prob(sdglobal_type* sd_global, prob_type *p)
 	mem_free(p->coord->lambda_row);
 	mem_free(p->coord->sigma_col);
 	mem_free(p->coord);
+	free_sub_rhs(p->sub_rhs);
 
 	/* Free the sparse vecotrs and matrices */
 	mem_free(p->Tbar->row);
@@ -1086,14 +1111,14 @@ void calc_alpha_beta(sdglobal_type* sd_global, one_problem *p, int row, int col)
 	mem_free(prob);
 }
 
-void generate_seed(sd_long * seed1, sd_long * seed2)
+void generate_seed(sd_long * seed1, sd_long * seed2, int n)
 {
 	int idx, cnt;
     sd_long rseed1, rseed2;
 
 	printf("time:%ld\n", time(NULL) % 3600);
     srand((unsigned int) time(NULL));
-	for (cnt = 0; cnt < BATCH_SIZE; cnt++)
+	for (cnt = 0; cnt < n; cnt++)
 	{
 		for (idx = 0; idx < 4; idx++)
 		{
@@ -94,6 +94,9 @@ typedef struct
     int rv_g;
     int rv_W;
 	int batch_id;
+	int batch_row; /* first row of replication batch_id in the batch problem */
+	int batch_cuts; /* and the number of its cut rows */
+	int batch_col; /* and its first column */
 } num_type;
 
 /**********************************************************************\
@@ -125,6 +128,25 @@ typedef struct
 	double *val;
 } sparse_matrix;
 
+/**********************************************************************\
+** The sub_rhs structure caches the part of the subproblem right hand
+ ** side which may change from one solve to the next.  Only the rows
+ ** holding an element of Tbar, or a random element of R or T, can ever
+ ** differ from Rbar; every other row keeps the value it was loaded with.
+ ** _cnt_ gives the number of such rows and _row_ their (0-based) solver
+ ** indices, in increasing order.  _pos_ maps a (1-based) subproblem row
+ ** to its position in _row_, or -1 if the row is fixed.  _fixed_ holds
+ ** Rbar on those rows, and _val_ is the work vector passed to the solver.
+ \**********************************************************************/
+typedef struct
+{
+	int cnt;
+	int *row;
+	int *pos;
+	double *fixed;
+	double *val;
+} sub_rhs_type;
+
 /**********************************************************************\
 ** A string is, obviously, an array of characters, hopefully null-terminated.
  \**********************************************************************/
@@ -148,6 +170,7 @@ typedef struct
 	one_problem *subprob;
 	sparse_vect *Rbar;
 	sparse_matrix *Tbar;
+	sub_rhs_type *sub_rhs; /* rows of the subproblem rhs which may vary */
 	sparse_matrix *A; /* to store the A matrix in regularized QP method. zl */
 	coord_type *coord;
 	num_type *num;
@@ -163,10 +186,12 @@ void free_prob(sdglobal_type* sd_global, prob_type *p);
 void init_param(sdglobal_type* sd_global, prob_type *p);
 void solve_SD(sdglobal_type* sd_global, one_problem *original, vector x_k,
 		int num_rv, int num_cipher, int row, int col, char *fname, int batch_id);
+void solve_compromise(sdglobal_type* sd_global, prob_type *prob, vector x_k,
+		char *fname);
 int decompose(sdglobal_type* sd_global, one_problem *orig, prob_type *p,
 		int row, int col);
 void free_one_prob(one_problem *p);
-void generate_seed(sd_long * seed1, sd_long * seed2);
+void generate_seed(sd_long * seed1, sd_long * seed2, int n);
 void err_msg(char *type, char *place, char *item);
 void parse_cmd_line(sdglobal_type* sd_global, int argc, char *argv[],
 		char *fname, int *objsen, int *num_probs, int *start, BOOL *read_seeds,
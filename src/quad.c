@@ -7,6 +7,7 @@
 #include "cell.h"
 #include "soln.h"
 #include "quad.h"
+#include "cuts.h"
 #include "solver.h"
 #include "utility.h"
 #include "log.h"
@@ -87,32 +88,31 @@ void construct_batch_QP(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	printf("Inside construct_QP.\n");
 #endif
 	/* Yifan 03/21/2012 modified for lower bound*/
-	if (!(qsepvec = arr_alloc(BATCH_SIZE * (p->num->mast_cols+1), double)))
+	if (!(qsepvec = arr_alloc(sd_global->reps.num * (p->num->mast_cols+1), double)))
 		err_msg("Allocation", "construct_QP", "qsepvec");
 
 	/* added by Yifan to test the impact of different weights of quadratic multiplier */
-	for (idx = 0; idx < BATCH_SIZE; idx++)
+	for (idx = 0; idx < sd_global->reps.num; idx++)
 	{
 		avg_sigma += sd_global->quad_v[idx];
 	}
-	avg_sigma /= BATCH_SIZE;
+	avg_sigma /= sd_global->reps.num;
 
-	/* Construct Q matrix, which is simply a diagonal matrix. */
-	for (idx = 0; idx < BATCH_SIZE * p->num->mast_cols; idx++)
+	/* Construct Q matrix, which is simply a diagonal matrix.  Each
+	 replication's block of columns ends with its eta column, which gets
+	 no quadratic term. */
+	for (idx = 0; idx < sd_global->reps.num * (p->num->mast_cols + 1); idx++)
 	{
 //		/*qsepvec[idx] = sigma;*/
 //		j = idx / BATCH_SIZE;
 		/* added by Yifan to test the impact of different weights of qudratic multiplier  */
-		qsepvec[idx] = 0.5 * avg_sigma / BATCH_SIZE;
+		if (idx % (p->num->mast_cols + 1) == p->num->mast_cols)
+			qsepvec[idx] = 0.0;
+		else
+			qsepvec[idx] = 0.5 * avg_sigma / sd_global->reps.num;
 		/* qsepvec[idx] = 0.5 * sd_global->quad_v[j]/ BATCH_SIZE; */
 	}
 
-	/* This is for eta column */
-	for (idx = 0; idx < BATCH_SIZE; idx++)
-	{
-		qsepvec[BATCH_SIZE * p->num->mast_cols + idx] = 0.0;
-	}
-
 	/* Now copy the Q matrix for QP problem. */
 	/* 2011.10.30 - call copy_qp_separable() */
 	status = copy_qp_separable(sd_global->batch_problem, qsepvec); //modified by Yifan 09/14/2011
@@ -151,7 +151,7 @@ void construct_batch_QP(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 void change_rhs(prob_type *p, cell_type *c, soln_type *s) {
 	int status = 0;
 	int cnt;
-	int idx;
+	double *bx;
 	double *rhs1;
 	double *rhs;
 	int *indices;
@@ -183,24 +183,22 @@ void change_rhs(prob_type *p, cell_type *c, soln_type *s) {
 	}
 
 	/*** new rhs = alpha - beta * xbar ***/
+	bx = update_cut_bx(c, p->num, s->incumb_x);
 	for (cnt = 0; cnt < c->cuts->cnt; cnt++) {
-		rhs[p->num->mast_rows + cnt] = c->cuts->val[cnt]->alpha;
-		for (idx = 1; idx <= p->num->mast_cols; idx++) {
-			rhs[p->num->mast_rows + cnt] -= c->cuts->val[cnt]->beta[idx] * s->incumb_x[idx];
-		}
+		rhs[p->num->mast_rows + cnt] = c->cuts->val[cnt]->alpha
+				- bx[c->cuts->val[cnt]->row_num - p->num->mast_rows];
 		indices[p->num->mast_rows + cnt] = c->cuts->val[cnt]->row_num;
 		/* Yifan 04/04/2012 record "alpha - beta x incumb_x" for later use in updating "alpha + (1 - t/k) x eta0" */
 		c->cuts->val[cnt]->alpha_incumb = rhs[p->num->mast_rows + cnt];
+		rhs[p->num->mast_rows + cnt] -= c->eta_shift;
 	}
 
 	/**Do the same thing for feasibility cut **/
 	/*** new rhs = alpha - beta * xbar ***/
 	for (cnt = 0; cnt < c->feasible_cuts_added->cnt; cnt++) {
 		rhs[p->num->mast_rows + c->cuts->cnt + cnt] =
-				c->feasible_cuts_added->val[cnt]->alpha;
-		for (idx = 1; idx <= p->num->mast_cols; idx++) {
-			rhs[p->num->mast_rows + c->cuts->cnt + cnt] -= c->feasible_cuts_added->val[cnt]->beta[idx] * s->incumb_x[idx];
-		}
+				c->feasible_cuts_added->val[cnt]->alpha
+				- bx[c->feasible_cuts_added->val[cnt]->row_num - p->num->mast_rows];
 		indices[p->num->mast_rows + c->cuts->cnt + cnt] =
 				c->feasible_cuts_added->val[cnt]->row_num;
 	}
@@ -602,6 +600,7 @@ void change_rhs_back(prob_type *p, cell_type *c, soln_type *s)
 		/* Yifan 04/04/2012 record "alpha - beta x incumb_x" for later use */
 		/* in updating "alpha + (1 - t/k) x eta0" */
 		c->cuts->val[cnt]->alpha_incumb = rhs[p->num->mast_rows + cnt];
+		rhs[p->num->mast_rows + cnt] -= c->eta_shift;
 #ifdef CAL_CHECK
 		fprintf (g_FilePointer, "\nindices[%d] = %d, rhs[%d] = %f.",
 				p->num->mast_rows+cnt, indices[p->num->mast_rows+cnt],
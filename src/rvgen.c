@@ -186,7 +186,8 @@ float scalit(float lower, float upper, sd_long *RUN_SEED)
 float randUniform(sd_long *SEED)
 {
 	/* static int to static long int: modified by Yifan 2013.02.18 */
-	static int lo_bits, hi_bits;
+	/* Not static, so that separate streams may be drawn on separate threads */
+	int lo_bits, hi_bits;
 
 	lo_bits = ((*SEED) & 0xFFFFL) * 16807;
 	hi_bits = (int) (((*SEED) >> 16) * 16807) + (lo_bits >> 16);
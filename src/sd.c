@@ -34,6 +34,8 @@
 #include "cuts.h"
 #include "sdglobal.h"
 #include "supomega.h"
+#include "batch.h"
+#include "optimal.h"
 #ifdef SD_win
 #include <windows.h>
 #endif
@@ -67,9 +69,11 @@ int main(int argc, char *argv[])
 # endif
 	BOOL read_seeds; /* True if random # seeds should be read */
 	BOOL read_iters; /* True if MIN_ITER and MAX_ITER should be read. zl 06/18/02 */
+	BOOL overridden = FALSE; /* True if OVERRIDE stopped the replications */
+	prob_type *bprob; /* problem the batch problem is built for */
 	double objective;
 	int cnt = 0;
-    sd_long seed1[BATCH_SIZE], seed2[BATCH_SIZE];
+    sd_long *seed1, *seed2;
 //	double eps[3];
 //	int scan_len[3];
 	int idx = 0;
@@ -107,6 +111,13 @@ int main(int argc, char *argv[])
 #ifdef SD_unix
     sd_create_output_folder(buffer1,buffer2,fname);
 #endif
+	init_rep_pool(sd_global, buffer1);
+
+	/* The 30 RUN_SEEDs of the config file are always read in */
+	if (!(seed1 = arr_alloc(max(sd_global->reps.max, BATCH_SIZE), sd_long)))
+		err_msg("Allocation", "main", "seed1");
+	if (!(seed2 = arr_alloc(max(sd_global->reps.max, BATCH_SIZE), sd_long)))
+		err_msg("Allocation", "main", "seed2");
 
   
   //		eps[0] = 0.01;
@@ -152,10 +163,13 @@ int main(int argc, char *argv[])
 			seed1[27] = sd_global->config.RUN_SEED28;
 			seed1[28] = sd_global->config.RUN_SEED29;
 			seed1[29] = sd_global->config.RUN_SEED30;
+			/* Replications past the 30th derive theirs from the first */
+			for (cnt = BATCH_SIZE; cnt < sd_global->reps.max; cnt++)
+				seed1[cnt] = boot_seed(sd_global->config.RUN_SEED1, cnt);
 		}
 		else
 		{
-			generate_seed(seed1, seed2);
+			generate_seed(seed1, seed2, sd_global->reps.max);
 		}
 
 #if 0
@@ -337,7 +351,7 @@ int main(int argc, char *argv[])
 		}
 		else
 		{
-			generate_seed(seed1, seed2);
+			generate_seed(seed1, seed2, 1);
 		}
 	}
 
@@ -435,11 +449,17 @@ int main(int argc, char *argv[])
 					printf("\nnum_rv = %d;\n", num_rv);
 					printf("num_cipher = %d;\n\n", num_cipher);
 
+					/* The replications record what the batch problem needs in here */
+					bprob = new_prob(sd_global, probptr, num_rv, num_cipher, row,
+							col);
+					init_param(sd_global, bprob);
+					init_batch_data(sd_global, bprob, original_x_k);
+
 					if (sd_global->config.MULTIPLE_REP == 1)
 					{
 						for (idx = 1; idx < 2; idx++)
 						{/* this layer control the tolerance of SD runs */
-							for (cnt = 0; cnt < BATCH_SIZE; cnt++)
+							for (cnt = 0; cnt < sd_global->reps.max; cnt++)
 							{ /* this layer control the seed used in each SD replication */
 								/*sd_global->config.EPSILON = eps[idx];
 								 sd_global->config.SCAN_LEN = scan_len[idx];*/
@@ -448,21 +468,52 @@ int main(int argc, char *argv[])
 
 								/* Take the mean value solution as the initial candidate solution 04/25/2013 Yifan */
 								copy_arr(x_k, original_x_k, probptr->mac);
+								sd_global->reps.started = cnt + 1;
+#ifdef SD_unix
+								if (!rep_in_process(sd_global, cnt))
+								{
+									launch_rep(sd_global, probptr, x_k, num_rv,
+											num_cipher, row, col, fname, cnt);
+									/* Take in what the workers have finished */
+									collect_rep_batches(sd_global, bprob,
+											sd_global->reps.started, FALSE);
+									if (sd_global->reps.stop)
+										break;
+									continue;
+								}
+								wait_rep_workers(sd_global,
+										sd_global->reps.workers - 1);
+#endif
 								solve_SD(sd_global, probptr, x_k, num_rv,
 										num_cipher, row, col, fname, cnt);
                               if (cnt == 2 && (sd_global->average_flag == 1 || sd_global->obj_flag == 1 ) && sd_global->config.OVERRIDE == 1) {
+                                overridden = TRUE;
                                 break;
                               }
-
+								if (sd_global->reps.stop
+										|| reps_converged(sd_global, sd_global->reps.next))
+									break;
 							}
 						}
+#ifdef SD_unix
+						collect_rep_batches(sd_global, bprob,
+								sd_global->reps.started, TRUE);
+						stop_rep_workers(sd_global);
+#endif
 					}
 					else
 					{
                         sd_global->config.RUN_SEED = seed1[0];
+						sd_global->reps.started = 1;
 						solve_SD(sd_global, probptr, x_k, num_rv, num_cipher,
 								row, col, fname, cnt);
 					}
+					sd_global->reps.num = sd_global->reps.next;
+
+					/* Solve the compromise problem over the replications taken */
+					if (sd_global->config.MULTIPLE_REP == 1 && !overridden)
+						solve_compromise(sd_global, bprob, original_x_k, fname);
+					free_prob(sd_global, bprob);
 
 #if 0
 					printf("~3\n");
@@ -546,6 +597,7 @@ else
 	mem_free(sd_global->batch_incumb);
 	mem_free(sd_global->Obj_lb);
 	mem_free(sd_global->quad_v);
+	mem_free(sd_global->ck);
 
 	/* modified by Yifan 2013.02.15 */
 	free_bcuts(sd_global->bcuts);
@@ -553,7 +605,7 @@ else
 	free_bcuts(sd_global->bfcuts_pool);
 	/* modified by Yifan 2013.05.05 Free sd_global->bfcuts in the following manner
 	 since sd_global->bfcuts only store pointers that point to sd_global->bfcuts_pool */
-  for (idx=0; idx<BATCH_SIZE; idx++) {
+  for (idx=0; idx<sd_global->reps.max; idx++) {
     if (sd_global->bfcuts->batch[idx]!= NULL) {
       if (sd_global->bfcuts->batch[idx]->val!=NULL) {
         mem_free(sd_global->bfcuts->batch[idx]->val);
@@ -566,9 +618,14 @@ else
   
     mem_free(sd_global->bfcuts->batch);
 	mem_free(sd_global->bfcuts);
+	free_cut_slab(sd_global->cut_slab);
 
-	free_one_prob(sd_global->batch_problem);
+	if (sd_global->batch_problem != NULL)
+		free_one_prob(sd_global->batch_problem);
 	free_one_prob(probptr);
+	free_rep_pool(sd_global);
+	mem_free(seed1);
+	mem_free(seed2);
 
 	/* Release the CPLEX environment. zl */
 	close_Solver();
@@ -20,6 +20,10 @@
 //optimal.c
 #define  HOOPS 3
 
+//omega.c
+#define MEMO_START	1024	/* initial buckets of an obs_memo_type, a power of 2 */
+#define MEMO_MAX	1048576	/* observations beyond this many are not memoized */
+
 //prob.h
 /*
  ** "#define" or "#undef" these flags to control debugging print statements.
@@ -47,6 +51,7 @@
 #undef RECOURSE_OBJ
 #undef OMEGA_FILE
 #undef REC_OMEGA
+#undef SD_FLOAT   /* keeps the sigma and delta coefficients in single precision */
 
 /*
  ** Some constants used in various places
@@ -60,18 +65,40 @@
 #define NUM_DBLS	6	/* ~ # of doubles that can fit on one line */
 
 #define DROPPED		-1	/* Code for a dropped Pi in a cut's istar */
+#define EVICTED		-2	/* Code for an istar whose Pi was evicted, until recomputed */
 #define UNUSED		0	/* Code for an available location in array */
 #define USED		1	/* Code for an occupied location in array */
 #define SDLP              0       /* Code for MASTER_TYPE as Basic LP zl */
 #define SDQP              1       /* Code for MASTER_TYPE as Regularized QP zl */
 
-#define BATCH_SUFFIX 3
+#define BATCH_SUFFIX 12	/* "_B" and the digits of any replication id */
 #define BUFFER_SIZE 248
+#define POOL_BLOCK	64	/* vectors carved at a time by a mem_pool_type */
+#define SCRATCH_SIZE	65536	/* first block of a cell's scratch arena, in bytes */
+#define MEM_OTHER	0	/* Subsystems memory is accounted to (see log.c) */
+#define MEM_DELTA	1
+#define MEM_SIGMA	2
+#define MEM_LAMBDA	3
+#define MEM_OMEGA	4
+#define MEM_CUTS	5
+#define MEM_SOLVER	6	/* our copies of problems handed to the solver */
+#define MEM_SUBSYS	7	/* how many there are */
+#define BUDGET_HIGH	0.9	/* fraction of MEM_BUDGET at which duals are evicted */
+#define BUDGET_LOW	0.75	/* fraction of MEM_BUDGET eviction aims for */
+#define DELTA_CHUNK	64	/* observations a delta row first has room for */
+#define DELTA_HOT	100	/* iterations a dual's delta tiles stay hot after its last istar */
+#define DELTA_PLACE	10	/* iterations between placements of delta tiles on disk */
+#define MAP_EXTENT	(64 << 20)	/* bytes of a mem_map_type file mapped at a time */
+#define ISTAR_CHAR	127	/* largest istar held in one byte */
+#define ISTAR_SHORT	32767	/* largest istar held in two bytes */
+#define SLAB_MIN	64	/* smallest istar buffer of a cut slab, in bytes */
+#define SLAB_CLASSES	20	/* size classes, doubling from SLAB_MIN */
 /* If you wish to run fewer than 30 replications, the normality property of CLT may not be questionable. */
 #define BATCH_SIZE 30
 
 #define ITER_DAT	"iter.dat"
 #define CNT_DAT		"cnt.mat"
+#define MEM_DAT		"mem.dat"
 #define L_HIST_DAT	"lamb_histo.mat"
 #define S_HIST_DAT	"sig_histo.mat"
 
@@ -101,6 +128,8 @@ typedef CPXENVptr ENVptr;
 #define PARAM_LPMETHOD   CPX_PARAM_LPMETHOD
 #define ALG_BARRIER      CPX_ALG_BARRIER
 #define ALG_AUTOMATIC    CPX_ALG_AUTOMATIC
+#define ALG_DUAL         CPX_ALG_DUAL
+#define ALG_QP_BARRIER   CPX_ALG_BARRIER
 #define ALG_CONCURRENT   CPX_ALG_CONCURRENT
 #define PROB_QP          CPXPROB_QP
 #define PARAM_BARCROSSALG CPX_PARAM_BARCROSSALG
@@ -136,6 +165,8 @@ typedef GRBenv ENVptr;
 #define PARAM_LPMETHOD   GRB_INT_PAR_METHOD
 #define ALG_BARRIER      GRB_INT_PAR_CROSSOVER
 #define ALG_AUTOMATIC    GRB_METHOD_AUTO
+#define ALG_DUAL         GRB_METHOD_DUAL
+#define ALG_QP_BARRIER   GRB_METHOD_BARRIER
 #define PARAM_BARCROSSALG GRB_INT_PAR_CROSSOVER
 #define PARAM_CROSSOVERBASIS  GRB_INT_PAR_CROSSOVERBASIS
 #define PARAM_BARALG     GRB_INT_PAR_BARORDER
@@ -218,6 +249,7 @@ ENVptr *env;
  ** Uses homemade allocation routines, so logging / accounting may be done.
  */
 #define		arr_alloc(n,type)	(type *)mem_calloc((n),sizeof(type))
+#define		arr_alloc_in(sub,n,type)	(type *)mem_calloc_in((sub),(n),sizeof(type))
 
 /************************************************************************\
 **		Macro Definitions for dynamic memory allocations
@@ -240,6 +272,14 @@ ENVptr *env;
 #define mem_calloc(n,size) log_alloc("calloc : " #n " : " #size, \
                                       calloc((n),(size)), ((n) * size))
 
+/*
+ ** As mem_calloc() and mem_malloc(), but the memory is accounted to the
+ ** subsystem _sub_ (one of the MEM_ codes) rather than to MEM_OTHER.
+ */
+#define mem_calloc_in(sub,n,size) log_alloc_in((sub), "calloc : " #n " : " #size, \
+                                      calloc((n),(size)), (size_t) (n) * (size))
+#define mem_malloc_in(sub,n) log_alloc_in((sub), "malloc : " #n, malloc((n)), (n))
+
 /*
  ** Returns a pointer to allocated memory of size _n_
  ** Also logs information about the memory allocated.
@@ -263,9 +303,35 @@ ENVptr *env;
  ** Frees the memory associated with the pointer _ptr_
  ** Also compares information about the memory freed with that allocated
  **
- #define mem_free(ptr) log_free(#ptr,(ptr))
+ #define mem_free(ptr) free(ptr)
  **
  */
-#define mem_free(ptr) free(ptr)
+#define mem_free(ptr) log_free(#ptr,(ptr))
+
+/*
+ ** Returns an object of type _type_ from the pool _pool_, which must have
+ ** been made for objects of that size (see new_mem_pool()), and gives it
+ ** back.  The blocks of a pool are only released with the pool itself.
+ */
+#define pool_alloc(pool,type) (type *)mem_pool_get(pool)
+#define pool_free(pool,ptr) mem_pool_put((pool),(ptr))
+
+/*
+ ** Returns scratch space for an array of type _type_ and size _n_ from
+ ** the arena _arena_.  It lasts until the arena is next reset, and is
+ ** never freed on its own.
+ */
+#define scratch_alloc(arena,n,type) \
+	(type *)mem_arena_get((arena),(n) * sizeof(type))
+
+/*
+ ** Returns the istar of observation _obs_ in the cut _cut_, whatever the
+ ** width its istars are currently stored in (see set_istar()).
+ */
+#define get_istar(cut,obs) \
+	((cut)->istar_width == sizeof(signed char) ? \
+		(int) ((signed char *) (cut)->istar)[obs] : \
+	 (cut)->istar_width == sizeof(short) ? \
+		(int) ((short *) (cut)->istar)[obs] : ((int *) (cut)->istar)[obs])
 
 #endif /* SDCONSTANTS_H_ */
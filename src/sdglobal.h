@@ -10,6 +10,7 @@
 #include "sdconstants.h"
 #include "time.h"
 #include <stdlib.h>
+#include <sys/types.h>
 
 typedef enum
 {
@@ -19,6 +20,13 @@ typedef enum
 /***** MAKE THIS unsigned int SO THAT BITWISE OPERATIONS WORK RIGHT ******/
 typedef int sd_small; /* Type used for elements of omega */
 
+/* Type of the Pi x R and Pi x T coefficients kept in sigma and delta */
+#ifdef SD_FLOAT
+typedef float coef_type;
+#else
+typedef double coef_type;
+#endif
+
 typedef struct
 {
 	sd_small upper;
@@ -162,8 +170,98 @@ typedef struct
 	int DETAILED_SOLN;
 	int MULTIPLE_REP;
 	int AUTO_SEED;
+	int NUM_THREADS; /* threads for the bootstrap in full_test() and for evaluate_inc() */
+	int SEQ_TEST; /* 1 to stop the bootstrap by a sequential (SPRT) rule */
+	double SEQ_DELTA; /* half width of the indifference zone around PERCENT_PASS */
+	double SEQ_ERROR; /* error probabilities of the sequential rule */
+	int EVAL_VR; /* sampling in evaluate_inc(): 0 iid, 1 antithetic, 2 LHS, 3 control variate */
+	int EVAL_LHS_BLOCK; /* draws per Latin hypercube block when EVAL_VR is 2 */
+	int REP_WORKERS; /* replications solved at the same time, one process each */
+	int MAX_REPS; /* most replications in the batch (compromise) problem */
+	int ADAPT_REPS; /* 1 to stop replicating once the replications' incumbent estimates agree */
+	int MIN_REPS; /* replications before ADAPT_REPS may stop */
+	double REP_TOL; /* relative 95% half width of the mean incumbent estimate that stops ADAPT_REPS */
+	int BATCH_DECOMP; /* compromise problem: 0 in one piece, 1 by progressive hedging */
+	double PH_RHO; /* progressive hedging penalty, in multiples of the regularizer */
+	double PH_TOL; /* relative residuals that stop progressive hedging */
+	int PH_MAX_ITER; /* most rounds of progressive hedging */
+	int MEM_BUDGET; /* megabytes in use past which the coldest duals are evicted, 0 for no limit */
+	int DELTA_DISK; /* 1 keeps the pi X Tomega vectors of delta in a mapped file */
 } config_type;
 
+/**************************************************************************\
+**  Regions of memory for the structures that grow by a piece every
+ ** iteration (see log.c).  A mem_pool_type hands out objects of one
+ ** _size_, _per_block_ at a time carved from blocks of its own; dropped
+ ** objects wait on the _free_list_ for the next request, and the blocks
+ ** are released all at once with the pool.  A mem_arena_type hands out
+ ** scratch space that lasts until the next mem_arena_reset(), once an
+ ** iteration.  _cnt_ is the number of objects (or bytes) in use and
+ ** _peak_ the most there have been.
+ **
+ **   A pool with a _map_ takes its blocks from a mem_map_type instead of
+ ** the heap.  The map keeps blocks of _block_ bytes (header included) in
+ ** an unlinked file, mapped _per_extent_ blocks at a time, so the system
+ ** may page them out to disk and back.  The _cnt_ extents mapped so far
+ ** are at _extent_, _used_ blocks of the last are handed out, and blocks
+ ** given back wait on _free_list_.
+ \**************************************************************************/
+typedef struct mem_block
+{
+	struct mem_block *next;
+	size_t size; /* bytes after the header */
+	size_t used;
+} mem_block_type;
+
+typedef struct
+{
+	int fd;
+	size_t block;
+	int per_extent;
+	int cnt;
+	char **extent;
+	int used;
+	mem_block_type *free_list;
+} mem_map_type;
+
+typedef struct
+{
+	size_t size;
+	int per_block;
+	mem_block_type *blocks;
+	void *free_list;
+	int cnt;
+	int peak;
+	int sub; /* what its blocks are accounted to */
+	mem_map_type *map; /* where its blocks come from, NULL for the heap */
+} mem_pool_type;
+
+typedef struct
+{
+	mem_block_type *blocks; /* the one being carved first */
+	size_t cnt;
+	size_t peak;
+} mem_arena_type;
+
+/**************************************************************************\
+**  Every allocation made through the mem_ macros is noted, by address,
+ ** with its _size_ and the subsystem _sub_ it is accounted to, so that a
+ ** free can take it off again (see log.c).  A mem_use_type holds the bytes
+ ** in use by a subsystem, _cur_, and the most there have been, _peak_.
+ \**************************************************************************/
+typedef struct
+{
+	void *ptr;
+	size_t size;
+	int sub;
+} mem_note_type;
+
+typedef struct
+{
+	sd_long cur;
+	sd_long peak;
+} mem_use_type;
+
 /**************************************************************************\
 **  Struct omegastuff contains all pertinent information related to the
  ** stochastic elements in the SD problem.
@@ -267,7 +365,10 @@ typedef struct
  ** in _alpha_, a vector of coefficients for the master program's primal
  ** variables, stored in _beta_, and an array of indices to the maximal pi
  ** for each observation of omega, stored in _istar_ (these are references
- ** into sigma).  In order to weight the cuts properly, _cut_obs_ gives
+ ** into sigma).  The istars are kept _istar_width_ bytes apiece, as few
+ ** as the largest of them needs, and are read with get_istar() and written
+ ** with set_istar(), which widens them when needed.  In order to weight
+ ** the cuts properly, _cut_obs_ gives
  ** the number of samples on which the given cut was based.  In contrast,
  ** _omega_cnt_ gives the number of *distinct* observations on which the
  ** cut was based (this is also the length of istar).
@@ -284,7 +385,8 @@ typedef struct
  \**************************************************************************/
 typedef struct
 {
-	int *istar;
+	void *istar;
+	int istar_width;
 	int slack_cnt;
 	int cell_num;
 	int omega_cnt;
@@ -299,15 +401,35 @@ typedef struct
 	int *subobj_freq; /*added by Yifan 02/02/12/ */
 } one_cut, *cut_ptr;
 
+/**************************************************************************\
+**   The cuts of a run are carved from a slab rather than the heap, and go
+ ** back to it when they are dropped.  The _beta_ rows of _num_x_+1
+ ** coefficients come _max_cuts_ to a block, so the cuts of a cell mostly
+ ** lie in one matrix.  The istar and subobj arrays, whose length is the
+ ** number of observations when the cut was formed, come from _buf_, one
+ ** pool per size class (doubling from SLAB_MIN bytes), created when first
+ ** needed; longer ones come from the heap.
+ \**************************************************************************/
+typedef struct
+{
+	int num_x;
+	int max_cuts;
+	mem_pool_type *cut;
+	mem_pool_type *beta;
+	mem_pool_type *buf[SLAB_CLASSES];
+} cut_slab_type;
+
 /**************************************************************************\
 **   A collection of the single cuts described above is stored here.
  ** The _val_ array holds pointers to cut structures, while the _cnt_
- ** field tells how many cuts are currently stored in _val_.
+ ** field tells how many cuts are currently stored in _val_.  The cuts
+ ** come from, and are given back to, _slab_.
  \**************************************************************************/
 typedef struct
 {
 	int cnt;
 	one_cut **val;
+	cut_slab_type *slab;
 } cut_type, *cuts_ptr;
 
 typedef struct
@@ -316,6 +438,54 @@ typedef struct
 	cut_type **batch;
 } batch_cut_type, *bcuts_ptr;
 
+/**************************************************************************\
+**  What a replication adds to the batch problem: the rhs and bounds of
+ ** its master, and one row per optimality and feasibility cut.  Row i
+ ** keeps only its nonzeros, ind[beg[i]] to ind[beg[i+1]-1], on master
+ ** columns with mast_cols standing for eta.
+ \**************************************************************************/
+typedef struct
+{
+	vector rhs;
+	vector lb;
+	vector ub;
+	int rows;
+	int *beg;
+	int *ind;
+	vector val;
+	vector coef_rhs;
+} batch_share_type;
+
+/**************************************************************************\
+**  When REP_WORKERS > 1 most replications are solved by forked worker
+ ** processes, each in its own output folder, and only hand their share
+ ** of the batch problem back.  _pid_ holds the worker of a replication
+ ** (-1 if it has none, 0 once it has exited) and _next_ is the first
+ ** replication whose share has not been recorded.  _max_ replications
+ ** at most are run, _started_ of them so far; _num_ of them, a prefix,
+ ** form the batch problem.  _stop_ is set once ADAPT_REPS needs no more.
+ ** The block of replication i in the batch problem starts at row
+ ** _batch_row_[i] and ends with its _batch_cuts_[i] cut rows.  With
+ ** BATCH_DECOMP there is no batch problem, and the block is a problem of
+ ** its own, _block_[i], starting at row 0.
+ \**************************************************************************/
+typedef struct
+{
+	int workers;
+	int running;
+	int started;
+	int next;
+	int max;
+	int num;
+	BOOL stop;
+	BOOL child;
+	char *dir;
+	pid_t *pid;
+	int *batch_row;
+	int *batch_cuts;
+	one_problem **block;
+} rep_pool_type;
+
 typedef struct
 {
 	config_type config;
@@ -328,7 +498,8 @@ typedef struct
 	batch_cut_type *bcuts;
 	batch_cut_type *bfcuts;
 	batch_cut_type *bfcuts_pool;
-	double ck[BATCH_SIZE];
+	cut_slab_type *cut_slab;
+	vector ck;
 	double Eta0;
 	FILE *fptrALLOC;
 	FILE *fptrFREE;
@@ -341,6 +512,7 @@ typedef struct
     int obj_flag;
     double obj_mean;
     double obj_stdev;
+	rep_pool_type reps;
 } sdglobal_type;
 
 #endif /* SDGLOBAL_H_ */
@@ -50,7 +50,7 @@ int calc_sigma(sdglobal_type* sd_global, cell_type *c, sigma_type *sigma,
 {
 	double pi_R; /* scalar value of Pi x Rbar */
 	double Mu_R; /* added by Yifan to store Mu x R */
-	vector pi_T; /* reduced vector product of Pi x Tbar */
+	coef_type *pi_T; /* reduced vector product of Pi x Tbar */
 	vector temp; /* temporary full product of Pi x Tbar */
 	int cnt; /* steps through sigma structure */
 
@@ -64,9 +64,10 @@ int calc_sigma(sdglobal_type* sd_global, cell_type *c, sigma_type *sigma,
 
 	pi_R = PIxR(pi_k, Rbar) + Mu_R;
 
-	temp = PIxT(pi_k, Tbar, num->mast_cols);
-	pi_T = reduce_vect(temp, sigma->col, num->nz_cols);
-	mem_free(temp);
+	temp = PIxT_to(scratch_alloc(c->scratch, num->mast_cols+1, double), pi_k,
+			Tbar, num->mast_cols);
+	pi_T = reduce_vect_coef(pool_alloc(sigma->pool, coef_type), temp,
+			sigma->col, num->nz_cols);
 
 	if (!new_lamb)
 	{
@@ -78,12 +79,12 @@ int calc_sigma(sdglobal_type* sd_global, cell_type *c, sigma_type *sigma,
 			/* Add <= and DBL_ABS in case pi_R is zero or negative 04/25/2013 Yifan */
 			if (DBL_ABS(pi_R - sigma->val[cnt].R)
 					<= sd_global->config.TOLERANCE * DBL_ABS(pi_R))
-				if (equal_arr(pi_T, sigma->val[cnt].T, num->nz_cols,
+				if (equal_coef(pi_T, sigma->val[cnt].T, num->nz_cols,
 						sd_global->config.TOLERANCE))
 				{
 					if (sigma->lamb[cnt] == lamb_idx)
 					{
-						mem_free(pi_T);
+						pool_free(sigma->pool, pi_T);
 						*new_sigma = FALSE;
 						return cnt;
 					}
@@ -103,6 +104,7 @@ int calc_sigma(sdglobal_type* sd_global, cell_type *c, sigma_type *sigma,
 	sigma->val[sigma->cnt].T = pi_T;
 	sigma->lamb[sigma->cnt] = lamb_idx;
 	sigma->ck[sigma->cnt] = c->k;
+	sigma->last[sigma->cnt] = c->k;
 
 	if (sd_global->MALLOC)
 	{
@@ -153,18 +155,22 @@ sigma_type *new_sigma(int num_iter, int num_nz_cols, int num_pi,
 	if (!(sigma = (sigma_type *) mem_malloc (sizeof(sigma_type))))
 		err_msg("Allocation", "new_sigma", "sigma");
 
-	if (!(sigma->lamb = arr_alloc(num_iter, int)))
+	if (!(sigma->lamb = arr_alloc_in(MEM_SIGMA, num_iter, int)))
 		err_msg("Allocation", "new_sigma", "sigma->lamb");
 
-	if (!(sigma->ck = arr_alloc(num_iter, int)))
+	if (!(sigma->ck = arr_alloc_in(MEM_SIGMA, num_iter, int)))
 		err_msg("Allocation", "new_sigma", "sigma->ck");
 
-	if (!(sigma->val = arr_alloc(num_iter, pi_R_T_type)))
+	if (!(sigma->last = arr_alloc_in(MEM_SIGMA, num_iter, int)))
+		err_msg("Allocation", "new_sigma", "sigma->last");
+
+	if (!(sigma->val = arr_alloc_in(MEM_SIGMA, num_iter, pi_R_T_type)))
 		err_msg("Allocation", "new_sigma", "sigma->val");
 
+	sigma->pool = new_mem_pool((num_nz_cols + 1) * sizeof(coef_type),
+			POOL_BLOCK, MEM_SIGMA);
 	for (cnt = 0; cnt < num_pi && cnt < num_iter; cnt++)
-		if (!(sigma->val[cnt].T = arr_alloc(num_nz_cols+1, double)))
-			err_msg("Allocation", "new_sigma", "sigma->val[cnt]");
+		sigma->val[cnt].T = pool_alloc(sigma->pool, coef_type);
 
 	sigma->col = coord->sigma_col;
 	sigma->cnt = num_pi;
@@ -180,17 +186,15 @@ sigma_type *new_sigma(int num_iter, int num_nz_cols, int num_pi,
  \***********************************************************************/
 void free_sigma(sigma_type *sigma)
 {
-	int cnt;
-
 #ifdef TRACE
 	printf("Inside free_sigma\n");
 #endif
 
 	mem_free(sigma->lamb);
 	mem_free(sigma->ck);
+	mem_free(sigma->last);
 	//added by Yifan to clean iteration number(c->k) records
-	for (cnt = 0; cnt < sigma->cnt; cnt++)
-		mem_free(sigma->val[cnt].T);
+	free_mem_pool(sigma->pool);
 	mem_free(sigma->val);
 	mem_free(sigma);
 }
@@ -32,6 +32,9 @@
 #include "subprob.h"
 #include "solver.h"
 #include "batch.h"
+#include "supomega.h"
+#include "rvgen.h"
+#include "optimal.h"
 #include "sdglobal.h"
 
 /***********************************************************************\
@@ -141,20 +144,21 @@ soln_type * new_soln(sdglobal_type* sd_global, prob_type *p, vector x_k)
 	 procedures of the SD algorithm. added by zl, 06/29/04. */
 	if (!(s->run_time = (time_type *) mem_malloc (sizeof(time_type))))
 		err_msg("Allocation", "time_type", "s->run_time");
-	if (!(s->Batch_pi = (vector *) mem_calloc (BATCH_SIZE, sizeof(vector))))
+	s->num_batch = sd_global->reps.max;
+	if (!(s->Batch_pi = (vector *) mem_calloc (s->num_batch, sizeof(vector))))
 		err_msg("Allocation", "new_soln", "Batch_pi");
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (i = 0; i < s->num_batch; i++)
 	{
 		s->Batch_pi[i] = arr_alloc(p->num->mast_rows+p->num->max_cuts+1,double);
 	}
-	if (!(s->Batch_dj = (vector *) mem_calloc (BATCH_SIZE, sizeof(vector))))
+	if (!(s->Batch_dj = (vector *) mem_calloc (s->num_batch, sizeof(vector))))
 		err_msg("Allocation", "new_soln", "Batch_pi");
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (i = 0; i < s->num_batch; i++)
 	{
 		s->Batch_dj[i] = arr_alloc(p->num->mast_cols+2,double);
 	}
 
-	if (!(s->xc_height = arr_alloc(BATCH_SIZE, double)))
+	if (!(s->xc_height = arr_alloc(s->num_batch, double)))
 		err_msg("Allocation", "new_soln", "xc_height");
 	/*beta is used to store cut coefficients*/
 	if (!(s->beta = arr_alloc(p->num->mast_cols+1, double)))
@@ -187,6 +191,10 @@ soln_type * new_soln(sdglobal_type* sd_global, prob_type *p, vector x_k)
 	s->optimality_flag = FALSE;
 	s->smpl_test_flag = FALSE; /* 08/17/04. */
 	s->smpl_ever_flag = FALSE; /* 08/20/04. */
+	s->passed = 0;
+	s->tested = 0;
+	s->full_test_cnt = 0;
+	s->full_test_reps = 0;
 	*s->dual_statble_flag = FALSE; /*added by Yifan 09/27/2011*/
 	s->incumbent_change = FALSE;
 
@@ -195,11 +203,13 @@ soln_type * new_soln(sdglobal_type* sd_global, prob_type *p, vector x_k)
 	s->sub_lb_checker = sd_global->config.SUBPROB_LB;
 
 	length = p->num->iter + p->num->iter / p->tau + 1;
-	s->omega = new_omega(p->num->iter, p->num->rv, p->coord);
-	s->delta = new_delta(length, p->coord);
+	s->omega = new_omega(p->num->iter, p->num->rv, p->num->cipher, p->coord);
+	s->delta = new_delta(length, p->num->iter, p->num->rv_cols, p->coord,
+			(BOOL) (sd_global->config.DELTA_DISK > 0));
 
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
-	s->feasible_delta = new_delta(length, p->coord);
+	s->feasible_delta = new_delta(length, p->num->iter, p->num->rv_cols,
+			p->coord, FALSE);
 
 	/* Make initial allocation of the x vectors -- not freed until the end */
 	s->incumb_x = duplic_arr(x_k, p->num->mast_cols);
@@ -253,15 +263,15 @@ soln_type * new_soln(sdglobal_type* sd_global, prob_type *p, vector x_k)
 ** This function frees the structures contained in the soln
  ** data structure, and then frees the soln itself.
  \***********************************************************************/
-void free_soln(prob_type *p, cell_type *c, soln_type *s)
+void free_soln(prob_type *p, soln_type *s)
 {
 	int i;
 #ifdef TRACE
 	printf("Inside free_soln\n");
 #endif
-	free_delta(s->delta, s->omega, c->lambda->cnt);
+	free_delta(s->delta);
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
-	free_delta(s->feasible_delta, s->omega, c->feasible_lambda->cnt);
+	free_delta(s->feasible_delta);
 	/* Yifan 03/04/2012 Updated for Feasibility Cuts*/
 	free_omega(s->omega);
 	mem_free(s->run_time);
@@ -278,7 +288,7 @@ void free_soln(prob_type *p, cell_type *c, soln_type *s)
 	mem_free(s->xc_height);
 	/* modified by Yifan 2012.09.28 */
 
-	for (i = 0; i < BATCH_SIZE; i++)
+	for (i = 0; i < s->num_batch; i++)
 	{
 		mem_free(s->Batch_pi[i]);
 		mem_free(s->Batch_dj[i]);
@@ -388,7 +398,7 @@ void print_soln(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 				fprintf(
 						f_out,
 						"Optimality test: Full_passed  #passed: %d, #failed: %d.\n",
-						s->passed, sd_global->config.M - s->passed);
+						s->passed, s->tested - s->passed);
 
 			fprintf(f_out, "Inc_UB = %f, LB = %f, error = %f\n\n",
 					s->incumb_est, s->candid_est,
@@ -456,6 +466,9 @@ void print_soln(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 			s->run_time->soln_subprob_accum);
 	fprintf(f_out, "Accumulated full test time \t= %.2f\n",
 			s->run_time->full_test_accum);
+	if (s->full_test_cnt > 0)
+		fprintf(f_out, "Replications per full test \t= %.2f\n",
+				(double) s->full_test_reps / (double) s->full_test_cnt);
 	fprintf(f_out, "Accumulated argmax time \t= %.2f\n",
 			s->run_time->argmax_accum);
 	fclose(f_out);
@@ -534,16 +547,17 @@ int print_detailed_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p,
 
 	else
 	{
-		if (BATCH_SIZE >= 30)
+		if (sd_global->reps.num >= 30)
 		{
 			s->Obj_lb_U = s->Obj_lb_mean + 1.96 * s->Obj_lb_stdev;
 			s->Obj_lb_L = s->Obj_lb_mean - 1.96 * s->Obj_lb_stdev;
 		}
 		else
 		{
-			/*Needs update here, 2.093 is for BATCH_SIZE = 20 */
-			s->Obj_lb_U = s->Obj_lb_mean + 2.093 * s->Obj_lb_stdev;
-			s->Obj_lb_L = s->Obj_lb_mean - 2.093 * s->Obj_lb_stdev;
+			s->Obj_lb_U = s->Obj_lb_mean
+					+ t_quantile_95(sd_global->reps.num - 1) * s->Obj_lb_stdev;
+			s->Obj_lb_L = s->Obj_lb_mean
+					- t_quantile_95(sd_global->reps.num - 1) * s->Obj_lb_stdev;
 		}
         if (status == 3) {
           /* In this case, 3 replications are finished and thus the multiplier is for t dist with 2 degrees of freedom */
@@ -593,7 +607,8 @@ int print_detailed_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p,
 	}
 	if (status == 1 || status == 2)
 	{
-		fprintf(fp, "%-40s%d\n", "Number of replications:", BATCH_SIZE);
+		fprintf(fp, "%-40s%d\n", "Number of replications:",
+				sd_global->reps.num);
 	}
     if (status == 3) {
       fprintf(fp, "%-40s%d\n", "Number of replications:", 3);
@@ -733,7 +748,7 @@ int test_average_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p)
 	for (j = 1; j <= p->master->mac; j++)
 	{
 		a = 0.0;
-		for (i = 0; i < BATCH_SIZE; i++)
+		for (i = 0; i < sd_global->reps.num; i++)
 		{
 			a +=
 					DBL_ABS((sd_global->batch_incumb->incumb_x[i][j] - s->incumb_avg[j]));
@@ -748,36 +763,36 @@ int test_average_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p)
 	return 1;
 }
 
-void record_master_dual_and_obj(sdglobal_type* sd_global, prob_type *prob,
-		soln_type *soln, FILE *master_dual, FILE *master_obj)
+/*
+ ** Records the master duals _pi_ and reduced costs _dj_ of replication
+ ** _batch_id_, and appends them and the master value to Master_Dual.out
+ ** and Master_Obj.out.
+ */
+void store_master_dual_and_obj(sdglobal_type* sd_global, prob_type *prob,
+		int batch_id, vector pi, vector dj, double opt_value)
 {
+	FILE *master_dual, *master_obj;
 	int i;
 
 	master_dual = fopen("Master_Dual.out", "a");
-	fprintf(master_dual, "Here are the duals for batch%d\n",
-			prob->current_batch_id);
-	sd_global->batch_incumb->R_Master_pi[prob->current_batch_id][0] =
-			soln->Master_pi[0];
+	fprintf(master_dual, "Here are the duals for batch%d\n", batch_id);
+	sd_global->batch_incumb->R_Master_pi[batch_id][0] = pi[0];
 	for (i = 1; i <= prob->num->mast_rows + prob->num->max_cuts; i++)
 	{
-		sd_global->batch_incumb->R_Master_pi[prob->current_batch_id][i] =
-				soln->Master_pi[i];
-		fprintf(master_dual, "%f\n", soln->Master_pi[i]);
+		sd_global->batch_incumb->R_Master_pi[batch_id][i] = pi[i];
+		fprintf(master_dual, "%f\n", pi[i]);
 	}
-	fprintf(master_dual, "Here are the dual slacks for batch%d\n",
-			prob->current_batch_id);
-	sd_global->batch_incumb->R_Master_dj[prob->current_batch_id][0] =
-			soln->Master_dj[0];
+	fprintf(master_dual, "Here are the dual slacks for batch%d\n", batch_id);
+	sd_global->batch_incumb->R_Master_dj[batch_id][0] = dj[0];
 	for (i = 1; i <= prob->num->mast_cols; i++)
 	{
-		sd_global->batch_incumb->R_Master_dj[prob->current_batch_id][i] =
-				soln->Master_dj[i];
-		fprintf(master_dual, "%f\n", soln->Master_dj[i]);
+		sd_global->batch_incumb->R_Master_dj[batch_id][i] = dj[i];
+		fprintf(master_dual, "%f\n", dj[i]);
 	}
 	fclose(master_dual);
 
 	master_obj = fopen("Master_Obj.out", "a");
-	fprintf(master_obj, "Here is the optimal value\n%f\n", soln->opt_value);
+	fprintf(master_obj, "Here is the optimal value\n%f\n", opt_value);
 	fclose(master_obj);
 }
 
@@ -786,23 +801,31 @@ void process_batch_prob(sdglobal_type* sd_global, prob_type *prob,
 		FILE *batch_obj)
 {
 	int i, j, k;
-	*obj = get_objective(sd_global->batch_problem);
-	for (prob->num->batch_id = 0; prob->num->batch_id < BATCH_SIZE;
+	one_problem *bp;
+
+	/* With BATCH_DECOMP, solve_batch_ph() has already set both */
+	if (!sd_global->config.BATCH_DECOMP)
+		*obj = get_objective(sd_global->batch_problem);
+	for (prob->num->batch_id = 0; prob->num->batch_id < sd_global->reps.num;
 			prob->num->batch_id++)
 	{
-		get_dual(soln->Batch_pi[prob->num->batch_id], sd_global->batch_problem,
-				prob->num, prob->num->mast_rows);
-		get_dual_slacks(soln->Batch_dj[prob->num->batch_id],
-				sd_global->batch_problem, prob->num, prob->num->mast_cols);
+		bp = batch_block(sd_global, prob, prob->num->batch_id,
+				&prob->num->batch_row, &prob->num->batch_col);
+		prob->num->batch_cuts = min(sd_global->reps.batch_cuts[prob->num->batch_id],
+				prob->num->max_cuts);
+		get_dual(soln->Batch_pi[prob->num->batch_id], bp, prob->num,
+				prob->num->mast_rows);
+		get_dual_slacks(soln->Batch_dj[prob->num->batch_id], bp, prob->num,
+				prob->num->mast_cols);
 
 		for (k = 0; k <= prob->num->mast_rows + prob->num->max_cuts; k++)
 		{
-			soln->Batch_pi[prob->num->batch_id][k] = BATCH_SIZE
+			soln->Batch_pi[prob->num->batch_id][k] = sd_global->reps.num
 					* soln->Batch_pi[prob->num->batch_id][k];
 		}
 		for (k = 0; k <= prob->num->mast_cols; k++)
 		{
-			soln->Batch_dj[prob->num->batch_id][k] = BATCH_SIZE
+			soln->Batch_dj[prob->num->batch_id][k] = sd_global->reps.num
 					* soln->Batch_dj[prob->num->batch_id][k];
 		}
 
@@ -825,23 +848,24 @@ void process_batch_prob(sdglobal_type* sd_global, prob_type *prob,
 	/* modified by Yifan 2012.10.05 */
 	/* Calculate mean and stdard deviation of duals and reduced costs for compromise solution*/
 	calc_mean_stdev(soln->Batch_pi, soln->Batch_pi_mean, soln->Batch_pi_stdev,
-			prob->num->mast_rows, BATCH_SIZE);
+			prob->num->mast_rows, sd_global->reps.num);
 	calc_mean_stdev(soln->Batch_dj, soln->Batch_dj_mean, soln->Batch_dj_stdev,
-			prob->num->mast_cols, BATCH_SIZE);
+			prob->num->mast_cols, sd_global->reps.num);
 
 	/* modified by Yifan 2012.10.05 */
 	/* Calculate mean and stdard deviation of duals and reduced costs for mean solution*/
 	calc_mean_stdev(sd_global->batch_incumb->R_Master_pi,
 			soln->R_Master_pi_mean, soln->R_Master_pi_stdev,
-			prob->num->mast_rows, BATCH_SIZE);
+			prob->num->mast_rows, sd_global->reps.num);
 	calc_mean_stdev(sd_global->batch_incumb->R_Master_dj,
 			soln->R_Master_dj_mean, soln->R_Master_dj_stdev,
-			prob->num->mast_cols, BATCH_SIZE);
+			prob->num->mast_cols, sd_global->reps.num);
 
 	calc_var(sd_global, sd_global->Obj_lb, &soln->Obj_lb_mean,
-			&soln->Obj_lb_stdev, BATCH_SIZE);
+			&soln->Obj_lb_stdev, sd_global->reps.num);
 
-	get_primal(soln->incumb_d, sd_global->batch_problem, prob->num->mast_cols);
+	if (!sd_global->config.BATCH_DECOMP)
+		get_primal(soln->incumb_d, sd_global->batch_problem, prob->num->mast_cols);
 	/* Get the unified X by adding the first incumbent solution x1 and d1 */
 	batch_d = fopen("Batch_x.out", "a");
 	fprintf(batch_d, "Here are the batch X:\n");
@@ -852,17 +876,17 @@ void process_batch_prob(sdglobal_type* sd_global, prob_type *prob,
 	}
 	/* c_xc is used to estimate the lower bound of the problem */
 	soln->c_xc = CxX(prob->c, soln->incumb_d, prob->num->mast_cols);
-	get_beta_x(sd_global, soln, soln->beta, sd_global->batch_problem, prob->num,
+	get_beta_x(sd_global, soln, soln->beta, prob, prob->num,
 			prob->num->mast_cols);
 	fprintf(batch_d, "Here are the Average X of replications:\n");
 	for (i = 1; i <= prob->num->mast_cols; i++)
 	{
 		soln->incumb_avg[i] = 0.0;
-		for (j = 0; j < BATCH_SIZE; j++)
+		for (j = 0; j < sd_global->reps.num; j++)
 		{
 			soln->incumb_avg[i] += sd_global->batch_incumb->incumb_x[j][i];
 		}
-		soln->incumb_avg[i] /= (1.0 * BATCH_SIZE);
+		soln->incumb_avg[i] /= (1.0 * sd_global->reps.num);
 	}
 	for (i = 1; i <= prob->num->mast_cols; i++)
 	{
@@ -1463,6 +1487,246 @@ double calc_q_vec(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 
 }
 
+/************************************************************************\
+** This function draws one observation for the evaluation worker w,
+ ** located from the uniforms in u when u is not NULL and from the
+ ** worker's EVAL_SEED1 otherwise, solves the subproblem at candid_x and
+ ** returns its objective value in obj.  The omega structure is squashed
+ ** back down to nothing before returning, while the worker's sub_rhs
+ ** keeps the right hand side solved.  When the worker has a memo, an
+ ** observation already met is not solved again: its value is taken from
+ ** the memo (X is fixed throughout evaluate_inc), and only the right hand
+ ** side is recomputed.
+ \************************************************************************/
+BOOL eval_observ(eval_work_type *w, double *u, double *obj)
+{
+	sdglobal_type *sd_global = w->sd_global;
+	prob_type *prob = w->prob;
+	soln_type *soln = w->soln;
+	obs_memo_type *memo = w->memo;
+	BOOL new_omega;
+	int obs = 0, slot = 0;
+
+#ifdef OMEGA_FILE
+	get_observ(sd_global, soln->omega, prob->num, &new_omega);        /* Yifan 2012.05.21 */
+#else
+	if (u)
+		obs = generate_observ_u(sd_global, soln->omega, prob->num, &new_omega, u);
+	else
+		obs = generate_observ(sd_global, soln->omega, prob->num, &new_omega, &(sd_global->config.EVAL_SEED1));
+#endif
+
+	if (memo)
+		slot = obs_memo_slot(memo, soln->omega->idx[obs]);
+	if (memo && memo->key[slot])
+	{
+		*obj = memo->val[slot];
+		compute_sub_rhs(sd_global, prob, soln->candid_x, soln->omega, obs);
+	}
+	else
+	{
+		if (w->clone)
+		{
+			/* Same as solve_subprob(), without touching the shared state */
+			compute_sub_rhs(sd_global, prob, soln->candid_x, soln->omega, obs);
+			if (change_rhside(w->subprob, prob->sub_rhs->cnt, prob->sub_rhs->row,
+					prob->sub_rhs->val))
+				err_msg("change_rhside", "eval_observ", "returned error");
+			if (!solve_clone(w->subprob))
+			{
+				printf("CPLEX error occured in Subproblem clone\n");
+				return FALSE;
+			}
+			w->lp_cnt++;
+		}
+		else if (!solve_subprob(sd_global, prob, w->cell, soln, soln->candid_x, obs))
+		{
+			cplex_err_msg(sd_global, "Subproblem", prob, w->cell, soln);
+			return FALSE;
+		}
+		*obj = get_objective(w->subprob);
+		if (memo)
+			obs_memo_add(memo, soln->omega->idx[obs], *obj);
+	}
+
+#ifdef REC_OMEGA
+	{
+		int i;
+		/* Yifan 05/10/2012 Scenario Reader */
+		FILE *omg;
+		omg = fopen("sampleOmegas_eval", "a");
+		for(i=1; i <= sd_global->omegas.num_omega; i++){
+			/* Note that RT start from 1 but mean start from 0*/
+			fprintf(omg, "%f\t", soln->omega->RT[i]+sd_global->omegas.mean[i-1]);
+		}
+		fprintf(omg, "\n");
+		fclose(omg);
+	}
+#endif
+
+	/* Yifan 2012.05.21 */
+	/* Push the pointer to the next line of the omega */
+#ifdef OMEGA_FILE
+	if (soln->omega->fidx[0] == soln->omega->fidx[1]) {
+		err_msg("Need more samples", "evaluate.c", "evaluate_inc()");   /* Generate more samples ... */
+	}
+	soln->omega->fidx[0] = soln->omega->fidx[1];
+#endif
+
+	/* Squash the omega structure back down to nothing */
+	soln->omega->cnt = 0;
+	soln->omega->last = 0;
+	soln->omega->most = 0;
+	soln->omega->next = 0;
+	soln->omega->filter[soln->omega->next] = UNUSED;
+	soln->omega->weight[soln->omega->next] = 0;
+	pool_free(soln->omega->pool, soln->omega->idx[0]);
+
+	return TRUE;
+}
+
+/************************************************************************\
+** This function computes one unit of the estimate for worker w: the
+ ** average y of acc->lps subproblem values, which is one independent
+ ** draw (EVAL_VR 0 or 3), an antithetic pair u, 1-u (EVAL_VR 1), or a
+ ** Latin hypercube block taking exactly one draw from each of lps strata
+ ** of every uniform (EVAL_VR 2).  With the control variate, z is the
+ ** matching average of pi_bar x r(omega).  Units are independent of
+ ** one another, so the usual standard error applies to them.
+ \************************************************************************/
+BOOL eval_unit(eval_work_type *w, double *y, double *z)
+{
+	sd_long *seed = &(w->sd_global->config.EVAL_SEED1);
+	int vr = w->acc->vr, lps = w->acc->lps;
+	int dim = omega_u_dim(w->sd_global);
+	int b, d, j, tmp;
+	double ans;
+
+	if (vr == 2)
+		for (d = 0; d < dim; d++)
+		{
+			for (b = 0; b < lps; b++)
+				w->perm[d * lps + b] = b;
+			for (b = lps - 1; b > 0; b--)
+			{
+				j = min(b, (int) (scalit(0, 1, seed) * (b + 1)));
+				tmp = w->perm[d * lps + b];
+				w->perm[d * lps + b] = w->perm[d * lps + j];
+				w->perm[d * lps + j] = tmp;
+			}
+		}
+
+	*y = *z = 0.0;
+	for (b = 0; b < lps; b++)
+	{
+		if (vr == 1)
+			for (d = 0; d < dim; d++)
+				w->u[d] = b ? 1.0 - w->u[d] : scalit(0, 1, seed);
+		else if (vr == 2)
+			for (d = 0; d < dim; d++)
+				w->u[d] = (w->perm[d * lps + b] + scalit(0, 1, seed)) / lps;
+
+		if (!eval_observ(w, w->u, &ans))
+			return FALSE;
+		*y += ans;
+		if (vr == 3)
+			*z += pi_x_sub_rhs(w->prob, w->pi_bar);
+	}
+	*y /= lps;
+	*z /= lps;
+
+	return TRUE;
+}
+
+/************************************************************************\
+** This function adds the unit (y, z) to the running estimate in acc,
+ ** and raises acc->done once the 95% confidence interval is within
+ ** EVAL_ERROR of the mean (and at least 100 LPs and two units are in).
+ ** With the control variate, the part of y explained by z is regressed
+ ** out of both the mean and the variance.  It returns FALSE once the
+ ** estimate is done, so that the calling worker stops.
+ \************************************************************************/
+BOOL eval_merge(sdglobal_type* sd_global, eval_acc_type *acc, double y, double z)
+{
+	double dy, dz, vari;
+	int prev;
+	BOOL more;
+
+	pthread_mutex_lock(&acc->lock);
+
+	prev = acc->count;
+	acc->count += acc->lps;
+	acc->units++;
+
+	/* Running means and (co)moments of the units */
+	dy = y - acc->ybar;
+	acc->ybar += dy / acc->units;
+	acc->syy += dy * (y - acc->ybar);
+	if (acc->vr == 3)
+	{
+		dz = z - acc->zbar;
+		acc->zbar += dz / acc->units;
+		acc->szz += dz * (z - acc->zbar);
+		acc->syz += dy * (z - acc->zbar);
+	}
+
+	acc->mean = acc->ybar;
+	if (acc->units > 1)
+	{
+		vari = acc->syy / (acc->units - 1);
+		if (acc->vr == 3 && acc->szz > 0.0)
+		{
+			acc->mean -= acc->syz / acc->szz * (acc->zbar - acc->z_mean);
+			vari = (acc->syy - acc->syz * acc->syz / acc->szz) / (acc->units - 1);
+		}
+		acc->stdev = sqrt(vari / (double) acc->units);
+	}
+
+	if (!(3.92 * acc->stdev > sd_global->config.EVAL_ERROR * DBL_ABS(acc->mean)
+			|| acc->count < 100 || acc->units < 2))
+		acc->done = TRUE;
+
+	/* Print the results every once in a while for long runs */
+	if (acc->count / 250 != prev / 250)
+	{
+		printf(".");
+		fflush(stdout);
+	}
+	if (acc->count / 10000 != prev / 10000)
+		printf("\n\nobs:%d mean:%lf   error: %lf \n 0.95 CI: [%lf , %lf]\n",
+				acc->count, acc->cx + acc->mean, 3.92 * acc->stdev / acc->mean,
+				acc->cx + acc->mean - 1.96 * acc->stdev,
+				acc->cx + acc->mean + 1.96 * acc->stdev);
+
+	more = !acc->done;
+	pthread_mutex_unlock(&acc->lock);
+
+	return more;
+}
+
+/************************************************************************\
+** This function is the body of one evaluation worker: it computes units
+ ** and merges them into the shared estimate until that is done.
+ \************************************************************************/
+void *eval_worker(void *arg)
+{
+	eval_work_type *w = (eval_work_type *) arg;
+	double y, z;
+
+	do
+	{
+		if (!eval_unit(w, &y, &z))
+		{
+			pthread_mutex_lock(&w->acc->lock);
+			w->acc->done = w->acc->failed = TRUE;
+			pthread_mutex_unlock(&w->acc->lock);
+			break;
+		}
+	} while (eval_merge(w->sd_global, w->acc, y, z));
+
+	return NULL;
+}
+
 /************************************************************************\
 ** This function represents the SD algorithm, as solved for a
  ** single cell.  It creates temporary data structures required for
@@ -1480,20 +1744,21 @@ void evaluate_inc(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		soln_type *s, vector x_k, char *fname, double *conf_int, int status)
 {
 	soln_type *soln;
-	int omeg_idx;
-	/* int  i; */
-    BOOL new_omega;
 	FILE *fout /* , *fin, *fx */;
     FILE *time_sample;  /* modified by Yifan 2013.06.30 */
-	double ans;
 	double mean, stdev;
-	double vari, temp;
 	/* int		iteration; */
 	int count;
 	double cx;
 	clock_t eval_start_time;
 	clock_t eval_end_time;
 	double total_time;
+	eval_acc_type acc;
+	eval_work_type *work;
+	pthread_t *thread;
+	vector pi_bar = NULL;
+	sd_long base_seed = 0;
+	int n_work, i, dim, distinct = 0;
 
 
 #ifdef DEBUG
@@ -1527,98 +1792,181 @@ void evaluate_inc(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 	{
 		printf("\n\n Begin evaluation of incumbent solution \n");
 	}
-	count = 0;
-	mean = 0.0;
-	vari = 0.0;
-	stdev = 10000000.0;
-	temp = 0.0;
 
 	cx = CxX(prob->c, soln->candid_x, prob->num->mast_cols);
 	change_solver_primal(cell->subprob);
 #ifdef OMEGA_FILE
   soln->omega->fidx[0] = s->omega->fidx[cell->k];
 #endif
-	while (3.92 * stdev > sd_global->config.EVAL_ERROR * DBL_ABS(mean)
-			|| count < 100)
-	{
-		/* comment out by Yifan
-		 if (!(count % 100))
-		 printf("..%d.", count);
-		 */
-      
+
+	acc.vr = sd_global->config.EVAL_VR;
+	n_work = max(1, sd_global->config.NUM_THREADS);
 #ifdef OMEGA_FILE
-      get_observ(sd_global, soln->omega, prob->num, &new_omega);        /* Yifan 2012.05.21 */
-#else
-      omeg_idx = generate_observ(sd_global, soln->omega, prob->num, &new_omega, &(sd_global->config.EVAL_SEED1));
+	acc.vr = 0; /* the observations are read from the file in order */
+	n_work = 1;
 #endif
-      
-		
-		if (!solve_subprob(sd_global, prob, cell, soln, soln->candid_x, 0))
+	acc.lps = acc.vr == 1 ? 2 : acc.vr == 2 ? max(2, sd_global->config.EVAL_LHS_BLOCK) : 1;
+	acc.z_mean = 0.0;
+	acc.cx = cx;
+	acc.count = acc.units = 0;
+	acc.ybar = acc.zbar = acc.syy = acc.szz = acc.syz = 0.0;
+	acc.mean = 0.0;
+	acc.stdev = 10000000.0;
+	acc.done = acc.failed = FALSE;
+	pthread_mutex_init(&acc.lock, NULL);
+
+	/*
+	 ** The control variate is Z = pi_bar x r(omega), where pi_bar is the
+	 ** dual of the subproblem at the expected omega and r(omega) its
+	 ** right hand side.  r is affine in omega, so E[Z] is known exactly.
+	 */
+	if (acc.vr == 3)
+	{
+		if (!(pi_bar = arr_alloc(prob->num->sub_rows+1, double)))
+			err_msg("Allocation", "evaluate_inc", "pi_bar");
+		omega_expect(sd_global, soln->omega->RT + 1);
+		fill_sub_rhs(prob, soln->candid_x, soln->omega);
+		if (change_rhside(cell->subprob, prob->sub_rhs->cnt, prob->sub_rhs->row,
+				prob->sub_rhs->val))
+			err_msg("change_rhside", "evaluate_inc", "returned error");
+		cell->subprob->feaflag = TRUE;
+		if (solve_problem(sd_global, cell->subprob))
 		{
-			cplex_err_msg(sd_global, "Subproblem", prob, cell, soln);
-			break;
+			get_dual(pi_bar, cell->subprob, prob->num, prob->num->sub_rows);
+			acc.z_mean = pi_x_sub_rhs(prob, pi_bar);
 		}
-      
-#ifdef REC_OMEGA
-      int i;
-      /* Yifan 05/10/2012 Scenario Reader */
-      FILE *omg;
-      omg = fopen("sampleOmegas_eval", "a");
-      for(i=1; i <= sd_global->omegas.num_omega; i++){
-        /* Note that RT start from 1 but mean start from 0*/
-        fprintf(omg, "%f\t", soln->omega->RT[i]+sd_global->omegas.mean[i-1]);
-      }
-      fprintf(omg, "\n");
-      fclose(omg);
-#endif
-      
-      /* Yifan 2012.05.21 */
-      /* Push the pointer to the next line of the omega */
-#ifdef OMEGA_FILE
-      if (soln->omega->fidx[0] == soln->omega->fidx[1]) {
-        err_msg("Need more samples", "evaluate.c", "evaluate_inc()");   /* Generate more samples ... */
-      }
-      soln->omega->fidx[0] = soln->omega->fidx[1];
-#endif
-      /* Yifan 2012.05.21 */
-
-		ans = get_objective(cell->subprob);
+		else
+		{
+			printf("Mean value subproblem not solved, no control variate used\n");
+			acc.vr = 0;
+		}
+	}
 
-		if (count == 0)
+	/*
+	 ** The units are spread over n_work workers, each with its own solution
+	 ** structure, sampling stream, omega indices, right hand side and (but
+	 ** for the first, which runs on this thread) clone of the subproblem.
+	 ** They merge their units into acc as they go, and all stop once the
+	 ** estimate is tight enough.  With several workers, worker i samples
+	 ** from a stream seeded from EVAL_SEED1 and i, and EVAL_SEED1 moves on
+	 ** by one draw; a single worker samples from EVAL_SEED1 itself.
+	 */
+	dim = omega_u_dim(sd_global);
+	if (!(work = arr_alloc(n_work, eval_work_type)))
+		err_msg("Allocation", "evaluate_inc", "work");
+	if (!(thread = arr_alloc(n_work, pthread_t)))
+		err_msg("Allocation", "evaluate_inc", "thread");
+	for (i = 0; i < n_work; i++)
+	{
+		if (i == 0)
 		{
-			mean = ans;
+			work[i].sd_global = sd_global;
+			work[i].prob = prob;
+			work[i].subprob = cell->subprob;
+			work[i].soln = soln;
 		}
 		else
 		{
-			temp = mean;
-			mean = mean + (ans - mean) / (double) (count + 1);
-			vari = (1 - 1 / (double) count) * vari
-					+ (count + 1) * (mean - temp) * (mean - temp);
-			stdev = sqrt(vari / (double) count);
+			if (!(work[i].sd_global = (sdglobal_type *) mem_malloc (sizeof(sdglobal_type))))
+				err_msg("Allocation", "evaluate_inc", "work[i].sd_global");
+			*work[i].sd_global = *sd_global;
+			if (!(work[i].sd_global->omegas.indices = arr_alloc(sd_global->omegas.num_omega, sd_small)))
+				err_msg("Allocation", "evaluate_inc", "omegas.indices");
+
+			if (!(work[i].prob = (prob_type *) mem_malloc (sizeof(prob_type))))
+				err_msg("Allocation", "evaluate_inc", "work[i].prob");
+			*work[i].prob = *prob;
+			if (!(work[i].prob->sub_rhs = (sub_rhs_type *) mem_malloc (sizeof(sub_rhs_type))))
+				err_msg("Allocation", "evaluate_inc", "work[i].prob->sub_rhs");
+			*work[i].prob->sub_rhs = *prob->sub_rhs;
+			if (!(work[i].prob->sub_rhs->val = arr_alloc(prob->sub_rhs->cnt+1, double)))
+				err_msg("Allocation", "evaluate_inc", "sub_rhs->val");
+
+			if (!(work[i].subprob = (one_problem *) mem_malloc (sizeof(one_problem))))
+				err_msg("Allocation", "evaluate_inc", "work[i].subprob");
+			*work[i].subprob = *cell->subprob;
+			work[i].subprob->lp = clone_prob(cell->subprob);
+
+			work[i].soln = new_soln(sd_global, prob, x_k);
 		}
+		if (n_work > 1)
+			work[i].sd_global->config.EVAL_SEED1 = boot_seed(
+					sd_global->config.EVAL_SEED1, i);
+		work[i].cell = cell;
+		work[i].clone = n_work > 1;
+		work[i].lp_cnt = 0;
+		work[i].pi_bar = pi_bar;
+		work[i].acc = &acc;
+		work[i].memo = NULL;
+		work[i].u = NULL;
+		work[i].perm = NULL;
+#ifndef OMEGA_FILE
+		work[i].memo = new_obs_memo(prob->num->cipher + 1);
+#endif
+		if (acc.vr == 1 || acc.vr == 2)
+			if (!(work[i].u = arr_alloc(dim, double)))
+				err_msg("Allocation", "evaluate_inc", "work[i].u");
+		if (acc.vr == 2)
+			if (!(work[i].perm = arr_alloc(dim * acc.lps, int)))
+				err_msg("Allocation", "evaluate_inc", "work[i].perm");
+	}
 
-		count++;
+	if (n_work > 1)
+	{
+		/* Worker 0 shares sd_global, whose stream is put back below */
+		base_seed = sd_global->config.EVAL_SEED1;
+		work[0].sd_global->config.EVAL_SEED1 = boot_seed(base_seed, 0);
+		set_clone_params(TRUE);
+		for (i = 1; i < n_work; i++)
+			if (pthread_create(&thread[i], NULL, eval_worker, &work[i]))
+				err_msg("Thread", "evaluate_inc", "pthread_create");
+	}
+	eval_worker(&work[0]);
+	if (n_work > 1)
+	{
+		for (i = 1; i < n_work; i++)
+			pthread_join(thread[i], NULL);
+		set_clone_params(FALSE);
+		sd_global->config.EVAL_SEED1 = base_seed;
+		randUniform(&(sd_global->config.EVAL_SEED1));
+	}
 
-		/* Print the results every once in a while for long runs */
-		if (!(count % 250))
+	for (i = 0; i < n_work; i++)
+	{
+		cell->LP_cnt += work[i].lp_cnt;
+		if (work[i].memo)
 		{
-			printf(".");
-			fflush(stdout);
+			distinct += work[i].memo->cnt;
+			free_obs_memo(work[i].memo);
+		}
+		if (work[i].u)
+			mem_free(work[i].u);
+		if (work[i].perm)
+			mem_free(work[i].perm);
+		if (i > 0)
+		{
+			free_soln(prob, work[i].soln);
+			remove_problem(work[i].subprob);
+			mem_free(work[i].subprob);
+			mem_free(work[i].prob->sub_rhs->val);
+			mem_free(work[i].prob->sub_rhs);
+			mem_free(work[i].prob);
+			mem_free(work[i].sd_global->omegas.indices);
+			mem_free(work[i].sd_global);
 		}
-		if (!(count % 10000))
-			printf("\n\nobs:%d mean:%lf   error: %lf \n 0.95 CI: [%lf , %lf]\n",
-					count, cx + mean, 3.92 * stdev / mean,
-					cx + mean - 1.96 * stdev, cx + mean + 1.96 * stdev);
-
-		/* Squash the omega structure back down to nothing */
-		soln->omega->cnt = 0;
-		soln->omega->last = 0;
-		soln->omega->most = 0;
-		soln->omega->next = 0;
-		soln->omega->filter[soln->omega->next] = UNUSED;
-		soln->omega->weight[soln->omega->next] = 0;
-		mem_free(soln->omega->idx[0]);
 	}
+	mem_free(work);
+	mem_free(thread);
+	if (pi_bar)
+		mem_free(pi_bar);
+	pthread_mutex_destroy(&acc.lock);
+
+	count = acc.count;
+	mean = acc.mean;
+	stdev = acc.stdev;
+#ifndef OMEGA_FILE
+	printf("\n%d distinct observations in %d draws", distinct, count);
+#endif
 
 	printf("\n");
 	mean += cx;
@@ -1670,7 +2018,7 @@ void evaluate_inc(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 	}
 
 	fclose(fout);
-	free_soln(prob, cell, soln);
+	free_soln(prob, soln);
 #ifdef TRACE
 	printf("Exiting evaluate_inc\n");
 #endif
@@ -21,6 +21,7 @@
 #define SOLN_H_
 
 #include <time.h>
+#include <pthread.h>
 #include "cell.h"
 #include "sdglobal.h"
 
@@ -75,8 +76,27 @@ typedef struct
 	int **batch_idx;
 	BOOL *used_opt_cut; /* Yifan 03/20/2012 Test for omega issues*/
 	double *RT;
+	mem_pool_type *pool; /* the observation vectors of idx */
 } omega_type;
 
+/**************************************************************************\
+**  The obs_memo_type structure remembers the subproblem value of each
+ ** distinct observation met while evaluating a fixed X, so that a repeated
+ ** observation needs no LP.  It is an open addressing hash table keyed on
+ ** the encoded observation (the _len_ integers of an omega->idx entry):
+ ** _key_ holds a copy of the observation, or NULL in an empty bucket, and
+ ** _val_ the matching subproblem objective.  _size_ (a power of 2) is the
+ ** number of buckets and _cnt_ the number of them in use.
+ \**************************************************************************/
+typedef struct
+{
+	int size;
+	int cnt;
+	int len;
+	int **key;
+	double *val;
+} obs_memo_type;
+
 /**************************************************************************\
 **   The delta matrix contains the values of lambda_pi X Romega and
  ** lambda_pi X Tomega for all values of pi and all observations of omega.  
@@ -90,12 +110,28 @@ typedef struct
  ** from lambda->cnt and omega->cnt.
  **
  **   Note that when elements of omega get dropped, vacant columns appear 
- ** in delta.  This is ok, but be sure to loop carefully!
+ ** in delta.  This is ok, but be sure to loop carefully!  The rows come
+ ** from _row_pool_.  Each row has room for _row_len_ observations, and
+ ** all of them are moved to longer ones (see grow_delta()) as omega->most
+ ** passes it, up to _row_max_.
+ **
+ **   The lambda_pi X Tomega vectors of _vect_size_ bytes of each row come
+ ** from a pool of its own in _tiles_ (_max_rows_ of them), DELTA_CHUNK to
+ ** a block, so one tile holds a run of observations of one dual.  When
+ ** _map_ is set the tiles live in its file, and place_delta() decides
+ ** which of them the system should keep in memory.
  \**************************************************************************/
 typedef struct
 {
 	int *col;
 	pi_R_T_type **val;
+	int row_len;
+	int row_max;
+	mem_pool_type *row_pool;
+	mem_pool_type **tiles;
+	int max_rows;
+	size_t vect_size;
+	mem_map_type *map;
 } delta_type;
 
 /**************************************************************************\
@@ -160,6 +196,7 @@ typedef struct
 	double subobj_est; /*added by Yifan 02/01/12*/
 	vector Master_pi;
 	vector Master_dj;
+	int num_batch; /* replications Batch_pi and Batch_dj have room for */
 	vector *Batch_pi;
 	vector *Batch_dj;
 	vector Batch_pi_mean; /* modified by Yifan 2012.10.05 */
@@ -210,6 +247,9 @@ typedef struct
 	double max_ratio; /*added by Yifan 09/27/2011*/
 	double min_ratio; /*added by Yifan 09/27/2011*/
 	int passed; /* added by zl, 06/30/04. # of replications passed in full test. */
+	int tested; /* # of replications run in the last full test */
+	int full_test_cnt; /* # of full tests performed */
+	int full_test_reps; /* # of replications run over all full tests */
 	double sub_lb_checker; /* addedy by zl, 07/01/04. check the valid lower bound of the subproblem obj function value. */
 	omega_type *omega;
 	delta_type *delta;
@@ -217,15 +257,63 @@ typedef struct
 	delta_type *feasible_delta;
 } soln_type;
 
+/**************************************************************************\
+**  The eval_acc_type structure gathers the running estimate of
+ ** evaluate_inc() from all of its workers.  Each unit is the average of
+ ** _lps_ subproblem values (see eval_unit()); _count_ LPs and _units_
+ ** units are in so far.  _ybar_, _zbar_, _syy_, _szz_ and _syz_ are the
+ ** running means and (co)moments of the unit values y and controls z,
+ ** _z_mean_ the exact mean of the control, and _mean_ and _stdev_ the
+ ** resulting estimate of the recourse and its standard error.  _done_
+ ** is raised once the estimate is tight enough, or a solve has failed.
+ ** Every field but _vr_, _lps_, _z_mean_ and _cx_ is guarded by _lock_.
+ \**************************************************************************/
+typedef struct
+{
+	pthread_mutex_t lock;
+	int vr; /* EVAL_VR in use */
+	int lps;
+	double z_mean;
+	double cx; /* c x X, only for the progress reports */
+	int count;
+	int units;
+	double ybar, zbar, syy, szz, syz;
+	double mean;
+	double stdev;
+	BOOL done;
+	BOOL failed;
+} eval_acc_type;
+
+/* One worker of evaluate_inc(), holding everything it writes to */
+typedef struct
+{
+	sdglobal_type *sd_global; /* own copy, for EVAL_SEED1 and omegas.indices */
+	prob_type *prob; /* own copy, for the sub_rhs work vector */
+	cell_type *cell;
+	one_problem *subprob; /* cell->subprob, or a clone of it */
+	BOOL clone; /* TRUE to solve with solve_clone() instead of solve_subprob() */
+	soln_type *soln;
+	obs_memo_type *memo;
+	vector pi_bar; /* duals of the mean value subproblem (read only) */
+	double *u;
+	int *perm;
+	int lp_cnt; /* LPs solved by solve_clone(), added to cell->LP_cnt */
+	eval_acc_type *acc;
+} eval_work_type;
+
 int *find_rows(int num_elem, int *num_rows, int *omega_row,int *omega_col, int mast_col);
 int *find_cols(int num_elem, int *num_cols, int *omega_col, int mast_col);
 soln_type *new_soln(sdglobal_type* sd_global, prob_type *p, vector x_k);
-void free_soln(prob_type *p, cell_type *c, soln_type *s);
+void free_soln(prob_type *p, soln_type *s);
 void print_soln(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s, char *fname);
 int print_detailed_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p,
 		char *fname, int status);
 int test_average_soln(sdglobal_type* sd_global, soln_type *s, prob_type *p);
+BOOL eval_observ(eval_work_type *w, double *u, double *obj);
+BOOL eval_unit(eval_work_type *w, double *y, double *z);
+BOOL eval_merge(sdglobal_type* sd_global, eval_acc_type *acc, double y, double z);
+void *eval_worker(void *arg);
 void evaluate_inc(sdglobal_type* sd_global, cell_type *cell, prob_type *prob,
 		soln_type *s, vector x_k, char *fname, double *conf_interval,
 		int status);
@@ -237,8 +325,8 @@ void calc_quad_scalar(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s, double candid_est);
 double calc_q_vec(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s, double *q_vec);
-void record_master_dual_and_obj(sdglobal_type* sd_global, prob_type *prob,
-		soln_type *soln, FILE *master_dual, FILE *master_obj);
+void store_master_dual_and_obj(sdglobal_type* sd_global, prob_type *prob,
+		int batch_id, vector pi, vector dj, double opt_value);
 void process_batch_prob(sdglobal_type* sd_global, prob_type *prob,
 		soln_type *soln, double *obj, FILE *batch_dual, FILE *batch_d,
 		FILE *batch_obj);
@@ -43,7 +43,9 @@ int get_colname(one_problem *p, char **name, char *namestore, int storespace,
 int change_objective(one_problem *p, int cnt, int *indices, double *values);
 int solve_lp(one_problem *p);
 void *clone_prob(one_problem *p);
-void change_solver_barrier(one_problem *p);
+BOOL solve_clone(one_problem *p);
+void set_clone_params(BOOL begin);
+void change_qp_method(one_problem *p, int method);
 void change_barrier_algorithm(one_problem *p, int k);
 void change_solver_primal(one_problem *p);
 BOOL setup_problem(one_problem *current);
@@ -62,6 +64,9 @@ BOOL add_row_to_master(one_problem *p, int start, int stop, int *coef_col,
 		double *coef, char sense, double yrhs);
 BOOL add_row_to_batch(one_problem *p, int start, int nzcnt, int *coef_col,
 		double *coef, char sense, double yrhs, int batch_id);
+BOOL add_block_to_batch(one_problem *p, int rcnt, double *rhs, char *sense,
+		char **rname, int ccnt, int nzcnt, double *obj, int *cmatbeg,
+		int *cmatind, double *cmatval, double *lb, double *ub, char **cname);
 BOOL remove_row(one_problem *p, int row_num);
 void write_prob(one_problem *p, char *file_name);
 int get_qp_nzreadlim(void);
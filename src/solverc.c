@@ -299,6 +299,7 @@ BOOL solve_problem(sdglobal_type* sd_global, one_problem *p)
 	vector x;
 #endif
 	int param = 1;
+	int method;
 #ifdef TRACE
 	printf("Inside solve_problem\n");
 #endif
@@ -335,10 +336,22 @@ BOOL solve_problem(sdglobal_type* sd_global, one_problem *p)
 	}
 	else
 	{
-		resolve_master: ans = !CPXbaropt(env, p->lp);
-		/* Set it back to default */
-		CPXsetintparam(env, CPX_PARAM_SCAIND, 0);
-        change_barrier_algorithm(p, 0); /* Change Barrier Algorithm to its default setting*/
+		/* Only the cell master asks for dual simplex (see solve_QP_master()):
+		 it changes by a cut or so between solves, so simplex restarts from
+		 the basis the previous solve left behind.  Every other QP, and a
+		 master simplex does not get through, is solved by barrier with the
+		 scaling retries below. */
+		CPXgetintparam(env, CPX_PARAM_QPMETHOD, &method);
+		ans = FALSE;
+		if (method == ALG_DUAL)
+			ans = !CPXqpopt(env, p->lp);
+		if (!ans || CPXgetstat(env, p->lp) != CPX_STAT_OPTIMAL)
+		{
+			resolve_master: ans = !CPXbaropt(env, p->lp);
+			/* Set it back to default */
+			CPXsetintparam(env, CPX_PARAM_SCAIND, 0);
+			change_barrier_algorithm(p, 0); /* Change Barrier Algorithm to its default setting*/
+		}
 	}
 
 	CPXsetintparam(env, CPX_PARAM_SCRIND, CPX_ON);
@@ -688,17 +701,10 @@ BOOL get_dual(vector Pi, one_problem *p, num_type *num, int length)
 	 */
 	if (strcmp(p->name, "batch_mean") == 0)
 	{
-		/*This part is for original master constraints*/
-		failed = CPXgetpi(env, p->lp, Pi + 1, num->mast_rows * num->batch_id,
-				num->mast_rows * num->batch_id + length - 1);
-		/*This part is for final optimality cuts*/
-		failed = CPXgetpi(
-				env,
-				p->lp,
-				Pi + 1 + length,
-				BATCH_SIZE * num->mast_rows + num->batch_id * num->max_cuts,
-				BATCH_SIZE * num->mast_rows + num->batch_id * num->max_cuts
-						+ num->max_cuts - 1);
+		/* The original master constraints of the replication, followed by
+		 its final optimality cuts */
+		failed = CPXgetpi(env, p->lp, Pi + 1, num->batch_row,
+				num->batch_row + length + num->batch_cuts - 1);
 	}
 	else
 	{
@@ -736,8 +742,8 @@ BOOL get_dual_slacks(vector Dj, one_problem *p, num_type *num, int length)
 
 	if (strcmp(p->name, "batch_mean") == 0)
 	{
-		failed = CPXgetdj(env, p->lp, Dj + 1, num->mast_cols * num->batch_id,
-				num->mast_cols * num->batch_id + length - 1);
+		failed = CPXgetdj(env, p->lp, Dj + 1, num->batch_col,
+				num->batch_col + length - 1);
 	}
 	else
 	{
@@ -822,14 +828,13 @@ int change_bound(one_problem *p, int cnt, int *indices, char *lu, double *bd)
 ** This function will change the constraint, objective, or right hand
  ** side coefficients of a given problem.  The coefficients are specified
  ** in the form of a sparse matrix, whose rows and columns correspond
- ** to the rows and columns in the problem (objective row is -1; rhs
- ** column is -1).  It returns FALSE if one or more of the coefficients
- ** could not be changed; TRUE otherwise.
+ ** to the rows and columns in the problem.  Unlike change_col(), the
+ ** objective row and rhs column may not be addressed here, and the
+ ** elements are stored from position 0.  It returns FALSE if the
+ ** coefficients could not be changed; TRUE otherwise.
  \***********************************************************************/
 BOOL change_coef(one_problem *p, sparse_matrix *coef)
 {
-	int cnt;
-
 #ifdef TRACE
 	printf("Inside change_coef\n");
 #endif
@@ -840,10 +845,11 @@ BOOL change_coef(one_problem *p, sparse_matrix *coef)
 	 return FALSE;
 	 */
 
-	for (cnt = 0; cnt < coef->cnt; cnt++)
-		if (CPXchgcoef(env, p->lp, coef->row[cnt], coef->col[cnt],
-				coef->val[cnt]))
-			return FALSE;
+	/* All the coefficients are passed to the solver in a single call */
+	if (coef->cnt > 0
+			&& CPXchgcoeflist(env, p->lp, coef->cnt, coef->row, coef->col,
+					coef->val))
+		return FALSE;
 
 #ifdef TRACE
 	printf("Exiting change_coef\n");
@@ -1212,6 +1218,38 @@ BOOL add_row_to_batch(one_problem *p, int start, int nzcnt, int *coef_col,
   return (!ans);
 }
 
+/***********************************************************************\
+** This function appends _rcnt_ rows without coefficients, and then
+ ** _ccnt_ columns given column-wise by _cmatbeg_, _cmatind_ and
+ ** _cmatval_, to the batch problem.  It returns TRUE on success.
+ \***********************************************************************/
+BOOL add_block_to_batch(one_problem *p, int rcnt, double *rhs, char *sense,
+		char **rname, int ccnt, int nzcnt, double *obj, int *cmatbeg,
+		int *cmatind, double *cmatval, double *lb, double *ub, char **cname)
+{
+  int ans;
+  int *rmatbeg;
+  int rmatind[1] = { 0 };
+  double rmatval[1] = { 0.0 };
+
+#ifdef TRACE
+  printf("Inside add_block_to_batch\n");
+#endif
+
+  if (!(rmatbeg = arr_alloc(rcnt+1, int)))
+    err_msg("Allocation", "add_block_to_batch", "rmatbeg");
+
+  ans = CPXaddrows(env, p->lp, 0, rcnt, 0, rhs, sense, rmatbeg, rmatind,
+                   rmatval, NULL, rname);
+  if (!ans)
+    ans = CPXaddcols(env, p->lp, ccnt, nzcnt, obj, cmatbeg, cmatind, cmatval,
+                     lb, ub, cname);
+
+  mem_free(rmatbeg);
+
+  return (!ans);
+}
+
 /***********************************************************************\
   Write out the problem in the specified format by the file name. zl
  \***********************************************************************/
@@ -1361,52 +1399,69 @@ void *clone_prob(one_problem *p)
   return lp;
 }
 
+/**********************************************************************************\
+ ** This function solves a clone of the subproblem (see clone_prob()) on a worker
+ ** thread.  Unlike solve_problem(), it does not touch the environment parameters,
+ ** which other threads may be optimizing under at the same time; they are set
+ ** once for all the clones by set_clone_params().  A QP (such as a block of the
+ ** compromise problem, see solve_batch_ph()) is solved by CPXqpopt().  It returns
+ ** TRUE if the clone was solved to optimality.
+ \**********************************************************************************/
+BOOL solve_clone(one_problem *p)
+{
+  int status;
+
+  if (CPXgetprobtype(env, p->lp) == CPXPROB_QP)
+    status = CPXqpopt(env, p->lp);
+  else
+    status = CPXlpopt(env, p->lp);
+  if (status)
+    return FALSE;
+  CPXsolution(env, p->lp, &status, NULL, NULL, NULL, NULL, NULL);
+
+  return status == CPX_STAT_OPTIMAL;
+}
+
+/**********************************************************************************\
+ ** This function sets the environment up for solve_clone() when _begin_ is TRUE,
+ ** with the parameters solve_problem() uses around a subproblem solve, and puts
+ ** back the ones solve_problem() leaves between solves when _begin_ is FALSE.
+ \**********************************************************************************/
+void set_clone_params(BOOL begin)
+{
+  if (begin)
+  {
+    CPXsetintparam(env, CPX_PARAM_SCRIND, CPX_OFF);
+    CPXsetintparam(env, CPX_PARAM_PREIND, CPX_OFF);
+    set_intparam(NULL, PARAM_LPMETHOD, ALG_AUTOMATIC);
+  }
+  else
+  {
+    CPXsetintparam(env, CPX_PARAM_PREIND, CPX_ON);
+    CPXsetintparam(env, CPX_PARAM_SCRIND, CPX_ON);
+  }
+}
+
 /****************************************************************************\
- This function change the CPLEX LP optimization method to barrier.
+ This function change the CPLEX QP optimization method to _method_.  Dual
+ simplex (ALG_DUAL) warm starts from the basis of the previous solve of the
+ same problem; with any other method solve_problem() uses barrier.
  \****************************************************************************/
-void change_solver_barrier(one_problem *p)
+void change_qp_method(one_problem *p, int method)
 {
   int status = 0;
-  
+
 #ifdef TRACE
-  printf("Inside change_solver_barrier.\n");
+  printf("Inside change_qp_method.\n");
 #endif
-  //Change qpmethod to barrier modified by Yifan 06/15/2011
-    /* 
-     0 [CPX_ALG_AUTOMATIC] Automatic: let CPLEX choose
-     1 [CPX_ALG_PRIMAL] Primal Simplex
-     2 [CPX_ALG_DUAL] Dual Simplex
-     3 [CPX_ALG_NET] Network Simplex
-     4 [CPX_ALG_BARRIER] Barrier
-     5 [CPX_ALG_SIFTING] Sifting
-     6 [CPX_ALG_CONCURRENT] Concurrent (Dual, Barrier, and Primal)
-     */
-  status = set_intparam(NULL, PARAM_QPMETHOD, ALG_CONCURRENT); /* 2011.10.30 */
+
+  status = set_intparam(NULL, PARAM_QPMETHOD, method);
   if (status)
   {
     fprintf(stderr, "Failed to set the optimization method, error %d.\n",
             status);
     exit(0);
   }
-  
-  status = 0;
-  
-  /*
-   -1   No crossover
-   0    Automatic: let CPLEX choose; default
-   1    Primal crossover
-   2    Dual crossover
-   */
-  
-  status = set_intparam(NULL, PARAM_BARCROSSALG, 0); /* 2011.10.30 */
-  
-  
-  if (status)
-  {
-    fprintf(stderr, "Failed to set the barcrossover off, error %d.\n",
-            status);
-    exit(0);
-  }
 }
 
 /****************************************************************************\
@@ -399,10 +399,8 @@ BOOL get_dual(vector Pi, one_problem *p, num_type *num, int length)
   /* The _len_ argument should be "length" instead of "length-1" */
   if (strcmp(p->name, "batch_mean") == 0)
   {
-    /*This part is for original master constraints*/
-    failed = (GRBgetdblattrarray((GRBmodel*)p->lp, GRB_DBL_ATTR_PI, num->mast_rows * num->batch_id, length, Pi+1) == 0 ? FALSE : TRUE);
-    /*This part is for final optimality cuts*/
-    failed = (GRBgetdblattrarray((GRBmodel*)p->lp, GRB_DBL_ATTR_PI, BATCH_SIZE * num->mast_rows + num->batch_id * num->max_cuts, num->max_cuts, Pi + 1 + length) == 0 ? FALSE : TRUE);
+    /* The original master constraints of the replication, followed by its final optimality cuts */
+    failed = (GRBgetdblattrarray((GRBmodel*)p->lp, GRB_DBL_ATTR_PI, num->batch_row, length + num->batch_cuts, Pi+1) == 0 ? FALSE : TRUE);
   }
   else
   {
@@ -431,7 +429,7 @@ BOOL get_dual_slacks(vector Dj, one_problem *p, num_type *num, int length)
 
   if (strcmp(p->name, "batch_mean") == 0)
   {
-    failed = (GRBgetdblattrarray((GRBmodel*)p->lp, GRB_DBL_ATTR_RC, num->mast_cols * num->batch_id, length, Dj+1) == 0 ? FALSE : TRUE);
+    failed = (GRBgetdblattrarray((GRBmodel*)p->lp, GRB_DBL_ATTR_RC, num->batch_col, length, Dj+1) == 0 ? FALSE : TRUE);
   }
   else
   {
@@ -884,6 +882,31 @@ BOOL add_row_to_batch(one_problem *p, int start, int nzcnt, int *coef_col,
 
 
 
+/***********************************************************************\
+** This function appends _rcnt_ rows without coefficients, and then
+ ** _ccnt_ columns given column-wise by _cmatbeg_, _cmatind_ and
+ ** _cmatval_, to the batch problem.  It returns TRUE on success.
+ \***********************************************************************/
+BOOL add_block_to_batch(one_problem *p, int rcnt, double *rhs, char *sense,
+		char **rname, int ccnt, int nzcnt, double *obj, int *cmatbeg,
+		int *cmatind, double *cmatval, double *lb, double *ub, char **cname)
+{
+  int ans;
+  int *rmatbeg;
+
+  if (!(rmatbeg = arr_alloc(rcnt+1, int)))
+    err_msg("Allocation", "add_block_to_batch", "rmatbeg");
+
+  ans = GRBaddconstrs((GRBmodel*)p->lp, rcnt, 0, rmatbeg, NULL, NULL, sense, rhs, rname);
+  if (!ans)
+    ans = GRBaddvars((GRBmodel*)p->lp, ccnt, nzcnt, cmatbeg, cmatind, cmatval, obj, lb, ub, NULL, cname);
+  GRBupdatemodel((GRBmodel*)p->lp);
+
+  mem_free(rmatbeg);
+
+  return (!ans);
+}
+
 /***********************************************************************\
  Write out the problem in the specified format by the file name. zl
  \***********************************************************************/
@@ -1027,57 +1050,50 @@ void *clone_prob(one_problem *p)
 }
 
 
+/**********************************************************************************\
+ ** This function solves a copy of the subproblem (see clone_prob()) on a worker
+ ** thread, returning TRUE if it was solved to optimality; it may be an LP or a
+ ** QP (see solve_batch_ph()).  Gurobi parameters
+ ** belong to the model, so the copy carries its own and nothing is shared.
+ \**********************************************************************************/
+BOOL solve_clone(one_problem *p)
+{
+  int status;
+
+  GRBupdatemodel((GRBmodel*)p->lp);
+  if (GRBoptimize((GRBmodel*)p->lp))
+    return FALSE;
+  GRBgetintattr((GRBmodel*)p->lp, GRB_INT_ATTR_STATUS, &status);
+
+  return status == GRB_OPTIMAL;
+}
+
+/**********************************************************************************\
+ ** Nothing to do for Gurobi: each copy made by clone_prob() has its own parameters.
+ \**********************************************************************************/
+void set_clone_params(BOOL begin)
+{
+}
+
 /****************************************************************************\
- This function change the CPLEX LP optimization method to barrier. 
+ This function change the GUROBI QP optimization method to _method_.  Dual
+ simplex (ALG_DUAL) warm starts from the basis of the previous solve of the
+ same model.
  \****************************************************************************/
-void change_solver_barrier(one_problem *p)
+void change_qp_method(one_problem *p, int method)
 {
   int status = 0;
-  
+
 #ifdef TRACE
-  printf("Inside change_solver_barrier.\n");
+  printf("Inside change_qp_method.\n");
 #endif
 
-  
-  //Change qpmethod to barrier modified by Yifan 06/15/2011 
-  /*
-   -1 = automatic, 
-   0  = primal simplex, 
-   1  = dual simplex, 
-   2  = barrier, 
-   3  = concurrent, 
-   4  = deterministic concurrent
-   */
-  status = set_intparam (p, PARAM_QPMETHOD, 2); /* 2011.10.30 */
+  status = set_intparam (p, PARAM_QPMETHOD, method);
   if (status) {
     fprintf (stderr, 
              "Failed to set the optimization method, error %d.\n", status);
     exit(0); 
   }
-  
-  status = 0;
-  
-  /*status = set_intparam(p, GRB_INT_PAR_CROSSOVERBASIS, 0);*/
-  /*
-   Automatic (-1)                         GUROBI decides.
-   Disable, use interior solution (0)     No crossover performed.
-   Dual first,finish with primal (1)      Pushes dual variables first then primal, finishes with primal.
-   Dual first, finsih with dual (2)       Pushes dual variables first then primal, finishes with dual.
-   Primal first, finish with primal (3)   Pushes primal variables first then dual, finishes with primal.
-   Primal first, finsih with dual (4)     Pushes primal variables first then dual, finishes with dual.
-   */
-  status = set_intparam (p, PARAM_BARCROSSALG, -1); /* 2011.10.30 */
-  
-  /* 0: choose initial basis quickly but unstable
-     1: take longer time but return a stable basis
-   */
-  status = set_intparam (p, PARAM_CROSSOVERBASIS, 1); /* 2011.10.30 */
-  
-  if (status) {
-    fprintf (stderr, 
-             "Failed to set the barcrossover off, error %d.\n", status);
-    exit(0); 
-  }
 }
 
 /****************************************************************************\
@@ -8,6 +8,11 @@
  **
  ** solve_subprob()
  ** compute_rhs()
+ ** compute_sub_rhs()
+ ** fill_sub_rhs()
+ ** pi_x_sub_rhs()
+ ** new_sub_rhs()
+ ** free_sub_rhs()
  **
  ** History:
  **   20 Jan 1992 - <Jason Mai> - created.
@@ -38,12 +43,13 @@
  ** variables from the master problem.  Generally, the latest observation
  ** is used.  When forming a normal cut, the candidate x should be used, while
  ** the incumbent x should be used for updating the incumbent cut.
+ ** Only the rows listed in p->sub_rhs are sent to the solver; all other
+ ** rows of the subproblem never change from their Rbar values.
  \***********************************************************************/
 /* */
 int solve_subprob(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 		soln_type *s, vector Xvect, int omeg_idx)
 {
-	vector rhs;
 	BOOL ans;
 	clock_t start, end; /* Recording solution time for solving
 	 subproblem LPs. added by zl, 06/29/04. */
@@ -59,15 +65,22 @@ int solve_subprob(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	printf("Inside solve_subprob\n");
 #endif
 
-	rhs = compute_rhs(sd_global, p->num, p->Rbar, p->Tbar, Xvect, s->omega, omeg_idx);
-	if (!change_col(c->subprob, RHS_COL, rhs + 1, 0, p->num->sub_rows))
+	compute_sub_rhs(sd_global, p, Xvect, s->omega, omeg_idx);
+	if (change_rhside(c->subprob, p->sub_rhs->cnt, p->sub_rhs->row,
+			p->sub_rhs->val))
 	{
 		print_contents(c->subprob, "contents.out");
-		err_msg("change_col", "solve_subprob", "returned FALSE");
+		err_msg("change_rhside", "solve_subprob", "returned error");
 	}
 
 #ifdef DEBUG
-	print_vect(rhs, p->num->sub_rows, "Rhs");
+	{
+		int cnt;
+		printf("Rhs:\n");
+		for (cnt = 0; cnt < p->sub_rhs->cnt; cnt++)
+			printf("  row %d : %f\n", p->sub_rhs->row[cnt] + 1,
+					p->sub_rhs->val[cnt]);
+	}
 #endif
 
 #ifdef SAVE
@@ -77,13 +90,12 @@ int solve_subprob(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 	++fnum;
 	print_problem(c->subprob, fname);
 	printf("Saving file: %s\n", fname);
+	write_prob(c->subprob, "subprob.lp");
 #endif
 
-	mem_free(rhs);
 	/* Recording the time for solving subproblem LPs. zl, 06/29/04. */
 	start = clock();
 	c->subprob->feaflag = TRUE; /*added by Yifan to generate feasibility cut 08/11/2011*/
-	write_prob(c->subprob, "subprob.lp");
 	ans = solve_problem(sd_global, c->subprob);
 	end = clock();
 	s->run_time->soln_subprob_iter += ((double) (end - start)) / CLOCKS_PER_SEC;
@@ -170,6 +182,156 @@ vector compute_rhs(sdglobal_type* sd_global, num_type *num, sparse_vect *Rbar,
 	return rhs;
 }
 
+/***********************************************************************\
+** This function is the incremental version of compute_rhs().  Rather
+ ** than building the whole right hand side, it only fills the rows
+ ** listed in p->sub_rhs, starting from their cached Rbar values:
+ **	val = fixed + Romega - Tbar x X - Tomega x X
+ **
+ ** The result is left in p->sub_rhs->val, aligned with p->sub_rhs->row,
+ ** ready to be passed to change_rhside().  Nothing is allocated.
+ \***********************************************************************/
+void compute_sub_rhs(sdglobal_type* sd_global, prob_type *p, vector X,
+		omega_type *omega, int omeg_idx)
+{
+#ifdef TRACE
+	printf("Inside compute_sub_rhs\n");
+#endif
+
+	get_R_T_omega(sd_global, omega, omeg_idx);
+	fill_sub_rhs(p, X, omega);
+
+#ifdef TRACE
+	printf("Exiting compute_sub_rhs\n");
+#endif
+}
+
+/***********************************************************************\
+** This function does the arithmetic of compute_sub_rhs() for whatever
+ ** values are currently loaded in omega->RT, so that a caller may set
+ ** RT itself (e.g. to the expected deviations) without an observation.
+ \***********************************************************************/
+void fill_sub_rhs(prob_type *p, vector X, omega_type *omega)
+{
+	sub_rhs_type *rhs = p->sub_rhs;
+	sparse_matrix *Tbar = p->Tbar;
+	sparse_vect Romega;
+	sparse_matrix Tomega;
+	int cnt;
+
+	init_R_T_omega(&Romega, &Tomega, omega, p->num);
+
+	for (cnt = 0; cnt < rhs->cnt; cnt++)
+		rhs->val[cnt] = rhs->fixed[cnt];
+
+	for (cnt = 1; cnt <= Romega.cnt; cnt++)
+		rhs->val[rhs->pos[Romega.row[cnt]]] += Romega.val[cnt];
+
+	/* Same as TxX(), but indexed through the row positions */
+	for (cnt = 1; cnt <= Tbar->cnt; cnt++)
+		rhs->val[rhs->pos[Tbar->row[cnt]]] -= Tbar->val[cnt] * X[Tbar->col[cnt]];
+	for (cnt = 1; cnt <= Tomega.cnt; cnt++)
+		rhs->val[rhs->pos[Tomega.row[cnt]]] -= Tomega.val[cnt]
+				* X[Tomega.col[cnt]];
+}
+
+/***********************************************************************\
+** This function returns pi x r over the rows listed in p->sub_rhs,
+ ** where r is the right hand side last filled by fill_sub_rhs().  Pi
+ ** is 1-indexed, as returned by get_dual().
+ \***********************************************************************/
+double pi_x_sub_rhs(prob_type *p, vector Pi)
+{
+	double sum = 0.0;
+	int cnt;
+
+	for (cnt = 0; cnt < p->sub_rhs->cnt; cnt++)
+		sum += Pi[p->sub_rhs->row[cnt] + 1] * p->sub_rhs->val[cnt];
+
+	return sum;
+}
+
+/***********************************************************************\
+** This function finds the rows of the subproblem whose right hand side
+ ** depends on X or omega: those holding an element of Tbar, or a random
+ ** element of R or T.  It records them in increasing order, together
+ ** with their Rbar values, so that solve_subprob() only needs to send
+ ** these rows to the solver.  It must be called after the coord
+ ** structure has been initialized.
+ \***********************************************************************/
+sub_rhs_type *new_sub_rhs(prob_type *p)
+{
+	sub_rhs_type *rhs;
+	int *omega_row;
+	int cnt, r;
+
+#ifdef TRACE
+	printf("Inside new_sub_rhs\n");
+#endif
+
+	if (!(rhs = (sub_rhs_type *) mem_malloc (sizeof(sub_rhs_type))))
+		err_msg("Allocation", "new_sub_rhs", "rhs");
+	if (!(rhs->pos = arr_alloc(p->num->sub_rows+1, int)))
+		err_msg("Allocation", "new_sub_rhs", "rhs->pos");
+
+	/* Mark every row which may vary (arr_alloc has zeroed the array) */
+	for (cnt = 1; cnt <= p->Tbar->cnt; cnt++)
+		rhs->pos[p->Tbar->row[cnt]] = 1;
+
+	/* As in init_R_T_omega(), the rows of R(omega) come before those of T(omega) */
+	omega_row = p->coord->omega_row;
+	for (cnt = 1; cnt <= p->num->rv_R + p->num->rv_T; cnt++)
+		if (omega_row[cnt] > 0 && omega_row[cnt] <= p->num->sub_rows)
+			rhs->pos[omega_row[cnt]] = 1;
+
+	rhs->cnt = 0;
+	for (r = 1; r <= p->num->sub_rows; r++)
+		if (rhs->pos[r])
+			++rhs->cnt;
+
+	if (!(rhs->row = arr_alloc(rhs->cnt+1, int)))
+		err_msg("Allocation", "new_sub_rhs", "rhs->row");
+	if (!(rhs->fixed = arr_alloc(rhs->cnt+1, double)))
+		err_msg("Allocation", "new_sub_rhs", "rhs->fixed");
+	if (!(rhs->val = arr_alloc(rhs->cnt+1, double)))
+		err_msg("Allocation", "new_sub_rhs", "rhs->val");
+
+	/* Assign positions in increasing row order; fixed rows get -1 */
+	cnt = 0;
+	rhs->pos[0] = -1;
+	for (r = 1; r <= p->num->sub_rows; r++)
+		if (rhs->pos[r])
+		{
+			rhs->row[cnt] = r - 1;
+			rhs->pos[r] = cnt++;
+		}
+		else
+			rhs->pos[r] = -1;
+
+	for (cnt = 1; cnt <= p->Rbar->cnt; cnt++)
+		if ((r = rhs->pos[p->Rbar->row[cnt]]) >= 0)
+			rhs->fixed[r] += p->Rbar->val[cnt];
+
+#ifdef TRACE
+	printf("Exiting new_sub_rhs: %d of %d rows vary\n", rhs->cnt,
+			p->num->sub_rows);
+#endif
+
+	return rhs;
+}
+
+/***********************************************************************\
+** This function frees the cached subproblem rhs structure.
+ \***********************************************************************/
+void free_sub_rhs(sub_rhs_type *rhs)
+{
+	mem_free(rhs->row);
+	mem_free(rhs->pos);
+	mem_free(rhs->fixed);
+	mem_free(rhs->val);
+	mem_free(rhs);
+}
+
 /***********************************************************************\
 ** Once every cell needs its own copy of the subproblem, this function
  ** will be called from solve_cell to make a duplicate of the pristine
@@ -14,6 +14,12 @@ int solve_subprob(sdglobal_type* sd_global, prob_type *p, cell_type *c,
 one_problem *new_subprob(one_problem *subprob);
 vector compute_rhs(sdglobal_type* sd_global, num_type *num, sparse_vect *Rbar, sparse_matrix *Tbar,
 		vector X, omega_type *omega, int omeg_idx);
+void compute_sub_rhs(sdglobal_type* sd_global, prob_type *p, vector X,
+		omega_type *omega, int omeg_idx);
+void fill_sub_rhs(prob_type *p, vector X, omega_type *omega);
+double pi_x_sub_rhs(prob_type *p, vector Pi);
+sub_rhs_type *new_sub_rhs(prob_type *p);
+void free_sub_rhs(sub_rhs_type *rhs);
 void free_subprob(one_problem *subprob);
 
 #endif /* SUBPROB_H_ */
@@ -81,6 +81,79 @@ sd_small get_omega_idx(sdglobal_type* sd_global, sd_small *observ, sd_small *mem
 	return sum; /* This is the 1-norm of the uncoded indices */
 }
 
+/****************************************************************\
+**  The function omega_u_dim() returns the number of uniforms
+ **  consumed by one observation: one per random variable for
+ **  independent distributions, and one for a block distribution.
+ \****************************************************************/
+int omega_u_dim(sdglobal_type* sd_global)
+{
+	if (strcmp(sd_global->omegas.type, "INDEP") == 0)
+		return sd_global->omegas.num_omega;
+	return 1;
+}
+
+/****************************************************************\
+**  The function omega_idx_from_u() is the same as get_omega_idx(),
+ **  except that the uniforms are supplied by the caller in u[],
+ **  omega_u_dim() of them, instead of being drawn from a seed.  This
+ **  lets the evaluation place its draws (antithetic pairs, Latin
+ **  hypercube strata) rather than take them independently.
+ \****************************************************************/
+sd_small omega_idx_from_u(sdglobal_type* sd_global, sd_small *observ, double *u)
+{
+	sd_small i, j, last;
+	sd_small sum = 0;
+
+	if (strcmp(sd_global->omegas.type, "INDEP") == 0) {
+		for (i = 0; i < sd_global->omegas.num_omega; i++)
+		{
+			last = sd_global->omegas.num_vals[i] - 1;
+			for (j = 0; j < last && u[i] > sd_global->omegas.omega_probs[i][j]; j++)
+			/* loop until value falls below the cdf at j */;
+			sd_global->omegas.indices[i] = j;
+			sum += j;
+		}
+		encode(sd_global->omegas.indices, sd_global->omegas.key, observ,
+				sd_global->omegas.num_omega);
+	}
+	else{
+		last = sd_global->omegas.num_vals[0] - 1;
+		for (j = 0; j < last && u[0] > sd_global->omegas.omega_probs[0][j]; j++)
+		/* loop until value falls below the cdf at j */;
+		sd_global->omegas.indices[0] = j;
+		sum = j;
+	}
+
+	return sum;
+}
+
+/****************************************************************\
+**  The function omega_expect() loads RT with the expected value of
+ **  each stochastic element, as a deviation from the mean recorded
+ **  in omegas.mean (the same scale get_omega_vals() uses).  It is
+ **  computed exactly from the discrete distribution.
+ \****************************************************************/
+void omega_expect(sdglobal_type* sd_global, double *RT)
+{
+	int i, j, d;
+	double prev;
+
+	for (i = 0; i < sd_global->omegas.num_omega; i++)
+	{
+		d = strcmp(sd_global->omegas.type, "INDEP") == 0 ? i : 0;
+		RT[i] = 0.0;
+		prev = 0.0;
+		for (j = 0; j < sd_global->omegas.num_vals[d]; j++)
+		{
+			RT[i] += (sd_global->omegas.omega_probs[d][j] - prev)
+					* sd_global->omegas.omega_vals[i][j];
+			prev = sd_global->omegas.omega_probs[d][j];
+		}
+		RT[i] -= sd_global->omegas.mean[i];
+	}
+}
+
 /****************************************************************\
 **  The function get_omega_vals() receives an array of indices
  **  to values in omegas and loads the array RT with the 
@@ -34,6 +34,17 @@
 sd_small get_omega_idx(sdglobal_type* sd_global, sd_small *observ, sd_small *members,
 		sd_small num_members, sd_long *RUN_SEED);
 
+/**************************************************************************\
+**  omega_idx_from_u() does the work of get_omega_idx() from the
+ ** omega_u_dim() uniforms given in u, so that the caller controls
+ ** where the draws fall.  omega_expect() loads RT with the expected
+ ** deviation of each stochastic element from its mean value.
+ \**************************************************************************/
+
+int omega_u_dim(sdglobal_type* sd_global);
+sd_small omega_idx_from_u(sdglobal_type* sd_global, sd_small *observ, double *u);
+void omega_expect(sdglobal_type* sd_global, double *RT);
+
 /**************************************************************************\
 **  The function get_omega_vals() receives an array of indices
  ** to values in omegas and loads the array RT with the
@@ -178,16 +178,25 @@ double get_max_Vi(sdglobal_type* sd_global, vector x, cut_type *cuts,
 double cut_height(sdglobal_type* sd_global, one_cut *cut, vector X,
 		cell_type *c, num_type *num)
 {
-	double height;
-	double t_over_k = ((double) cut->cut_obs / (double) c->k);
-
 #ifdef LOOP
 	printf("Inside cut_height\n");
 #endif
 
+	return cut_height_bx(sd_global, cut, CxX(cut->beta, X, num->mast_cols), c);
+}
+
+/************************************************************************\
+** Same as cut_height(), for a cut whose product Beta x X is already
+ ** known, e.g. from the cell's cached beta x X vector.
+ \***********************************************************************/
+double cut_height_bx(sdglobal_type* sd_global, one_cut *cut, double bx,
+		cell_type *c)
+{
+	double height;
+	double t_over_k = ((double) cut->cut_obs / (double) c->k);
+
 	/* A cut is calculated as Alpha - Beta x X */
-	height = cut->alpha;
-	height -= CxX(cut->beta, X, num->mast_cols);
+	height = cut->alpha - bx;
 
 	/* Weight cut based on number of observations used to form it */
 	height *= t_over_k;
@@ -14,6 +14,8 @@
 
 double c_k(sdglobal_type* sd_global, vector Cost, vector X, cell_type *c,
 		num_type *num, int idx);
+double cut_height_bx(sdglobal_type* sd_global, one_cut *cut, double bx,
+		cell_type *c);
 double cut_height(sdglobal_type* sd_global, one_cut *cut, vector X,
 		cell_type *c, num_type *num);
 double f_k(sdglobal_type* sd_global, vector x, vector cost, cut_type *cuts,
@@ -7,6 +7,7 @@
  **
  ** one_norm()
  ** equal_arr()
+ ** equal_coef()
  ** expand_vect()
  ** reduce_vect()
  ** print_vect()
@@ -76,6 +77,20 @@ BOOL equal_arr(double *a, double *b, int len, double tolerance)
 	return TRUE;
 }
 
+/*
+ ** Same as equal_arr(), for two vectors of sigma or delta coefficients.
+ */
+BOOL equal_coef(coef_type *a, coef_type *b, int len, double tolerance)
+{
+	int cnt;
+
+	for (cnt = 0; cnt <= len; cnt++)
+		if (DBL_ABS(a[cnt] - b[cnt]) > DBL_ABS(tolerance * a[cnt]))
+			return FALSE;
+
+	return TRUE;
+}
+
 /*
  ** Are functions passing in len or len+1 ???
  */
@@ -126,12 +141,23 @@ double *duplic_arr(double *a, int len)
  */
 vector expand_vect(double *s_vect, int *row, int num_elem, int length)
 {
-	int cnt;
 	vector new_vect;
 
 	if (!(new_vect = arr_alloc(length+1, double)))
 		err_msg("Allocation", "expand_vect", "new_vect");
 
+	return expand_vect_to(new_vect, s_vect, row, num_elem, length);
+}
+
+/*
+ ** Same as expand_vect(), but into _new_vect_ (length+1 entries), which
+ ** is returned.
+ */
+vector expand_vect_to(vector new_vect, double *s_vect, int *row, int num_elem,
+		int length)
+{
+	int cnt;
+
 	for (cnt = 0; cnt <= length; cnt++)
 		new_vect[cnt] = 0;
 
@@ -153,12 +179,22 @@ vector expand_vect(double *s_vect, int *row, int num_elem, int length)
  */
 double *reduce_vect(double *f_vect, int *row, int num_elem)
 {
-	int cnt;
 	double *s_vect;
 
 	if (!(s_vect = arr_alloc(num_elem+1, double)))
 		err_msg("Allocation", "reduce_vect", "s_vect");
 
+	return reduce_vect_to(s_vect, f_vect, row, num_elem);
+}
+
+/*
+ ** Same as reduce_vect(), but into _s_vect_ (num_elem+1 entries), which
+ ** is returned.
+ */
+double *reduce_vect_to(double *s_vect, double *f_vect, int *row, int num_elem)
+{
+	int cnt;
+
 	for (cnt = 1; cnt <= num_elem; cnt++)
 		s_vect[cnt] = f_vect[row[cnt]];
 	s_vect[0] = one_norm(s_vect + 1, num_elem);
@@ -166,6 +202,41 @@ double *reduce_vect(double *f_vect, int *row, int num_elem)
 	return s_vect;
 }
 
+/*
+ ** Same as reduce_vect_to(), but into a vector of sigma or delta
+ ** coefficients, which may be narrower than _f_vect_.
+ */
+coef_type *reduce_vect_coef(coef_type *s_vect, double *f_vect, int *row,
+		int num_elem)
+{
+	double norm = 0.0;
+	int cnt;
+
+	for (cnt = 1; cnt <= num_elem; cnt++)
+	{
+		s_vect[cnt] = (coef_type) f_vect[row[cnt]];
+		norm += DBL_ABS(f_vect[row[cnt]]);
+	}
+	s_vect[0] = (coef_type) norm;
+
+	return s_vect;
+}
+
+/*
+ ** This function copies the vector _f_vect_ (num_elem+1 entries, 1-norm
+ ** included) into a vector of sigma or delta coefficients, _s_vect_,
+ ** which is returned.
+ */
+coef_type *copy_vect_coef(coef_type *s_vect, double *f_vect, int num_elem)
+{
+	int cnt;
+
+	for (cnt = 0; cnt <= num_elem; cnt++)
+		s_vect[cnt] = (coef_type) f_vect[cnt];
+
+	return s_vect;
+}
+
 /* CALLER: DONT FORGET TO FREE THE ORIGINAL FULL VECTOR !! !! !! !! */
 
 void print_num(sdglobal_type* sd_global, num_type *num)
@@ -269,13 +340,21 @@ double PIxR(vector pi_k, sparse_vect *R)
  */
 vector PIxT(vector pi_k, sparse_matrix *T, int length)
 {
-	int cnt;
 	vector pi_T;
 
 	if (!(pi_T = arr_alloc(length+1, double)))
 		err_msg("Allocation", "PIxT", "pi_T");
-    
-    
+
+	return PIxT_to(pi_T, pi_k, T, length);
+}
+
+/*
+ ** Same as PIxT(), but into _pi_T_ (length+1 entries), which is returned.
+ */
+vector PIxT_to(vector pi_T, vector pi_k, sparse_matrix *T, int length)
+{
+	int cnt;
+
 //#pragma omp parallel for private(cnt, a) num_threads(2)
 //    for (cnt = 0; cnt <= length; cnt++){
 //        a[cnt] = 0;
@@ -646,6 +725,25 @@ double calc_var(sdglobal_type* sd_global, double *x, double *mean_value,
 
 }
 
+/*
+ ** This function returns the two-sided 95% quantile of Student's t
+ ** distribution with _dof_ degrees of freedom, which tends to 1.96.
+ */
+double t_quantile_95(int dof)
+{
+	static const double t[30] =
+	{ 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+			2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048,
+			2.045, 2.042 };
+
+	if (dof < 1)
+		return t[0];
+	if (dof <= 30)
+		return t[dof - 1];
+	return 1.96 + 2.4 / dof;
+}
+
 void calc_mean_stdev(vector *x, vector mean_value, vector stdev_value,
 		int num_element, int batch_size)
 {
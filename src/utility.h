@@ -12,10 +12,16 @@
 BOOL decode(int *cipher, one_key *key, int *plain, int len);
 BOOL encode(int *plain, one_key *key, int *cipher, int len);
 BOOL equal_arr(double *a, double *b, int len, double tolerance);
+BOOL equal_coef(coef_type *a, coef_type *b, int len, double tolerance);
 double *duplic_arr(double *a, int len);
 double *reduce_vect(double *f_vect, int *row, int num_elem);
+double *reduce_vect_to(double *s_vect, double *f_vect, int *row, int num_elem);
+coef_type *copy_vect_coef(coef_type *s_vect, double *f_vect, int num_elem);
+coef_type *reduce_vect_coef(coef_type *s_vect, double *f_vect, int *row,
+		int num_elem);
 double calc_var(sdglobal_type* sd_global, double *x, double *mean_value,
 		double *stdev_value, int batch_size);
+double t_quantile_95(int dof);
 double compute_Mu(one_problem *p, int sub_cols);
 double CxX(vector c, vector x, int len);
 double MuxR(one_problem *p, int sub_cols, vector dj);
@@ -24,7 +30,10 @@ double PIxR(vector pi_k, sparse_vect *R);
 int form_key(one_key *key, int *ranges, int num_ranges);
 int get_num_bits(int num);
 vector expand_vect(double *s_vect, int *row, int num_elem, int length);
+vector expand_vect_to(vector new_vect, double *s_vect, int *row, int num_elem,
+		int length);
 vector PIxT(vector pi_k, sparse_matrix *T, int length);
+vector PIxT_to(vector pi_T, vector pi_k, sparse_matrix *T, int length);
 vector TxX_plus(sparse_matrix *T, vector X, vector ans);
 vector TxX(sparse_matrix *T, vector X, vector ans);
 void calc_mean_stdev(vector *x, vector mean_value, vector stdev_value,